@@ -0,0 +1,88 @@
+#include <Physics/Benchmark.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+// runs the physics benchmark scenes without the editor, so the numbers can be reproduced from a terminal or ci
+// the logger is compiled out on release, where the benchmarks are meant to run, results are printed as csv instead
+static const char* sUsage = "usage: Benchmark [pyramid|pile|ragdolls|sleeping]... [--frames N] [--size N] [--threads N], no scene runs all of them\n";
+
+int main(int argc, char* argv[])
+{
+	using namespace Cosmos::Physics;
+
+	// command line names of the scenes, in the same order as the enumeration
+	const char* names[Benchmark::SceneMax] = { "pyramid", "pile", "ragdolls", "sleeping" };
+
+	Benchmark::Specification base = {};
+	std::vector<Benchmark::Scene> scenes = {};
+
+	for (int i = 1; i < argc; i++)
+	{
+		const bool hasValue = i + 1 < argc;
+
+		if (strcmp(argv[i], "--frames") == 0 && hasValue) base.frames = (uint32_t)atoi(argv[++i]);
+		else if (strcmp(argv[i], "--size") == 0 && hasValue) base.size = (uint32_t)atoi(argv[++i]);
+		else if (strcmp(argv[i], "--threads") == 0 && hasValue) base.world.jobThreads = (uint32_t)atoi(argv[++i]);
+
+		else
+		{
+			bool found = false;
+
+			for (uint32_t scene = 0; scene < Benchmark::SceneMax; scene++)
+			{
+				if (strcmp(argv[i], names[scene]) == 0)
+				{
+					scenes.push_back((Benchmark::Scene)scene);
+					found = true;
+				}
+			}
+
+			if (!found)
+			{
+				fprintf(stderr, "unknown argument %s\n%s", argv[i], sUsage);
+				return 2;
+			}
+		}
+	}
+
+	if (scenes.empty())
+	{
+		for (uint32_t scene = 0; scene < Benchmark::SceneMax; scene++)
+		{
+			scenes.push_back((Benchmark::Scene)scene);
+		}
+	}
+
+	printf("scene,bodies,frames,threads,build_ms,step_min_ms,step_avg_ms,step_p50_ms,step_p95_ms,step_p99_ms,step_max_ms,contacts_avg,contacts_peak,temp_peak_bytes,state_bytes,overflows\n");
+
+	// a scene that overflowed it's world was not measured as intended, it fails the run
+	int result = 0;
+
+	for (Benchmark::Scene scene : scenes)
+	{
+		Benchmark::Specification specification = base;
+		specification.scene = scene;
+
+		Benchmark::Report report = Benchmark::Run(specification);
+		const PhysicsWorld::Statistics& statistics = report.statistics;
+		uint32_t overflows = statistics.bodyOverflows + statistics.bodyPairOverflows + statistics.contactOverflows + statistics.manifoldOverflows;
+
+		printf
+		(
+			"%s,%u,%u,%u,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.1f,%u,%zu,%zu,%u\n",
+			names[scene], report.bodies, report.frames, report.jobThreads, report.buildTime,
+			report.stepMin, report.stepAverage, report.stepP50, report.stepP95, report.stepP99, report.stepMax,
+			report.contactsAverage, report.contactsPeak, statistics.tempAllocatorPeak, report.stateSize, overflows
+		);
+
+		if (overflows > 0)
+		{
+			result = 1;
+		}
+	}
+
+	return result;
+}
\ No newline at end of file
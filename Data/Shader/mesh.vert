@@ -1,12 +1,6 @@
 #version 450
 #extension GL_KHR_vulkan_glsl : enable
 
-layout(push_constant) uniform constants
-{
-    uint id;
-	mat4 model;
-} pushConstant;
-
 layout(set = 0, binding = 0) uniform ubo_camera
 {
     mat4 view;
@@ -15,18 +9,41 @@ layout(set = 0, binding = 0) uniform ubo_camera
     vec3 cameraFront;
 } camera;
 
+// entities sharing a mesh are drawn by a single call, gl_InstanceIndex already accounts the first instance
+struct InstanceData
+{
+    mat4 model;
+    uint id;
+    uint palette;
+    float frame;
+};
+
+layout(std430, set = 0, binding = 4) readonly buffer sbo_instances
+{
+    InstanceData instances[];
+};
+
+// instances left by the culling pass, the draws only instance the visible ones
+layout(std430, set = 0, binding = 5) readonly buffer sbo_visible
+{
+    uint visible[];
+};
+
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inNormal;
 layout(location = 2) in vec2 inTexCoord;
 
 layout(location = 0) out vec3 outFragColor;
 layout(location = 1) out vec2 outFragTexCoord;
+layout(location = 2) flat out uint outFragID;
 
 void main()
 {
     // set vertex position on world
-    gl_Position = camera.proj * camera.view * pushConstant.model * vec4(inPosition, 1.0);
+    InstanceData instance = instances[visible[gl_InstanceIndex]];
+    gl_Position = camera.proj * camera.view * instance.model * vec4(inPosition, 1.0);
 
     // output variables for the fragment shader
     outFragTexCoord = inTexCoord;
+    outFragID = instance.id;
 }
\ No newline at end of file
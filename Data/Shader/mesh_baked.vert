@@ -0,0 +1,93 @@
+#version 450
+#extension GL_KHR_vulkan_glsl : enable
+
+layout(set = 0, binding = 0) uniform ubo_camera
+{
+    mat4 view;
+    mat4 proj;
+    mat4 viewProj;
+    vec3 cameraFront;
+} camera;
+
+// entities sharing a mesh are drawn by a single call, gl_InstanceIndex already accounts the first instance
+struct InstanceData
+{
+    mat4 model;
+    uint id;
+    uint palette;
+    float frame;
+};
+
+layout(std430, set = 0, binding = 4) readonly buffer sbo_instances
+{
+    InstanceData instances[];
+};
+
+// instances left by the culling pass, the draws only instance the visible ones
+layout(std430, set = 0, binding = 5) readonly buffer sbo_visible
+{
+    uint visible[];
+};
+
+// baked joint palettes, a row per frame and three texels per joint holding the first three rows of it's matrix
+layout(set = 0, binding = 7) uniform sampler2D animationTexture;
+
+// skinned vertex layout, the uv arrives already expanded from half-floats and the weights normalized
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec2 inNormal; // octahedral encoded
+layout(location = 2) in vec2 inTexCoord;
+layout(location = 3) in uvec4 inJoint;
+layout(location = 4) in vec4 inWeight;
+
+layout(location = 0) out vec3 outFragColor;
+layout(location = 1) out vec2 outFragTexCoord;
+layout(location = 2) flat out uint outFragID;
+
+// unfolds an octahedral encoded normal, must match the encoding done by the engine
+vec3 DecodeOctahedral(vec2 encoded)
+{
+    vec3 normal = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    float fold = max(-normal.z, 0.0);
+    normal.x += normal.x >= 0.0 ? -fold : fold;
+    normal.y += normal.y >= 0.0 ? -fold : fold;
+    return normalize(normal);
+}
+
+// returns a joint's matrix on a frame row, the texels are it's rows so the result is transposed back
+mat4 FetchJoint(uint joint, int row)
+{
+    int column = int(joint) * 3;
+    vec4 r0 = texelFetch(animationTexture, ivec2(column + 0, row), 0);
+    vec4 r1 = texelFetch(animationTexture, ivec2(column + 1, row), 0);
+    vec4 r2 = texelFetch(animationTexture, ivec2(column + 2, row), 0);
+    return transpose(mat4(r0, r1, r2, vec4(0.0, 0.0, 0.0, 1.0)));
+}
+
+// returns the skinning matrix of a joint between the two frames around the instance's frame
+mat4 SampleJoint(uint joint, int row, float blend)
+{
+    mat4 current = FetchJoint(joint, row);
+    return current + (FetchJoint(joint, row + 1) - current) * blend;
+}
+
+void main()
+{
+    // set vertex position on world
+    InstanceData instance = instances[visible[gl_InstanceIndex]];
+
+    // the last row of a clip is never the first one of the pair, the clip's end is baked as it's own row
+    int lastRow = textureSize(animationTexture, 0).y - 1;
+    int row = min(int(instance.frame), max(lastRow - 1, 0));
+    float blend = lastRow > 0 ? clamp(instance.frame - float(row), 0.0, 1.0) : 0.0;
+
+    mat4 skin = inWeight.x * SampleJoint(inJoint.x, row, blend)
+        + inWeight.y * SampleJoint(inJoint.y, row, blend)
+        + inWeight.z * SampleJoint(inJoint.z, row, blend)
+        + inWeight.w * SampleJoint(inJoint.w, row, blend);
+
+    gl_Position = camera.proj * camera.view * instance.model * skin * vec4(inPosition, 1.0);
+
+    // output variables for the fragment shader
+    outFragTexCoord = inTexCoord;
+    outFragID = instance.id;
+}
\ No newline at end of file
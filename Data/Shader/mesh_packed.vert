@@ -0,0 +1,60 @@
+#version 450
+#extension GL_KHR_vulkan_glsl : enable
+
+layout(set = 0, binding = 0) uniform ubo_camera
+{
+    mat4 view;
+    mat4 proj;
+    mat4 viewProj;
+    vec3 cameraFront;
+} camera;
+
+// entities sharing a mesh are drawn by a single call, gl_InstanceIndex already accounts the first instance
+struct InstanceData
+{
+    mat4 model;
+    uint id;
+    uint palette;
+    float frame;
+};
+
+layout(std430, set = 0, binding = 4) readonly buffer sbo_instances
+{
+    InstanceData instances[];
+};
+
+// instances left by the culling pass, the draws only instance the visible ones
+layout(std430, set = 0, binding = 5) readonly buffer sbo_visible
+{
+    uint visible[];
+};
+
+// static and skinned vertex layouts, the uv arrives already expanded from half-floats
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec2 inNormal; // octahedral encoded
+layout(location = 2) in vec2 inTexCoord;
+
+layout(location = 0) out vec3 outFragColor;
+layout(location = 1) out vec2 outFragTexCoord;
+layout(location = 2) flat out uint outFragID;
+
+// unfolds an octahedral encoded normal, must match the encoding done by the engine
+vec3 DecodeOctahedral(vec2 encoded)
+{
+    vec3 normal = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    float fold = max(-normal.z, 0.0);
+    normal.x += normal.x >= 0.0 ? -fold : fold;
+    normal.y += normal.y >= 0.0 ? -fold : fold;
+    return normalize(normal);
+}
+
+void main()
+{
+    // set vertex position on world
+    InstanceData instance = instances[visible[gl_InstanceIndex]];
+    gl_Position = camera.proj * camera.view * instance.model * vec4(inPosition, 1.0);
+
+    // output variables for the fragment shader
+    outFragTexCoord = inTexCoord;
+    outFragID = instance.id;
+}
\ No newline at end of file
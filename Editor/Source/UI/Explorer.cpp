@@ -116,6 +116,26 @@ namespace Cosmos
 		}
 		ImGui::EndGroup();
 
+		// gltf meshes can be cooked into the engine format, next to the source file
+		if (asset.type == Asset::Type::Mesh && std::filesystem::path(asset.path).extension() != ".cmesh")
+		{
+			if (ImGui::BeginPopupContextItem(asset.path.c_str()))
+			{
+				if (ImGui::MenuItem("Cook"))
+				{
+					std::filesystem::path destination(asset.path);
+					destination.replace_extension(".cmesh");
+
+					if (Cosmos::Mesh::Cook(asset.path, destination.string()))
+					{
+						mCurrentDirRefresh = true;
+					}
+				}
+
+				ImGui::EndPopup();
+			}
+		}
+
 		// drag and drop behaviour
 		if (asset.type != Asset::Type::Folder)
 		{
@@ -195,7 +215,7 @@ namespace Cosmos
 				continue;
 			}
 
-			if (strcmp(".gltf", ext.c_str()) == 0)
+			if (strcmp(".gltf", ext.c_str()) == 0 || strcmp(".glb", ext.c_str()) == 0 || strcmp(".cmesh", ext.c_str()) == 0)
 			{
 				asset.type = Asset::Type::Mesh;
 				asset.view = mMeshRes.view;
@@ -2,6 +2,8 @@
 
 #include "Renderer/Grid.h"
 
+#include <algorithm>
+
 namespace Cosmos
 {
 	Menubar::Menubar(Application* application, Shared<Window> window, Shared<Renderer> renderer, Grid* grid)
@@ -17,6 +19,7 @@ namespace Cosmos
 		ImGui::EndMainMenuBar();
 
 		HandleMenuAction();
+		CheckBenchmarks();
 
 		// scene info
 		auto& camera = mRenderer->GetCamera();
@@ -57,6 +60,11 @@ namespace Cosmos
 				mGrid->ToogleOnOff();
 			}
 
+			if (UI::CheckboxSliderEx("Compute Skinning", &mCheckboxComputeSkinning))
+			{
+				mRenderer->SetComputeSkinning(mCheckboxComputeSkinning);
+			}
+
 			ImGui::EndMenu();
 		}
 
@@ -77,10 +85,83 @@ namespace Cosmos
 				mApplication->GetPhysicsWorld()->RunTest();
 			}
 
+			if (ImGui::BeginMenu("Physics Benchmark"))
+			{
+				// every scene runs on it's own headless world, the results are written into the console once they're done
+				const bool running = mBenchmark.valid();
+
+				for (uint32_t i = 0; i < Physics::Benchmark::SceneMax; i++)
+				{
+					Physics::Benchmark::Scene scene = (Physics::Benchmark::Scene)i;
+
+					if (ImGui::MenuItem(Physics::Benchmark::GetSceneName(scene), nullptr, false, !running))
+					{
+						Physics::Benchmark::Specification specification = {};
+						specification.scene = scene;
+
+						RunBenchmarks({ specification });
+					}
+				}
+
+				ImGui::Separator();
+
+				if (ImGui::MenuItem("Run All", nullptr, false, !running))
+				{
+					std::vector<Physics::Benchmark::Specification> specifications = {};
+
+					for (uint32_t i = 0; i < Physics::Benchmark::SceneMax; i++)
+					{
+						Physics::Benchmark::Specification specification = {};
+						specification.scene = (Physics::Benchmark::Scene)i;
+						specifications.push_back(specification);
+					}
+
+					RunBenchmarks(specifications);
+				}
+
+				if (running)
+				{
+					ImGui::TextDisabled("Running...");
+				}
+
+				ImGui::EndMenu();
+			}
+
 			ImGui::EndMenu();
 		}
 	}
 
+	void Menubar::RunBenchmarks(std::vector<Physics::Benchmark::Specification> specifications)
+	{
+		// the reports are owned by the task too, the menubar may be gone before it finishes
+		Shared<std::vector<Physics::Benchmark::Report>> reports = CreateShared<std::vector<Physics::Benchmark::Report>>();
+		mBenchmarkReports = reports;
+
+		mBenchmark = ThreadPool::GetInstance().Enqueue([specifications, reports]()
+			{
+				for (const Physics::Benchmark::Specification& specification : specifications)
+				{
+					reports->push_back(Physics::Benchmark::Run(specification));
+				}
+			});
+	}
+
+	void Menubar::CheckBenchmarks()
+	{
+		if (!mBenchmark.valid() || mBenchmark.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+			return;
+
+		// the logger is not thread safe, results are only written from here
+		mBenchmark.get();
+
+		for (const Physics::Benchmark::Report& report : *mBenchmarkReports)
+		{
+			Physics::Benchmark::Log(report);
+		}
+
+		mBenchmarkReports.reset();
+	}
+
 	void Menubar::HandleMenuAction()
 	{
 		switch (mMenuAction)
@@ -149,6 +230,76 @@ namespace Cosmos
 				ImGui::TreePop();
 			}
 
+			// animation level of detail
+			if (ImGui::TreeNodeEx("Animation LOD", flags))
+			{
+				Scene::AnimationLOD& lod = mApplication->GetScene()->GetAnimationLODRef();
+
+				UI::CheckboxSliderEx("Enabled", &lod.enabled);
+				ImGui::SliderFloat("Full Rate Size", &lod.fullRateSize, 0.0f, 1.0f);
+				ImGui::SliderFloat("Half Rate Size", &lod.halfRateSize, 0.0f, lod.fullRateSize);
+
+				ImGui::TreePop();
+			}
+
+			// physics rollback, snapshots are recorded after every step and the world can be rewound to any of them
+			Shared<Physics::PhysicsWorld> physicsWorld = mApplication->GetPhysicsWorld();
+
+			// physics simulation level of detail, the scene keeps the camera as the relevance source
+			if (physicsWorld != nullptr && ImGui::TreeNodeEx("Simulation LOD", flags))
+			{
+				Physics::SimulationLOD& simulationLOD = physicsWorld->GetSimulationLODRef();
+				Physics::SimulationLOD::Specification& specification = simulationLOD.GetSpecificationRef();
+
+				bool enabled = physicsWorld->IsSimulationLODEnabled();
+				if (UI::CheckboxSliderEx("Enabled", &enabled))
+				{
+					physicsWorld->SetSimulationLOD(enabled);
+				}
+
+				ImGui::SliderFloat("Reduced Distance", &specification.reducedDistance, 0.0f, specification.sleepDistance);
+				ImGui::SliderFloat("Sleep Distance", &specification.sleepDistance, specification.reducedDistance, 1000.0f);
+
+				const Physics::SimulationLOD::Statistics& statistics = simulationLOD.GetStatistics();
+				ImGui::Text("Full: %d Reduced: %d Asleep: %d", statistics.full, statistics.reduced, statistics.asleep);
+
+				ImGui::TreePop();
+			}
+
+			if (physicsWorld != nullptr && ImGui::TreeNodeEx("Physics Rollback", flags))
+			{
+				bool deterministic = physicsWorld->IsDeterministic();
+				if (UI::CheckboxSliderEx("Deterministic", &deterministic))
+				{
+					physicsWorld->SetDeterministic(deterministic);
+				}
+
+				bool recording = physicsWorld->IsRecordingSnapshots();
+				if (UI::CheckboxSliderEx("Record Snapshots", &recording))
+				{
+					physicsWorld->SetSnapshotRecording(recording);
+				}
+
+				Physics::SnapshotHistory& snapshots = physicsWorld->GetSnapshotHistoryRef();
+				ImGui::Text("Snapshots: %d (%.2f KB)", snapshots.GetCount(), snapshots.GetMemoryUsage() / 1024.0f);
+
+				if (snapshots.GetCount() > 0)
+				{
+					uint64_t oldest = snapshots.GetOldestFrame();
+					uint64_t newest = snapshots.GetNewestFrame();
+					mRewindFrame = std::clamp(mRewindFrame, oldest, newest);
+
+					ImGui::SliderScalar("Frame", ImGuiDataType_U64, &mRewindFrame, &oldest, &newest);
+
+					if (ImGui::Button("Rewind"))
+					{
+						physicsWorld->Rewind(mRewindFrame);
+					}
+				}
+
+				ImGui::TreePop();
+			}
+
 			ImGui::End();
 		}
 	}
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <Engine.h>
+#include <future>
+#include <vector>
 
 namespace Cosmos
 {
@@ -44,6 +46,12 @@ namespace Cosmos
 		// draws teh scene settings
 		void SceneSettingsWindow();
 
+		// runs benchmark scenes on a worker, so the editor keeps drawing while they're stepped
+		void RunBenchmarks(std::vector<Physics::Benchmark::Specification> specifications);
+
+		// logs the benchmark results once the worker finished
+		void CheckBenchmarks();
+
 	private:
 
 		Application* mApplication;
@@ -52,9 +60,14 @@ namespace Cosmos
 		Grid* mGrid;
 
 		bool mCheckboxGrid = true;
+		bool mCheckboxComputeSkinning = false;
 		Action mMenuAction = Action::None;
 		bool mCancelAction = false;
 
 		bool mDisplaySceneSettings = false;
+		uint64_t mRewindFrame = 0;
+
+		std::future<void> mBenchmark = {};
+		Shared<std::vector<Physics::Benchmark::Report>> mBenchmarkReports = {};	// written by the worker, read once it finished
 	};
 }
\ No newline at end of file
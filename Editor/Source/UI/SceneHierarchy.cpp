@@ -113,6 +113,7 @@ namespace Cosmos
 			{
 				DisplayAddComponentEntry<TransformComponent>("Transform");
 				DisplayAddComponentEntry<MeshComponent>("Mesh");
+				DisplayAddComponentEntry<AnimatorComponent>("Animator");
 				DisplayAddComponentEntry<PhysicsComponent>("Physics");
 
 				ImGui::EndMenu();
@@ -170,16 +171,11 @@ namespace Cosmos
 
 		DrawComponent<MeshComponent>("Mesh", mSelectedEntity, [&](MeshComponent& component)
 			{
-				if (component.mesh == nullptr)
-				{
-					component.mesh = Mesh::Create(mRenderer);
-				}
-
 				ImGui::SeparatorText("Mesh");
 
 				// path
 				{
-					std::filesystem::path path(component.mesh->GetFilepath());
+					std::filesystem::path path(component.mesh ? component.mesh->GetFilepath() : "");
 
 					constexpr unsigned int EntityNameMaxChars = 64;
 					auto mesh = path.filename().string();
@@ -198,8 +194,9 @@ namespace Cosmos
 					{
 						if (const ImGuiPayload* payload = ImGui::AcceptDragDropPayload("EXPLORER"))
 						{
+							// entities loading the same file share it's mesh
 							std::filesystem::path path = (const char*)payload->Data;
-							component.mesh->LoadFromFile(path.string());
+							component.mesh = mRenderer->GetMeshLibrary()->Load(mRenderer, path.string());
 						}
 
 						ImGui::EndDragDropTarget();
@@ -212,9 +209,12 @@ namespace Cosmos
 				{
 					std::filesystem::path path = "";
 
-					if (component.mesh->GetColormapTexture())
+					// the override is this entity's only, the mesh's colormap is shared
+					Shared<Texture2D> colormap = component.instance.colormap ? component.instance.colormap : component.mesh ? component.mesh->GetColormapTexture() : nullptr;
+
+					if (colormap)
 					{
-						path = std::filesystem::path(component.mesh->GetColormapTexture()->GetPath());
+						path = std::filesystem::path(colormap->GetPath());
 					}
 					
 					constexpr unsigned int EntityNameMaxChars = 64;
@@ -233,7 +233,7 @@ namespace Cosmos
 						if (const ImGuiPayload* payload = ImGui::AcceptDragDropPayload("EXPLORER"))
 						{
 							std::filesystem::path path = (const char*)payload->Data;
-							component.mesh->SetColormapTexture(path.string());
+							component.instance.colormap = Texture2D::Create(mRenderer, path.string(), true);
 						}
 
 						ImGui::EndDragDropTarget();
@@ -243,9 +243,55 @@ namespace Cosmos
 				ImGui::SeparatorText("Settings");
 	
 				// options
-				if (ImGui::Checkbox("Wiredframe", component.mesh->GetWiredframe()))
+				if (ImGui::Checkbox("Wiredframe", &component.instance.wiredframe))
+				{
+
+				}
+			});
+
+		DrawComponent<AnimatorComponent>("Animator", mSelectedEntity, [&](AnimatorComponent& component)
+			{
+				Shared<Mesh> mesh = mSelectedEntity->HasComponent<MeshComponent>() ? mSelectedEntity->GetComponent<MeshComponent>().mesh : nullptr;
+				uint32_t clipCount = mesh && mesh->IsLoaded() ? mesh->GetAnimationCount() : 0;
+
+				if (clipCount == 0)
+				{
+					ImGui::Text("Mesh has no animations");
+					return;
+				}
+
+				int clip = (int)component.clip;
+
+				if (ImGui::SliderInt("Clip", &clip, 0, (int)clipCount - 1))
+				{
+					component.clip = (uint32_t)clip;
+					component.time = 0.0f;
+				}
+
+				ImGui::SliderFloat("Time", &component.time, 0.0f, mesh->GetAnimationDuration(component.clip));
+				ImGui::DragFloat("Speed", &component.speed, 0.05f);
+				ImGui::Checkbox("Playing", &component.playing);
+				ImGui::SameLine();
+				ImGui::Checkbox("Loop", &component.loop);
+
+				if (mesh->GetJointCount() == 0)
+					return;
+
+				// bakes the clips next to the mesh file, they're loaded with the mesh from then on
+				if (ImGui::Button(mesh->HasBakedAnimations() ? "Bake again" : "Bake"))
 				{
+					std::string destination = std::filesystem::path(mesh->GetFilepath()).replace_extension(".cvat").string();
+
+					if (mesh->BakeAnimations(destination))
+					{
+						mesh->LoadBakedAnimations(destination);
+					}
+				}
 
+				if (mesh->HasBakedAnimations())
+				{
+					ImGui::SameLine();
+					ImGui::Text("Drawn with baked animations");
 				}
 			});
 
@@ -254,6 +300,7 @@ namespace Cosmos
 				if (component.object == nullptr)
 				{
 					component.object = CreateShared<Physics::PhysicalObject>(mPhysicsWorld);
+					component.object->SetUserData((uint32_t)mSelectedEntity->GetComponent<IDComponent>().id);
 				}
 
 				if (ImGui::Button("Calculate boundaries"))
@@ -264,19 +311,28 @@ namespace Cosmos
 						return;
 					}
 
-					if (!mSelectedEntity->GetComponent<MeshComponent>().mesh->IsLoaded())
+					if (mSelectedEntity->GetComponent<MeshComponent>().mesh == nullptr || !mSelectedEntity->GetComponent<MeshComponent>().mesh->IsLoaded())
 					{
 						COSMOS_LOG(Logger::Error, "Entity mesh was not yet loaded in order to have physics boundaries");
 						return;
 					}
 
-					// get vertices positions from the mesh component and transform them into JPH::Vec3
-					std::vector<Vertex> meshVertices = mSelectedEntity->GetComponent<MeshComponent>().mesh->GetVertices();
+					// get vertices positions from the mesh component and transform them into JPH::Vec3, the view doesn't copy them
+					VertexView meshVertices = mSelectedEntity->GetComponent<MeshComponent>().mesh->GetVertexView();
+
+					if (meshVertices.IsEmpty())
+					{
+						COSMOS_LOG(Logger::Error, "Entity mesh released it's vertices, it must be resident or on demand to have physics boundaries");
+						return;
+					}
+
 					JPH::Array<JPH::Vec3> boundariesVertices = {};
+					boundariesVertices.reserve(meshVertices.GetCount());
 
-					for (auto& vertice : meshVertices)
+					for (size_t i = 0; i < meshVertices.GetCount(); i++)
 					{
-						boundariesVertices.push_back(JPH::Vec3(vertice.position.x, vertice.position.y, vertice.position.z));
+						glm::vec3 position = meshVertices.GetPosition(i);
+						boundariesVertices.push_back(JPH::Vec3(position.x, position.y, position.z));
 					}
 
 					JPH::ConvexHullShapeSettings settings(boundariesVertices, JPH::cDefaultConvexRadius);
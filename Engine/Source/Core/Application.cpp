@@ -22,7 +22,7 @@ namespace Cosmos
 		mWindow = CreateShared<Window>(this, "Cosmos", 1280, 720);
 		//mRenderer = Renderer::Create(this, mWindow);
 		//mUI = UI::Create(this);
-		//mScene = CreateShared<Scene>(mRenderer);
+		//mScene = CreateShared<Scene>(mRenderer, mPhysicsWorld);
 
 		SDL_SysWMinfo sys;
 		mWindow->GetSystemInformation(&sys);
@@ -3,51 +3,355 @@
 
 #include "Entity/Entity.h"
 #include "Entity/Components/Base.h"
+#include "Entity/Components/Physics.h"
 #include "Entity/Components/Renderable.h"
+#include "Entity/Unique/Camera.h"
+#include "Physics/PhysicsWorld.h"
+#include "Renderer/Buffer.h"
+#include "Renderer/MeshLibrary.h"
 #include "Renderer/Renderer.h"
 
+#include "Util/Arena.h"
 #include "Util/Logger.h"
+#include "Util/ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
 
 namespace Cosmos
 {
-	Scene::Scene(Shared<Renderer> renderer)
-		: mRenderer(renderer)
+	// wraps or clamps a clip's time the way it's animator plays it
+	static float WrapClipTime(float time, float duration, bool loop)
+	{
+		if (loop && duration > 0.0f)
+		{
+			time = std::fmod(time, duration);
+			return time < 0.0f ? time + duration : time;
+		}
+
+		return std::clamp(time, 0.0f, duration);
+	}
+
+	// returns every how many frames an animator is evaluated, zero if it's mesh is outside of the frustum
+	// the dimension must be the one the gpu culls against, a limb outside of the bind pose would be drawn frozen otherwise
+	static uint32_t ChooseAnimationInterval(const Scene::AnimationLOD& lod, const Mesh::Dimension& dimension, const glm::mat4& transform, const glm::mat4& view, const glm::mat4& projection, const glm::vec4* planes)
+	{
+		// bounding sphere of the mesh, the largest axis scale keeps it conservative
+		glm::vec3 center = glm::vec3(transform * glm::vec4((dimension.min + dimension.max) * 0.5f, 1.0f));
+		float scale = std::max(glm::length(glm::vec3(transform[0])), std::max(glm::length(glm::vec3(transform[1])), glm::length(glm::vec3(transform[2]))));
+		float radius = glm::length(dimension.max - dimension.min) * 0.5f * scale;
+
+		for (uint32_t i = 0; i < 6; i++)
+		{
+			if (glm::dot(glm::vec3(planes[i]), center) + planes[i].w < -radius)
+				return 0;
+		}
+
+		// projected height over the screen's, the camera looks down -z
+		float depth = std::max(-(view * glm::vec4(center, 1.0f)).z, 0.0001f);
+		float size = radius * std::abs(projection[1][1]) / depth;
+
+		if (size >= lod.fullRateSize) return 1;
+		if (size >= lod.halfRateSize) return 2;
+		return 4;
+	}
+
+	// returns the camera position in physics space, where relevance sources are placed
+	static JPH::RVec3 GetCameraPosition(Renderer& renderer)
 	{
+		const glm::vec3& position = renderer.GetCamera()->GetPositionRef();
+		return JPH::RVec3(position.x, position.y, position.z);
+	}
+
+	Scene::Scene(Shared<Renderer> renderer, Shared<Physics::PhysicsWorld> physicsWorld)
+		: mRenderer(renderer), mPhysicsWorld(physicsWorld)
+	{
+		if (mPhysicsWorld == nullptr)
+			return;
+
+		// events are dispatched on the thread stepping the world, once the step is over
+		Physics::ContactEventQueue& events = mPhysicsWorld->GetContactEventsRef();
+		mContactSubscription = events.SubscribeContacts([this](const Physics::ContactEvent& event) { OnContact(event); });
+		mActivationSubscription = events.SubscribeActivations([this](const Physics::ActivationEvent& event) { OnActivation(event); });
+
+		// bodies far from the camera are simulated with less solver steps or put to sleep, the source follows the camera every update
+		mCameraSource = mPhysicsWorld->GetSimulationLODRef().AddSource(GetCameraPosition(*mRenderer));
+		mPhysicsWorld->SetSimulationLOD(true);
 	}
 
 	Scene::~Scene()
 	{
+		if (mPhysicsWorld == nullptr)
+			return;
+
+		// physical objects keep the world alive, it may still be stepped after the scene is gone
+		mPhysicsWorld->GetContactEventsRef().UnsubscribeContacts(mContactSubscription);
+		mPhysicsWorld->GetContactEventsRef().UnsubscribeActivations(mActivationSubscription);
+		mPhysicsWorld->GetSimulationLODRef().RemoveSource(mCameraSource);
 	}
 
 	void Scene::OnUpdate(float timestep)
 	{
-		// update meshes without physics component
-		auto meshView = mRegistry.view<IDComponent, TransformComponent, MeshComponent>();
-		for (auto ent : meshView)
+		// update meshes without physics component, shared meshes are updated once and not per entity
+		// meshes still loading are updated as well, that's where their loading progresses
+		mRenderer->GetMeshLibrary()->OnUpdate(timestep);
+
+		if (mPhysicsWorld != nullptr)
 		{
-			auto [idComponent, transformComponent, meshComponent] = meshView.get<IDComponent, TransformComponent, MeshComponent>(ent);
+			mPhysicsWorld->GetSimulationLODRef().SetSource(mCameraSource, GetCameraPosition(*mRenderer));
+		}
 
-			if (meshComponent.mesh == nullptr || !meshComponent.mesh->IsLoaded())
+		// bodies store the id of their entity, it's how the physics events find them
+		mPhysicsEntities.clear();
+
+		auto physicsView = mRegistry.view<IDComponent, PhysicsComponent>();
+
+		for (auto ent : physicsView)
+		{
+			mPhysicsEntities[physicsView.get<IDComponent>(ent).id.GetValue()] = ent;
+		}
+
+		// advances the animators, every entity has it's own pose so they're evaluated in parallel afterwards
+		struct AnimatedItem
+		{
+			enum Action : uint8_t
+			{
+				Evaluate = 0,	// full rate, the pose is evaluated at the current time
+				Restart,		// the pose was stale, it's evaluated now and ahead of time
+				Advance,		// the pose ahead of time is evaluated and blended towards
+				Blend			// blends towards the pose evaluated ahead of time
+			};
+
+			Mesh* mesh;
+			AnimatorComponent* animator;
+			Action action;
+			float lookahead;	// clip time at the end of the span
+			float weight;
+		};
+
+		auto animatorView = mRegistry.view<MeshComponent, AnimatorComponent>();
+		FrameVector<AnimatedItem> animated = {};
+
+		// the frustum of the camera, gribb-hartmann extraction like the culling pass
+		const glm::mat4& view = mRenderer->GetCamera()->GetViewRef();
+		const glm::mat4& projection = mRenderer->GetCamera()->GetProjectionRef();
+		glm::mat4 viewProjection = projection * view;
+		glm::vec4 planes[6] = {};
+
+		for (int i = 0; i < 3; i++)
+		{
+			glm::vec4 row = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+			glm::vec4 w = glm::vec4(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+			planes[i * 2 + 0] = w + row;
+			planes[i * 2 + 1] = w - row;
+		}
+
+		for (glm::vec4& plane : planes)
+		{
+			plane /= glm::length(glm::vec3(plane));
+		}
+
+		mFrameCount++;
+
+		for (auto ent : animatorView)
+		{
+			Shared<Mesh>& mesh = animatorView.get<MeshComponent>(ent).mesh;
+			AnimatorComponent& animator = animatorView.get<AnimatorComponent>(ent);
+
+			if (mesh == nullptr || !mesh->IsLoaded() || animator.clip >= mesh->GetAnimationCount())
+				continue;
+
+			float duration = mesh->GetAnimationDuration(animator.clip);
+			float step = animator.playing ? timestep * animator.speed : 0.0f;
+			animator.time = WrapClipTime(animator.time + step, duration, animator.loop);
+
+			// baked animations are posed by the vertex shader, the time is all the entity carries
+			if (mesh->HasBakedAnimations())
+				continue;
+
+			uint32_t interval = 1;
+
+			if (mAnimationLOD.enabled)
+			{
+				TransformComponent* transform = mRegistry.try_get<TransformComponent>(ent);
+				interval = ChooseAnimationInterval(mAnimationLOD, mesh->GetCullingDimension(), transform ? transform->GetTransform() : glm::mat4(1.0f), view, projection, planes);
+			}
+
+			animator.interval = interval;
+
+			// offscreen, only the time advances and the pose is evaluated again once it's visible
+			if (interval == 0)
+			{
+				animator.elapsed = UINT32_MAX;
 				continue;
+			}
+
+			AnimatedItem item = { mesh.get(), &animator, AnimatedItem::Evaluate, animator.time, 1.0f };
+			const bool stale = animator.elapsed == UINT32_MAX;
+
+			if (interval == 1)
+			{
+				animator.span = 1;
+				animator.elapsed = 0;
+			}
+
+			// reduced rates are staggered by entity, a pose that reached it's target is evaluated anyway
+			else if (stale || (mFrameCount + (uint32_t)ent) % interval == 0 || animator.elapsed + 1 >= animator.span)
+			{
+				item.action = stale ? AnimatedItem::Restart : AnimatedItem::Advance;
+				item.lookahead = WrapClipTime(animator.time + step * (float)(interval - 1), duration, animator.loop);
+				item.weight = 1.0f / (float)interval;
+				animator.span = interval;
+				animator.elapsed = 0;
+			}
+
+			else
+			{
+				animator.elapsed++;
+				item.action = AnimatedItem::Blend;
+				item.weight = std::min(1.0f, (float)(animator.elapsed + 1) / (float)animator.span);
+			}
 
-			meshComponent.mesh->OnUpdate(timestep);
+			animated.push_back(item);
 		}
 
+		ThreadPool::GetInstance().ParallelFor((uint32_t)animated.size(), [&animated](uint32_t i)
+		{
+			const AnimatedItem& item = animated[i];
+			AnimatorComponent& animator = *item.animator;
+
+			switch (item.action)
+			{
+				case AnimatedItem::Evaluate:
+				{
+					item.mesh->Animate(animator.clip, animator.time, animator.pose);
+					break;
+				}
+
+				case AnimatedItem::Restart:
+				{
+					item.mesh->Animate(animator.clip, animator.time, animator.pose);
+					animator.from = animator.pose;
+					item.mesh->Animate(animator.clip, item.lookahead, animator.to);
+					break;
+				}
+
+				case AnimatedItem::Advance:
+				{
+					animator.from = animator.pose;
+					item.mesh->Animate(animator.clip, item.lookahead, animator.to);
+					item.mesh->BlendPoses(animator.from, animator.to, item.weight, animator.pose);
+					break;
+				}
+
+				case AnimatedItem::Blend:
+				{
+					item.mesh->BlendPoses(animator.from, animator.to, item.weight, animator.pose);
+					break;
+				}
+			}
+		});
+
 		// update meshes with physics component
 	}
 
 	void Scene::OnRender(void* commandBuffer)
 	{
-		// draw models
+		// entities sharing a mesh, colormap and render mode are drawn by a single instanced call
+		struct DrawItem
+		{
+			Mesh* mesh;
+			Texture2D* colormap;
+			bool wiredframe;
+			entt::entity entity;
+		};
+
 		auto meshView = mRegistry.view<IDComponent, TransformComponent, MeshComponent>();
+		FrameVector<DrawItem> items = {};
+
 		for (auto ent : meshView)
 		{
-			auto [idComponent, transformComponent, meshComponent] = meshView.get<IDComponent, TransformComponent, MeshComponent>(ent);
+			MeshComponent& meshComponent = meshView.get<MeshComponent>(ent);
 
 			if (meshComponent.mesh == nullptr || !meshComponent.mesh->IsLoaded())
 				continue;
 
-			meshComponent.mesh->OnRender(commandBuffer, transformComponent.GetTransform(), idComponent.id);
+			items.push_back({ meshComponent.mesh.get(), meshComponent.instance.colormap.get(), meshComponent.instance.wiredframe, ent });
+		}
+
+		if (items.empty())
+			return;
+
+		std::sort(items.begin(), items.end(), [](const DrawItem& a, const DrawItem& b)
+		{
+			if (a.mesh != b.mesh) return a.mesh < b.mesh;
+			if (a.colormap != b.colormap) return a.colormap < b.colormap;
+			return a.wiredframe < b.wiredframe;
+		});
+
+		// instances are written in draw order, each group reads a contiguous range of them
+		InstanceData* instances = mRenderer->ReserveInstances((uint32_t)items.size());
+
+		for (size_t i = 0; i < items.size(); i++)
+		{
+			auto [idComponent, transformComponent] = meshView.get<IDComponent, TransformComponent>(items[i].entity);
+			instances[i].model = transformComponent.GetTransform();
+			instances[i].id = idComponent.id;
+		}
+
+		// skinned instances index their joint palette, all of them share the frame's palette buffer
+		// instances of baked animations only carry the frame of their clip, entities without an animator show the first one
+		FrameVector<uint32_t> skinned = {};
+		uint32_t paletteCount = 0;
+
+		for (size_t i = 0; i < items.size(); i++)
+		{
+			if (items[i].mesh->HasBakedAnimations())
+			{
+				AnimatorComponent* animator = mRegistry.try_get<AnimatorComponent>(items[i].entity);
+				instances[i].frame = animator ? items[i].mesh->GetBakedFrame(animator->clip, animator->time) : 0.0f;
+				continue;
+			}
+
+			uint32_t jointCount = items[i].mesh->GetJointCount();
+
+			if (jointCount == 0)
+				continue;
+
+			instances[i].palette = paletteCount;
+			paletteCount += jointCount;
+			skinned.push_back((uint32_t)i);
+		}
+
+		if (paletteCount > 0)
+		{
+			glm::mat4* palettes = mRenderer->ReservePalettes(paletteCount);
+
+			ThreadPool::GetInstance().ParallelFor((uint32_t)skinned.size(), [&](uint32_t s)
+			{
+				// entities without an animator are drawn at the mesh's rest pose
+				static const Mesh::Pose restPose = {};
+
+				const DrawItem& item = items[skinned[s]];
+				AnimatorComponent* animator = mRegistry.try_get<AnimatorComponent>(item.entity);
+				item.mesh->WritePalette(animator ? animator->pose : restPose, palettes + instances[skinned[s]].palette);
+			});
+		}
+
+		for (size_t first = 0; first < items.size();)
+		{
+			size_t last = first + 1;
+
+			while (last < items.size() && items[last].mesh == items[first].mesh && items[last].colormap == items[first].colormap && items[last].wiredframe == items[first].wiredframe)
+			{
+				last++;
+			}
+
+			// every entity of the group has the same state, the first one's is used
+			const Mesh::Instance& instance = meshView.get<MeshComponent>(items[first].entity).instance;
+			items[first].mesh->OnRender(commandBuffer, (uint32_t)first, (uint32_t)(last - first), instance);
+
+			first = last;
 		}
 	}
 
@@ -55,6 +359,54 @@ namespace Cosmos
 	{
 	}
 
+	void Scene::OnContact(const Physics::ContactEvent& event)
+	{
+		PhysicsComponent* components[2] = { FindPhysicsComponent(event.entity0), FindPhysicsComponent(event.entity1) };
+		const JPH::BodyID others[2] = { event.body1, event.body0 };
+
+		for (uint32_t i = 0; i < 2; i++)
+		{
+			if (components[i] == nullptr)
+				continue;
+
+			std::vector<JPH::BodyID>& touching = components[i]->touching;
+
+			// persisted contacts don't change what's touching
+			if (event.type == Physics::ContactEvent::Begin)
+			{
+				touching.push_back(others[i]);
+			}
+
+			else if (event.type == Physics::ContactEvent::End)
+			{
+				auto it = std::find(touching.begin(), touching.end(), others[i]);
+
+				if (it != touching.end())
+				{
+					touching.erase(it);
+				}
+			}
+		}
+	}
+
+	void Scene::OnActivation(const Physics::ActivationEvent& event)
+	{
+		if (PhysicsComponent* component = FindPhysicsComponent(event.entity))
+		{
+			component->active = event.type == Physics::ActivationEvent::Activated;
+		}
+	}
+
+	PhysicsComponent* Scene::FindPhysicsComponent(uint64_t userData)
+	{
+		auto it = mPhysicsEntities.find(userData);
+
+		if (it == mPhysicsEntities.end() || !mRegistry.valid(it->second))
+			return nullptr;
+
+		return mRegistry.try_get<PhysicsComponent>(it->second);
+	}
+
 	Shared<Entity> Scene::CreateEntity(std::string name)
 	{
 		entt::entity handle = mRegistry.create();
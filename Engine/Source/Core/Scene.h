@@ -10,13 +10,27 @@ namespace Cosmos
 	class Entity;
 	class Event;
 	class Renderer;
+	struct PhysicsComponent;
+
+	namespace Physics { class PhysicsWorld; struct ActivationEvent; struct ContactEvent; }
 
 	class Scene : public std::enable_shared_from_this<Scene>
 	{
 	public:
 
-		// constructor
-		Scene(Shared<Renderer> renderer);
+		// animators are evaluated less often the smaller their mesh is on screen, offscreen ones only advance their time
+		// reduced rates are staggered across entities and blended in between, sizes are the projected height over the screen's
+		struct AnimationLOD
+		{
+			bool enabled = true;
+			float fullRateSize = 0.15f;		// evaluated every frame above it
+			float halfRateSize = 0.05f;		// every 2nd frame above it, every 4th below
+		};
+
+	public:
+
+		// constructor, the contact events of the physics world are handed to the entities owning the bodies
+		Scene(Shared<Renderer> renderer, Shared<Physics::PhysicsWorld> physicsWorld = nullptr);
 
 		// destructor
 		~Scene();
@@ -30,6 +44,9 @@ namespace Cosmos
 		// returns a reference to the entity map
 		inline std::unordered_map<std::string, Shared<Entity>>& GetEntityMapRef() { return mEntityMap; }
 
+		// returns a reference to the animation level of detail policy
+		inline AnimationLOD& GetAnimationLODRef() { return mAnimationLOD; }
+
 	public:
 
 		// updates the scene logic
@@ -52,10 +69,28 @@ namespace Cosmos
 		// finds an entity by it's identifier
 		Shared<Entity> Scene::FindEntityById(UUID id);
 
+	private:
+
+		// keeps the bodies touching each entity, called after the physics step
+		void OnContact(const Physics::ContactEvent& event);
+
+		// keeps if each entity's body is active, called after the physics step
+		void OnActivation(const Physics::ActivationEvent& event);
+
+		// returns the physics component of the entity whose id was stored on a body, nullptr if it's gone
+		PhysicsComponent* FindPhysicsComponent(uint64_t userData);
+
 	private:
 
 		Shared<Renderer> mRenderer;
+		Shared<Physics::PhysicsWorld> mPhysicsWorld;
+		uint32_t mContactSubscription = 0;
+		uint32_t mActivationSubscription = 0;
+		uint32_t mCameraSource = 0;	// the camera is where bodies are relevant around for the simulation lod
+		std::unordered_map<uint64_t, entt::entity> mPhysicsEntities;	// entities with physics by their id, refreshed every update
 		entt::registry mRegistry;
 		std::unordered_map<std::string, Shared<Entity>> mEntityMap;
+		AnimationLOD mAnimationLOD = {};
+		uint32_t mFrameCount = 0;
 	};
 }
\ No newline at end of file
@@ -17,26 +17,42 @@
 #include "Platform/Window.h"
 
 // physics
+#include "Physics/Benchmark.h"
 #include "Physics/BoundingBox.h"
 #include "Physics/Collision.h"
+#include "Physics/ContactEvents.h"
 #include "Physics/Listener.h"
 #include "Physics/ObjectCollision.h"
 #include "Physics/PhysicalObject.h"
 #include "Physics/PhysicsWorld.h"
+#include "Physics/Query.h"
+#include "Physics/SimulationLOD.h"
+#include "Physics/Snapshot.h"
+#include "Physics/TempAllocator.h"
 
 // renderer
+#include "Renderer/AnimationCompressor.h"
+#include "Renderer/AnimationFormat.h"
 #include "Renderer/Buffer.h"
+#include "Renderer/Mesh.h"
+#include "Renderer/MeshFormat.h"
+#include "Renderer/MeshLibrary.h"
+#include "Renderer/MeshOptimizer.h"
 #include "Renderer/Renderer.h"
 #include "Renderer/Texture.h"
 #include "Renderer/Vertex.h"
 
 // vulkan backend (must be defined when building)
 #if defined COSMOS_RENDERER_VULKAN
+#include "Renderer/Vulkan/BakedAnimation.h"
+#include "Renderer/Vulkan/CullingPass.h"
 #include "Renderer/Vulkan/Device.h"
+#include "Renderer/Vulkan/GeometryHeap.h"
 #include "Renderer/Vulkan/Instance.h"
 #include "Renderer/Vulkan/Pipeline.h"
 #include "Renderer/Vulkan/Renderpass.h"
 #include "Renderer/Vulkan/Shader.h"
+#include "Renderer/Vulkan/SkinningPass.h"
 #include "Renderer/Vulkan/Swapchain.h"
 #include "Renderer/Vulkan/VKRenderer.h"
 #include "Renderer/Vulkan/VKTexture.h"
@@ -51,13 +67,16 @@
 
 // utility
 #include "Util/Algorithm.h"
+#include "Util/Arena.h"
 #include "Util/Datafile.h"
 #include "Util/Files.h"
 #include "Util/Logger.h"
+#include "Util/MappedFile.h"
 #include "Util/Math.h"
 #include "Util/Memory.h"
 #include "Util/Queue.h"
 #include "Util/Stack.h"
+#include "Util/ThreadPool.h"
 #include "Util/UUID.h"
 
 // wrappers are not to be included into the apps
\ No newline at end of file
@@ -2,11 +2,15 @@
 
 #include "Physics/PhysicalObject.h"
 
+#include <vector>
+
 namespace Cosmos
 {
 	struct PhysicsComponent
 	{
 		Shared<Physics::PhysicalObject> object;
+		std::vector<JPH::BodyID> touching = {};	// bodies in contact with the entity's, once per sub-shape pair, kept by the scene from the contact events
+		bool active = false;					// if the entity's body is being simulated, kept by the scene from the activation events
 
 		// constructor
 		PhysicsComponent() = default;
@@ -1,14 +1,37 @@
 #pragma once
 
 #include "Renderer/Mesh.h"
+#include <vector>
 
 namespace Cosmos
 {
 	struct MeshComponent
 	{
-		Shared<Mesh> mesh;
+		Shared<Mesh> mesh;				// shared with every entity using the same file
+		Mesh::Instance instance = {};	// state of this entity only
 
 		// constructor
 		MeshComponent() = default;
 	};
+
+	// plays one of the entity's mesh animation clips, every entity has it's own pose
+	struct AnimatorComponent
+	{
+		uint32_t clip = 0;					// index of the clip on the mesh
+		float time = 0.0f;					// seconds since the clip's start
+		float speed = 1.0f;					// playback rate, negative plays it backwards
+		bool loop = true;					// wraps around at the clip's ends, holds them otherwise
+		bool playing = true;
+		Mesh::Pose pose = {};				// skinned meshes are drawn with it's joint palette
+
+		// level of detail, the scene evaluates the clip every few frames ahead of time and blends towards it
+		uint32_t interval = 1;				// frames between evaluations, chosen every frame by the scene
+		uint32_t span = 1;					// interval of the last evaluation
+		uint32_t elapsed = UINT32_MAX;		// frames since the last evaluation, the pose is stale at UINT32_MAX
+		Mesh::Pose from = {};				// pose shown when the last evaluation happened
+		Mesh::Pose to = {};					// pose at the end of the span
+
+		// constructor
+		AnimatorComponent() = default;
+	};
 }
\ No newline at end of file
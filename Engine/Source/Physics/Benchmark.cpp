@@ -0,0 +1,307 @@
+#include "epch.h"
+#include "Benchmark.h"
+
+#include "Util/Logger.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace Cosmos::Physics
+{
+	// returns the value at a percentile of sorted samples
+	static double Percentile(const std::vector<double>& sorted, double percentile)
+	{
+		if (sorted.empty())
+			return 0.0;
+
+		size_t index = (size_t)std::ceil(percentile * (double)sorted.size()) - 1;
+		return sorted[std::min(index, sorted.size() - 1)];
+	}
+
+	const char* Benchmark::GetSceneName(Scene scene)
+	{
+		switch (scene)
+		{
+			case Scene::BoxPyramid: return "Box Pyramid";
+			case Scene::BodyPile: return "Body Pile";
+			case Scene::RagdollCrowd: return "Ragdoll Crowd";
+			case Scene::SleepingBodies: return "Sleeping Bodies";
+		}
+
+		return "Unknown";
+	}
+
+	Benchmark::Report Benchmark::Run(const Specification& specification)
+	{
+		using Clock = std::chrono::high_resolution_clock;
+
+		Report report = {};
+		report.scene = specification.scene;
+		report.frames = specification.frames;
+
+		// headless world, no application is needed
+		const uint32_t size = specification.size > 0 ? specification.size : GetDefaultSize(specification.scene);
+		PhysicsWorld world(nullptr, SizeWorld(specification.scene, size, specification.world));
+		report.jobThreads = world.GetSpecification().jobThreads;
+
+		auto buildStart = Clock::now();
+		CreateFloor(world);
+
+		switch (specification.scene)
+		{
+			case Scene::BoxPyramid: CreateBoxPyramid(world, size); break;
+			case Scene::BodyPile: CreateBodyPile(world, size); break;
+			case Scene::RagdollCrowd: CreateRagdollCrowd(world, size); break;
+			case Scene::SleepingBodies: CreateSleepingBodies(world, size); break;
+			default: break;
+		}
+
+		world.GetPhysicsSystemRef().OptimizeBroadPhase();
+		report.buildTime = std::chrono::duration<double, std::milli>(Clock::now() - buildStart).count();
+		report.bodies = world.GetPhysicsSystemRef().GetNumBodies();
+
+		// steps are timed one by one
+		std::vector<double> samples = {};
+		samples.reserve(specification.frames);
+		uint64_t contacts = 0;
+
+		for (uint32_t i = 0; i < specification.frames; i++)
+		{
+			auto start = Clock::now();
+			world.Step(specification.timestep);
+			samples.push_back(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+
+			contacts += world.GetStatistics().contacts;
+		}
+
+		report.statistics = world.GetStatistics();
+		report.contactsPeak = report.statistics.contactsPeak;
+		report.contactsAverage = specification.frames > 0 ? (double)contacts / (double)specification.frames : 0.0;
+
+		if (!samples.empty())
+		{
+			double total = 0.0;
+			for (double sample : samples) total += sample;
+
+			std::sort(samples.begin(), samples.end());
+			report.stepMin = samples.front();
+			report.stepMax = samples.back();
+			report.stepAverage = total / (double)samples.size();
+			report.stepP50 = Percentile(samples, 0.50);
+			report.stepP95 = Percentile(samples, 0.95);
+			report.stepP99 = Percentile(samples, 0.99);
+		}
+
+		JPH::StateRecorderImpl recorder;
+		world.GetPhysicsSystemRef().SaveState(recorder);
+		report.stateSize = recorder.GetData().size();
+
+		return report;
+	}
+
+	std::vector<Benchmark::Report> Benchmark::RunAll(uint32_t frames, PhysicsWorld::Specification world)
+	{
+		std::vector<Report> reports = {};
+
+		for (uint32_t i = 0; i < Scene::SceneMax; i++)
+		{
+			Specification specification = {};
+			specification.scene = (Scene)i;
+			specification.frames = frames;
+			specification.world = world;
+
+			reports.push_back(Run(specification));
+		}
+
+		return reports;
+	}
+
+	void Benchmark::Log(const Report& report)
+	{
+		COSMOS_LOG
+		(
+			Logger::Info,
+			"Physics Benchmark: %s, %d bodies, %d frames, %d job threads, built in %.2fms",
+			GetSceneName(report.scene), report.bodies, report.frames, report.jobThreads, report.buildTime
+		);
+
+		COSMOS_LOG
+		(
+			Logger::Info,
+			"Step (ms): min %.3f avg %.3f p50 %.3f p95 %.3f p99 %.3f max %.3f",
+			report.stepMin, report.stepAverage, report.stepP50, report.stepP95, report.stepP99, report.stepMax
+		);
+
+		COSMOS_LOG
+		(
+			Logger::Info,
+			"Contacts per step: avg %.1f peak %d. Temp memory peak: %zu bytes (%d overflows). State: %zu bytes",
+			report.contactsAverage, report.contactsPeak, report.statistics.tempAllocatorPeak, report.statistics.tempAllocatorOverflows, report.stateSize
+		);
+
+		if (report.statistics.bodyPairOverflows > 0 || report.statistics.contactOverflows > 0 || report.statistics.manifoldOverflows > 0)
+		{
+			COSMOS_LOG
+			(
+				Logger::Warn,
+				"Overflows: body pairs %d, contact constraints %d, manifolds %d",
+				report.statistics.bodyPairOverflows, report.statistics.contactOverflows, report.statistics.manifoldOverflows
+			);
+		}
+	}
+
+	uint32_t Benchmark::GetDefaultSize(Scene scene)
+	{
+		switch (scene)
+		{
+			case Scene::BoxPyramid: return 30;
+			case Scene::BodyPile: return 10000;
+			case Scene::RagdollCrowd: return 256;
+			case Scene::SleepingBodies: return 10000;
+		}
+
+		return 0;
+	}
+
+	PhysicsWorld::Specification Benchmark::SizeWorld(Scene scene, uint32_t size, PhysicsWorld::Specification world)
+	{
+		// bodies of the scene plus the floor, and the body pairs each one touches when settled
+		uint32_t bodies = 1;
+		uint32_t contactsPerBody = 0;
+
+		switch (scene)
+		{
+			case Scene::BoxPyramid: bodies += size * (size + 1) / 2; contactsPerBody = 3; break;
+			case Scene::BodyPile: bodies += size; contactsPerBody = 6; break;
+			case Scene::RagdollCrowd: bodies += size * 6; contactsPerBody = 4; break;
+			case Scene::SleepingBodies: bodies += size + 1; contactsPerBody = 2; break;
+			default: break;
+		}
+
+		const uint32_t contacts = bodies * contactsPerBody;
+		world.maxBodies = std::max(world.maxBodies, bodies);
+		world.maxContactConstraints = std::max(world.maxContactConstraints, contacts);
+		world.maxBodyPairs = std::max(world.maxBodyPairs, contacts * 2);
+		world.tempAllocatorSize = std::max(world.tempAllocatorSize, (size_t)bodies * 2048);
+
+		// the scenes may be stepped off the main thread, overflows are reported with the results instead
+		world.logWarnings = false;
+
+		return world;
+	}
+
+	void Benchmark::CreateFloor(PhysicsWorld& world)
+	{
+		JPH::BodyInterface& bodyInterface = world.GetPhysicsSystemRef().GetBodyInterface();
+
+		JPH::BodyCreationSettings settings(new JPH::BoxShape(JPH::Vec3(500.0f, 1.0f, 500.0f)), JPH::RVec3(0.0_r, -1.0_r, 0.0_r), JPH::Quat::sIdentity(), JPH::EMotionType::Static, Static_Layer);
+		bodyInterface.CreateAndAddBody(settings, JPH::EActivation::DontActivate);
+	}
+
+	void Benchmark::CreateBoxPyramid(PhysicsWorld& world, uint32_t size)
+	{
+		JPH::BodyInterface& bodyInterface = world.GetPhysicsSystemRef().GetBodyInterface();
+		JPH::ShapeRefC box = new JPH::BoxShape(JPH::Vec3::sReplicate(0.5f));
+
+		for (uint32_t level = 0; level < size; level++)
+		{
+			for (uint32_t i = 0; i < size - level; i++)
+			{
+				float x = -(float)(size - level) * 0.55f + (float)i * 1.1f;
+				float y = 0.5f + (float)level * 1.0f;
+
+				JPH::BodyCreationSettings settings(box, JPH::RVec3(x, y, 0.0f), JPH::Quat::sIdentity(), JPH::EMotionType::Dynamic, Dynamic_Layer);
+				bodyInterface.CreateAndAddBody(settings, JPH::EActivation::Activate);
+			}
+		}
+	}
+
+	void Benchmark::CreateBodyPile(PhysicsWorld& world, uint32_t count)
+	{
+		JPH::BodyInterface& bodyInterface = world.GetPhysicsSystemRef().GetBodyInterface();
+		JPH::ShapeRefC box = new JPH::BoxShape(JPH::Vec3::sReplicate(0.5f));
+		JPH::ShapeRefC sphere = new JPH::SphereShape(0.5f);
+
+		// bodies are placed in a column of layers, each layer is a square grid
+		const uint32_t side = std::max((uint32_t)std::sqrt((double)count / 10.0), 1u);
+
+		for (uint32_t i = 0; i < count; i++)
+		{
+			uint32_t layer = i / (side * side);
+			uint32_t cell = i % (side * side);
+
+			float x = ((float)(cell % side) - (float)side * 0.5f) * 1.2f + (layer % 2 == 0 ? 0.0f : 0.3f);
+			float z = ((float)(cell / side) - (float)side * 0.5f) * 1.2f + (layer % 2 == 0 ? 0.0f : 0.3f);
+			float y = 1.0f + (float)layer * 1.2f;
+
+			JPH::BodyCreationSettings settings(i % 2 == 0 ? box : sphere, JPH::RVec3(x, y, z), JPH::Quat::sIdentity(), JPH::EMotionType::Dynamic, Dynamic_Layer);
+			bodyInterface.CreateAndAddBody(settings, JPH::EActivation::Activate);
+		}
+	}
+
+	void Benchmark::CreateRagdollCrowd(PhysicsWorld& world, uint32_t count)
+	{
+		JPH::PhysicsSystem& system = world.GetPhysicsSystemRef();
+		JPH::BodyInterface& bodyInterface = system.GetBodyInterface();
+
+		JPH::ShapeRefC torso = new JPH::CapsuleShape(0.3f, 0.2f);
+		JPH::ShapeRefC limb = new JPH::CapsuleShape(0.25f, 0.08f);
+		JPH::ShapeRefC head = new JPH::SphereShape(0.15f);
+
+		// part offsets from the torso and the position of the joint connecting them to the torso
+		struct Part { JPH::ShapeRefC shape; JPH::Vec3 offset; JPH::Vec3 joint; };
+		const Part parts[] =
+		{
+			{ head, JPH::Vec3(0.0f, 0.75f, 0.0f), JPH::Vec3(0.0f, 0.55f, 0.0f) },
+			{ limb, JPH::Vec3(-0.45f, 0.2f, 0.0f), JPH::Vec3(-0.25f, 0.4f, 0.0f) },
+			{ limb, JPH::Vec3(0.45f, 0.2f, 0.0f), JPH::Vec3(0.25f, 0.4f, 0.0f) },
+			{ limb, JPH::Vec3(-0.15f, -0.9f, 0.0f), JPH::Vec3(-0.15f, -0.5f, 0.0f) },
+			{ limb, JPH::Vec3(0.15f, -0.9f, 0.0f), JPH::Vec3(0.15f, -0.5f, 0.0f) }
+		};
+
+		const uint32_t side = std::max((uint32_t)std::ceil(std::sqrt((double)count)), 1u);
+
+		for (uint32_t i = 0; i < count; i++)
+		{
+			JPH::RVec3 position(((float)(i % side) - (float)side * 0.5f) * 2.0f, 3.0f + (float)(i % 3), ((float)(i / side) - (float)side * 0.5f) * 2.0f);
+
+			JPH::BodyCreationSettings torsoSettings(torso, position, JPH::Quat::sIdentity(), JPH::EMotionType::Dynamic, Dynamic_Layer);
+			JPH::BodyID torsoID = bodyInterface.CreateAndAddBody(torsoSettings, JPH::EActivation::Activate);
+
+			for (const Part& part : parts)
+			{
+				JPH::BodyCreationSettings partSettings(part.shape, position + part.offset, JPH::Quat::sIdentity(), JPH::EMotionType::Dynamic, Dynamic_Layer);
+				JPH::BodyID partID = bodyInterface.CreateAndAddBody(partSettings, JPH::EActivation::Activate);
+
+				JPH::PointConstraintSettings constraintSettings;
+				constraintSettings.mPoint1 = constraintSettings.mPoint2 = position + part.joint;
+
+				JPH::Constraint* constraint = bodyInterface.CreateConstraint(&constraintSettings, torsoID, partID);
+				system.AddConstraint(constraint);
+			}
+		}
+	}
+
+	void Benchmark::CreateSleepingBodies(PhysicsWorld& world, uint32_t count)
+	{
+		JPH::BodyInterface& bodyInterface = world.GetPhysicsSystemRef().GetBodyInterface();
+		JPH::ShapeRefC box = new JPH::BoxShape(JPH::Vec3::sReplicate(0.5f));
+
+		// bodies rest on the floor and never get activated
+		const uint32_t side = std::max((uint32_t)std::ceil(std::sqrt((double)count)), 1u);
+
+		for (uint32_t i = 0; i < count; i++)
+		{
+			float x = ((float)(i % side) - (float)side * 0.5f) * 1.5f;
+			float z = ((float)(i / side) - (float)side * 0.5f) * 1.5f;
+
+			JPH::BodyCreationSettings settings(box, JPH::RVec3(x, 0.5f, z), JPH::Quat::sIdentity(), JPH::EMotionType::Dynamic, Dynamic_Layer);
+			bodyInterface.CreateAndAddBody(settings, JPH::EActivation::DontActivate);
+		}
+
+		// the only active body, wakes up whatever it falls on
+		JPH::BodyCreationSettings sphere(new JPH::SphereShape(0.5f), JPH::RVec3(0.0_r, 10.0_r, 0.0_r), JPH::Quat::sIdentity(), JPH::EMotionType::Dynamic, Dynamic_Layer);
+		bodyInterface.CreateAndAddBody(sphere, JPH::EActivation::Activate);
+	}
+}
\ No newline at end of file
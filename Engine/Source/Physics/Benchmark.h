@@ -0,0 +1,89 @@
+#pragma once
+
+#include "PhysicsWorld.h"
+
+#include <vector>
+
+namespace Cosmos::Physics
+{
+	// builds standard stress scenes on a headless physics world, steps them and reports timings
+	class Benchmark
+	{
+	public:
+
+		enum Scene
+		{
+			BoxPyramid = 0,		// a pyramid of stacked boxes, stresses the solver
+			BodyPile,			// bodies dropped on top of each other, stresses broadphase and contacts
+			RagdollCrowd,		// capsule chains linked by constraints, stresses constraint islands
+			SleepingBodies,		// many resting bodies and a single active one, stresses the cost of inactive bodies
+
+			SceneMax
+		};
+
+		struct Specification
+		{
+			Scene scene = Scene::BoxPyramid;
+			uint32_t size = 0;							// pyramid base, pile bodies, ragdolls or sleeping bodies, 0 uses the scene default
+			uint32_t frames = 600;						// how many steps are simulated
+			float timestep = 1.0f / 60.0f;
+			PhysicsWorld::Specification world = {};	// job threads and minimum capacities of the world, capacities are raised to fit the scene
+		};
+
+		struct Report
+		{
+			Scene scene = Scene::BoxPyramid;
+			uint32_t bodies = 0;
+			uint32_t frames = 0;
+			uint32_t jobThreads = 0;
+			double buildTime = 0.0;			// milliseconds spent creating the scene
+			double stepMin = 0.0;			// milliseconds a step took
+			double stepAverage = 0.0;
+			double stepP50 = 0.0;
+			double stepP95 = 0.0;
+			double stepP99 = 0.0;
+			double stepMax = 0.0;
+			double contactsAverage = 0.0;	// touching body pairs per step
+			uint32_t contactsPeak = 0;
+			size_t stateSize = 0;			// bytes of the saved world state at the end, roughly the per-body memory
+			PhysicsWorld::Statistics statistics = {};
+		};
+
+	public:
+
+		// returns the name of a scene
+		static const char* GetSceneName(Scene scene);
+
+		// builds the scene on a new world, simulates it and returns the measurements
+		static Report Run(const Specification& specification);
+
+		// runs every scene with the given frames and world specification
+		static std::vector<Report> RunAll(uint32_t frames = 600, PhysicsWorld::Specification world = {});
+
+		// writes a report into the logger
+		static void Log(const Report& report);
+
+	private:
+
+		// returns the size a scene is built with when none is given
+		static uint32_t GetDefaultSize(Scene scene);
+
+		// raises the world capacities to fit the bodies and contacts of a scene, so it's never measured overflowing
+		static PhysicsWorld::Specification SizeWorld(Scene scene, uint32_t size, PhysicsWorld::Specification world);
+
+		// creates a large static box used as the ground
+		static void CreateFloor(PhysicsWorld& world);
+
+		// stacks boxes in a pyramid with size boxes at it's base
+		static void CreateBoxPyramid(PhysicsWorld& world, uint32_t size);
+
+		// drops a grid of alternating boxes and spheres
+		static void CreateBodyPile(PhysicsWorld& world, uint32_t count);
+
+		// creates ragdolls made of capsules linked by point constraints
+		static void CreateRagdollCrowd(PhysicsWorld& world, uint32_t count);
+
+		// creates resting bodies that start asleep and one active sphere falling on them
+		static void CreateSleepingBodies(PhysicsWorld& world, uint32_t count);
+	};
+}
\ No newline at end of file
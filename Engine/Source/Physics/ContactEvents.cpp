@@ -0,0 +1,298 @@
+#include "epch.h"
+#include "ContactEvents.h"
+
+#include "Util/Logger.h"
+
+#include <algorithm>
+
+namespace Cosmos::Physics
+{
+	// every queue gets an unique identifier, so a thread can tell which buffer it owns on each queue
+	static std::atomic<uint32_t> sQueueIdentifier = 1;
+
+	// every thread writing events gets an unique identifier, it's the owner stored on the buffers it claims
+	static std::atomic<uint32_t> sThreadIdentifier = 1;
+
+	// buffers claimed by the calling thread, a few entries allow more than one physics world to be stepped
+	// an evicted entry is found again on the queue by it's owner, the cache only saves the search
+	struct ThreadBufferCache
+	{
+		static constexpr uint32_t Size = 4;
+
+		uint32_t identifiers[Size] = {};
+		void* buffers[Size] = {};
+		uint32_t next = 0;
+		uint32_t thread = 0;
+	};
+
+	static thread_local ThreadBufferCache sThreadBuffers;
+
+	ContactEventQueue::ContactEventQueue(Specification specification)
+		: mSpecification(specification)
+	{
+		COSMOS_ASSERT(mSpecification.threadCount > 0, "Contact event queue must have at least one thread buffer");
+
+		mSpecification.contactsPerThread = std::max(mSpecification.contactsPerThread, 1u);
+		mSpecification.activationsPerThread = std::max(mSpecification.activationsPerThread, 1u);
+		mSpecification.maxContactsPerThread = std::max(mSpecification.maxContactsPerThread, mSpecification.contactsPerThread);
+		mSpecification.maxActivationsPerThread = std::max(mSpecification.maxActivationsPerThread, mSpecification.activationsPerThread);
+
+		mIdentifier = sQueueIdentifier.fetch_add(1);
+		mBuffers = std::make_unique<ThreadBuffer[]>(mSpecification.threadCount);
+
+		// the jolt jobs must never allocate, buffers are only grown by the dispatch
+		for (uint32_t i = 0; i < mSpecification.threadCount; i++)
+		{
+			mBuffers[i].contacts = std::make_unique<ContactEvent[]>(mSpecification.contactsPerThread);
+			mBuffers[i].activations = std::make_unique<ActivationEvent[]>(mSpecification.activationsPerThread);
+			mBuffers[i].contactCapacity = mSpecification.contactsPerThread;
+			mBuffers[i].activationCapacity = mSpecification.activationsPerThread;
+		}
+	}
+
+	uint32_t ContactEventQueue::SubscribeContacts(ContactCallback callback)
+	{
+		mContactCallbacks.push_back(callback);
+		return (uint32_t)mContactCallbacks.size() - 1;
+	}
+
+	uint32_t ContactEventQueue::SubscribeActivations(ActivationCallback callback)
+	{
+		mActivationCallbacks.push_back(callback);
+		return (uint32_t)mActivationCallbacks.size() - 1;
+	}
+
+	void ContactEventQueue::UnsubscribeContacts(uint32_t handle)
+	{
+		if (handle < mContactCallbacks.size())
+		{
+			mContactCallbacks[handle] = nullptr;
+		}
+	}
+
+	void ContactEventQueue::UnsubscribeActivations(uint32_t handle)
+	{
+		if (handle < mActivationCallbacks.size())
+		{
+			mActivationCallbacks[handle] = nullptr;
+		}
+	}
+
+	void ContactEventQueue::PushContact(ContactEvent::Type type, const JPH::Body& body0, const JPH::Body& body1, const JPH::ContactManifold& manifold)
+	{
+		ThreadBuffer* buffer = GetThreadBuffer();
+
+		if (buffer == nullptr)
+			return;
+
+		// only the owner thread writes on the buffer, relaxed ordering is enough since the step end synchronizes with the dispatch
+		uint32_t index = buffer->contactCount.load(std::memory_order_relaxed);
+
+		if (index >= buffer->contactCapacity)
+		{
+			buffer->dropped.store(buffer->dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			return;
+		}
+
+		ContactEvent& event = buffer->contacts[index];
+		event.type = type;
+		event.body0 = body0.GetID();
+		event.body1 = body1.GetID();
+		event.entity0 = body0.GetUserData();
+		event.entity1 = body1.GetUserData();
+
+		JPH::RVec3 point = manifold.GetWorldSpaceContactPointOn1(0);
+		event.point = JPH::Float3((float)point.GetX(), (float)point.GetY(), (float)point.GetZ());
+		manifold.mWorldSpaceNormal.StoreFloat3(&event.normal);
+
+		buffer->contactCount.store(index + 1, std::memory_order_relaxed);
+	}
+
+	void ContactEventQueue::PushContactRemoved(const JPH::SubShapeIDPair& pair)
+	{
+		ThreadBuffer* buffer = GetThreadBuffer();
+
+		if (buffer == nullptr)
+			return;
+
+		uint32_t index = buffer->contactCount.load(std::memory_order_relaxed);
+
+		if (index >= buffer->contactCapacity)
+		{
+			buffer->dropped.store(buffer->dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			return;
+		}
+
+		ContactEvent& event = buffer->contacts[index];
+		event.type = ContactEvent::End;
+		event.body0 = pair.GetBody1ID();
+		event.body1 = pair.GetBody2ID();
+		event.entity0 = 0;
+		event.entity1 = 0;
+		event.point = {};
+		event.normal = {};
+
+		buffer->contactCount.store(index + 1, std::memory_order_relaxed);
+	}
+
+	void ContactEventQueue::PushActivation(ActivationEvent::Type type, const JPH::BodyID& body, uint64_t entity)
+	{
+		ThreadBuffer* buffer = GetThreadBuffer();
+
+		if (buffer == nullptr)
+			return;
+
+		uint32_t index = buffer->activationCount.load(std::memory_order_relaxed);
+
+		if (index >= buffer->activationCapacity)
+		{
+			buffer->dropped.store(buffer->dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			return;
+		}
+
+		ActivationEvent& event = buffer->activations[index];
+		event.type = type;
+		event.body = body;
+		event.entity = entity;
+
+		buffer->activationCount.store(index + 1, std::memory_order_relaxed);
+	}
+
+	void ContactEventQueue::Dispatch(JPH::PhysicsSystem& system)
+	{
+		const JPH::BodyInterface& bodyInterface = system.GetBodyInterfaceNoLock();
+		uint32_t dropped = mUnbufferedDrops.exchange(0);
+
+		// activations are few, they're dispatched straight from the thread buffers
+		for (uint32_t i = 0; i < mSpecification.threadCount; i++)
+		{
+			ThreadBuffer& buffer = mBuffers[i];
+			uint32_t count = buffer.activationCount.load(std::memory_order_acquire);
+
+			for (uint32_t j = 0; j < count; j++)
+			{
+				for (auto& callback : mActivationCallbacks)
+				{
+					if (callback) callback(buffer.activations[j]);
+				}
+			}
+
+			// a full buffer has likely dropped events, it's doubled for the next steps
+			if (count >= buffer.activationCapacity && buffer.activationCapacity < mSpecification.maxActivationsPerThread)
+			{
+				buffer.activationCapacity = std::min(buffer.activationCapacity * 2, mSpecification.maxActivationsPerThread);
+				buffer.activations = std::make_unique<ActivationEvent[]>(buffer.activationCapacity);
+			}
+
+			buffer.activationCount.store(0, std::memory_order_relaxed);
+		}
+
+		// contacts are merged in a buffer that's reused between steps
+		mMerged.clear();
+
+		for (uint32_t i = 0; i < mSpecification.threadCount; i++)
+		{
+			ThreadBuffer& buffer = mBuffers[i];
+			uint32_t count = buffer.contactCount.load(std::memory_order_acquire);
+
+			mMerged.insert(mMerged.end(), buffer.contacts.get(), buffer.contacts.get() + count);
+			dropped += buffer.dropped.load(std::memory_order_relaxed);
+
+			if (count >= buffer.contactCapacity && buffer.contactCapacity < mSpecification.maxContactsPerThread)
+			{
+				buffer.contactCapacity = std::min(buffer.contactCapacity * 2, mSpecification.maxContactsPerThread);
+				buffer.contacts = std::make_unique<ContactEvent[]>(buffer.contactCapacity);
+			}
+
+			buffer.contactCount.store(0, std::memory_order_relaxed);
+			buffer.dropped.store(0, std::memory_order_relaxed);
+		}
+
+		// the order jobs write in changes from step to step, sorting keeps the dispatch order stable
+		std::sort(mMerged.begin(), mMerged.end(), [](const ContactEvent& a, const ContactEvent& b)
+			{
+				if (a.body0 != b.body0) return a.body0 < b.body0;
+				if (a.body1 != b.body1) return a.body1 < b.body1;
+				return a.type < b.type;
+			});
+
+		uint32_t touching = 0;
+
+		for (ContactEvent& event : mMerged)
+		{
+			// removed bodies were not accessible inside the job, the ones still alive are resolved now
+			if (event.type == ContactEvent::End)
+			{
+				event.entity0 = bodyInterface.GetUserData(event.body0);
+				event.entity1 = bodyInterface.GetUserData(event.body1);
+			}
+
+			else
+			{
+				touching++;
+			}
+
+			for (auto& callback : mContactCallbacks)
+			{
+				if (callback) callback(event);
+			}
+		}
+
+		mLastContactCount = (uint32_t)mMerged.size();
+		mLastTouchingCount = touching;
+		mLastDroppedCount = dropped;
+	}
+
+	ContactEventQueue::ThreadBuffer* ContactEventQueue::GetThreadBuffer()
+	{
+		ThreadBufferCache& cache = sThreadBuffers;
+
+		for (uint32_t i = 0; i < ThreadBufferCache::Size; i++)
+		{
+			if (cache.identifiers[i] == mIdentifier)
+			{
+				return (ThreadBuffer*)cache.buffers[i];
+			}
+		}
+
+		if (cache.thread == 0)
+		{
+			cache.thread = sThreadIdentifier.fetch_add(1);
+		}
+
+		// the thread may have claimed a buffer before it's cache entry was evicted by another queue
+		ThreadBuffer* buffer = nullptr;
+
+		for (uint32_t i = 0; i < mSpecification.threadCount && buffer == nullptr; i++)
+		{
+			if (mBuffers[i].owner.load(std::memory_order_relaxed) == cache.thread)
+			{
+				buffer = &mBuffers[i];
+			}
+		}
+
+		// first event written by this thread, claims a free buffer
+		for (uint32_t i = 0; i < mSpecification.threadCount && buffer == nullptr; i++)
+		{
+			uint32_t expected = 0;
+
+			if (mBuffers[i].owner.compare_exchange_strong(expected, cache.thread, std::memory_order_relaxed))
+			{
+				buffer = &mBuffers[i];
+			}
+		}
+
+		if (buffer == nullptr)
+		{
+			mUnbufferedDrops.fetch_add(1, std::memory_order_relaxed);
+			return nullptr;
+		}
+
+		uint32_t slot = cache.next;
+		cache.identifiers[slot] = mIdentifier;
+		cache.buffers[slot] = buffer;
+		cache.next = (cache.next + 1) % ThreadBufferCache::Size;
+
+		return buffer;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,137 @@
+#pragma once
+
+#include "Wrapper/jolt.h"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace Cosmos::Physics
+{
+	// compact record of a contact between two bodies
+	struct ContactEvent
+	{
+		enum Type : uint8_t
+		{
+			Begin = 0,
+			Persist,
+			End
+		};
+
+		uint64_t entity0 = 0;		// user data of the first body, entities store their id there
+		uint64_t entity1 = 0;		// user data of the second body, entities store their id there
+		JPH::BodyID body0;
+		JPH::BodyID body1;
+		JPH::Float3 point = {};		// first world space contact point, zero on end events
+		JPH::Float3 normal = {};	// contact normal pointing from body0 to body1, zero on end events
+		Type type = Type::Begin;
+	};
+
+	// compact record of a body being activated/deactivated
+	struct ActivationEvent
+	{
+		enum Type : uint8_t
+		{
+			Activated = 0,
+			Deactivated
+		};
+
+		uint64_t entity = 0;
+		JPH::BodyID body;
+		Type type = Type::Activated;
+	};
+
+	// collects contact and activation events from the jolt jobs without locks, each thread writes only into it's own buffer
+	// buffers are allocated outside of the step, once it finishes they're merged and dispatched on the main thread
+	class ContactEventQueue
+	{
+	public:
+
+		struct Specification
+		{
+			uint32_t threadCount = 0;				// threads that may write events, the job system workers plus the one stepping the world
+			uint32_t contactsPerThread = 1024;		// contact events each thread may initially write on a single step
+			uint32_t activationsPerThread = 256;	// activation events each thread may initially write on a single step
+			uint32_t maxContactsPerThread = 16384;	// a buffer filled on a step doubles for the next ones, up to this
+			uint32_t maxActivationsPerThread = 4096;
+		};
+
+		using ContactCallback = std::function<void(const ContactEvent& event)>;
+		using ActivationCallback = std::function<void(const ActivationEvent& event)>;
+
+	public:
+
+		// constructor
+		ContactEventQueue(Specification specification);
+
+		// destructor
+		~ContactEventQueue() = default;
+
+		// returns how many contact events were dispatched on the last step
+		inline uint32_t GetContactCount() const { return mLastContactCount; }
+
+		// returns how many begin and persist events were dispatched on the last step, the touching body pairs
+		inline uint32_t GetTouchingCount() const { return mLastTouchingCount; }
+
+		// returns how many events were dropped on the last step because a buffer was full
+		inline uint32_t GetDroppedCount() const { return mLastDroppedCount; }
+
+	public:
+
+		// registers a function to be called for every contact event, returns it's handle
+		uint32_t SubscribeContacts(ContactCallback callback);
+
+		// registers a function to be called for every activation event, returns it's handle
+		uint32_t SubscribeActivations(ActivationCallback callback);
+
+		// stops calling a contact subscriber
+		void UnsubscribeContacts(uint32_t handle);
+
+		// stops calling an activation subscriber
+		void UnsubscribeActivations(uint32_t handle);
+
+		// records a contact event, called from jolt jobs
+		void PushContact(ContactEvent::Type type, const JPH::Body& body0, const JPH::Body& body1, const JPH::ContactManifold& manifold);
+
+		// records a contact end event, bodies are not accessible on removal so entities are resolved on dispatch
+		void PushContactRemoved(const JPH::SubShapeIDPair& pair);
+
+		// records an activation event, called from jolt jobs
+		void PushActivation(ActivationEvent::Type type, const JPH::BodyID& body, uint64_t entity);
+
+		// merges all thread buffers, dispatches the events to the subscribers and resets the buffers, must be called after the step
+		void Dispatch(JPH::PhysicsSystem& system);
+
+	private:
+
+		struct ThreadBuffer
+		{
+			std::unique_ptr<ContactEvent[]> contacts;
+			std::unique_ptr<ActivationEvent[]> activations;
+			uint32_t contactCapacity = 0;
+			uint32_t activationCapacity = 0;
+			std::atomic<uint32_t> contactCount = 0;
+			std::atomic<uint32_t> activationCount = 0;
+			std::atomic<uint32_t> dropped = 0;
+			std::atomic<uint32_t> owner = 0;		// identifier of the thread that claimed the buffer, 0 if it's free
+		};
+
+		// returns the buffer owned by the calling thread, claiming one on it's first event, nullptr if there's no buffer left
+		ThreadBuffer* GetThreadBuffer();
+
+	private:
+
+		Specification mSpecification;
+		uint32_t mIdentifier = 0;
+		std::unique_ptr<ThreadBuffer[]> mBuffers;
+		std::atomic<uint32_t> mUnbufferedDrops = 0;
+
+		std::vector<ContactEvent> mMerged = {};
+		std::vector<ContactCallback> mContactCallbacks = {};
+		std::vector<ActivationCallback> mActivationCallbacks = {};
+		uint32_t mLastContactCount = 0;
+		uint32_t mLastTouchingCount = 0;
+		uint32_t mLastDroppedCount = 0;
+	};
+}
\ No newline at end of file
@@ -1,12 +1,17 @@
 #pragma once
 
-#include "Wrapper/jolt.h"
+#include "ContactEvents.h"
 
 namespace Cosmos::Physics
 {
 	// listener to recieve collision events
 	class OnContactListener : public JPH::ContactListener
 	{
+	public:
+
+		// sets the queue the contact events are written into
+		inline void SetQueue(ContactEventQueue* queue) { mQueue = queue; }
+
 	public:
 
 		// event-called when contact is validated
@@ -20,11 +25,20 @@ namespace Cosmos::Physics
 
 		// event-called when contact is removed
 		virtual void OnContactRemoved(const JPH::SubShapeIDPair& subshapePair) override;
+
+	private:
+
+		ContactEventQueue* mQueue = nullptr;
 	};
 
 	// listener to recieve activation/deativation events
 	class OnBodyActivationListener : public JPH::BodyActivationListener
 	{
+	public:
+
+		// sets the queue the activation events are written into
+		inline void SetQueue(ContactEventQueue* queue) { mQueue = queue; }
+
 	public:
 
 		// event-called when body is activated
@@ -32,5 +46,9 @@ namespace Cosmos::Physics
 
 		// event-called when body is deativated
 		virtual void OnBodyDeactivated(const JPH::BodyID& inBodyID, uint64_t inBodyUserData) override;
+
+	private:
+
+		ContactEventQueue* mQueue = nullptr;
 	};
 }
\ No newline at end of file
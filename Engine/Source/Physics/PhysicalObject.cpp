@@ -9,11 +9,16 @@ namespace Cosmos::Physics
 	PhysicalObject::PhysicalObject(Shared<Physics::PhysicsWorld> physicsWorld)
 		: mPhysicsWorld(physicsWorld)
 	{
-
+		mPhysicsWorld->RegisterObject(this);
 	}
 
 	PhysicalObject::~PhysicalObject()
 	{
+		mPhysicsWorld->UnregisterObject(this);
+
+		if (mBody == nullptr)
+			return;
+
 		JPH::BodyInterface& bodyInterface = mPhysicsWorld->GetPhysicsSystemRef().GetBodyInterface();
 
 		bodyInterface.RemoveBody(mBody->GetID());
@@ -25,15 +30,33 @@ namespace Cosmos::Physics
 		// setup shape configuration
 		JPH::BodyInterface& bodyInterface = mPhysicsWorld->GetPhysicsSystemRef().GetBodyInterface();
 		JPH::BodyCreationSettings bodySettings(shape, inPosition, rotation, mode, layer);
+		bodySettings.mUserData = mUserData;
 		
 		// setup rigid body
 		mBody = bodyInterface.CreateBody(bodySettings);
+
+		if (mBody == nullptr)
+		{
+			mPhysicsWorld->ReportBodyOverflow();
+			return;
+		}
+
 		bodyInterface.AddBody(mBody->GetID(), JPH::EActivation::DontActivate); // initially objects are not activated
 		
 		// refresh broad phase
 		mPhysicsWorld->GetPhysicsSystemRef().OptimizeBroadPhase();
 	}
 
+	void PhysicalObject::SetUserData(uint64_t data)
+	{
+		mUserData = data;
+
+		if (mBody != nullptr)
+		{
+			mBody->SetUserData(data);
+		}
+	}
+
 	void PhysicalObject::SetVelocity(JPH::Vec3 velocity)
 	{
 		mPhysicsWorld->GetPhysicsSystemRef().GetBodyInterface().SetLinearVelocity(mBody->GetID(), velocity);
@@ -43,4 +66,25 @@ namespace Cosmos::Physics
 	{
 		mPhysicsWorld->GetPhysicsSystemRef().GetBodyInterface().SetPosition(mBody->GetID(), position, activationMode);
 	}
+
+	void PhysicalObject::SaveState(JPH::StateRecorder& recorder) const
+	{
+		recorder.Write(mMotionType);
+		recorder.Write(mDynamic);
+	}
+
+	void PhysicalObject::RestoreState(JPH::StateRecorder& recorder)
+	{
+		recorder.Read(mMotionType);
+		recorder.Read(mDynamic);
+	}
+
+	void PhysicalObject::SkipState(JPH::StateRecorder& recorder)
+	{
+		JPH::EMotionType motionType;
+		bool dynamic;
+
+		recorder.Read(motionType);
+		recorder.Read(dynamic);
+	}
 }
\ No newline at end of file
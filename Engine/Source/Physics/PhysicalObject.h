@@ -27,11 +27,20 @@ namespace Cosmos::Physics
 		// sets the motion type of the object
 		inline void SetMotionType(JPH::EMotionType type) { mMotionType = type; mDynamic = mMotionType != JPH::EMotionType::Static; }
 
+		// returns the rigid body, nullptr if settings were not loaded yet
+		inline JPH::Body* GetBody() { return mBody; }
+
+		// returns the value stored on the body user data, the entity id
+		inline uint64_t GetUserData() const { return mUserData; }
+
 	public:
 
 		// sets the object phyiscal properties
 		void LoadSettings(JPH::ShapeRefC shape, JPH::Vec3 inPosition, JPH::EMotionType mode, JPH::ObjectLayer layer, JPH::Quat rotation);
 
+		// sets the value stored on the body user data, used to link contact events with the entity
+		void SetUserData(uint64_t data);
+
 	public:
 
 		// sets velocity for the physical object
@@ -40,6 +49,17 @@ namespace Cosmos::Physics
 		// sets the position of the physical object
 		void SetPosition(JPH::Vec3 position, JPH::EActivation activationMode = JPH::EActivation::DontActivate);
 
+	public:
+
+		// writes the object state that is not part of the jolt body
+		void SaveState(JPH::StateRecorder& recorder) const;
+
+		// reads the object state that is not part of the jolt body
+		void RestoreState(JPH::StateRecorder& recorder);
+
+		// consumes an object state without applying it
+		static void SkipState(JPH::StateRecorder& recorder);
+
 	private:
 
 		Shared<Physics::PhysicsWorld> mPhysicsWorld;
@@ -47,7 +67,6 @@ namespace Cosmos::Physics
 		bool mDynamic = false;
 		bool mShapeHasBeenSet = false;
 		JPH::Body* mBody = nullptr;
-		JPH::RVec3 mCurrentPosition = {};
-		JPH::Vec3 mCurrentVelocity = {};
+		uint64_t mUserData = 0;
 	};
 }
\ No newline at end of file
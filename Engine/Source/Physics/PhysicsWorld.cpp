@@ -1,95 +1,363 @@
 #include "epch.h"
 #include "PhysicsWorld.h"
 
+#include "PhysicalObject.h"
 #include "Core/Application.h"
 #include "Core/Event.h"
 #include "Util/Logger.h"
 
+#include <algorithm>
 #include <cstdarg>
-#include <iostream>
+#include <mutex>
 
 namespace Cosmos::Physics
 {
-	PhysicsWorld::PhysicsWorld(Application* application)
-		: mApplication(application)
+	// how many worlds currently exists, headless worlds may be created on any thread
+	static uint32_t sWorldCount = 0;
+	static std::mutex sWorldMutex;
+
+	// resolves the automatic values of the specification
+	static PhysicsWorld::Specification ResolveSpecification(PhysicsWorld::Specification specification)
+	{
+		if (specification.jobThreads == 0)
+		{
+			specification.jobThreads = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+		}
+
+		return specification;
+	}
+
+	// event buffers start with an even share of the contact constraints and grow up to what a single thread could write
+	static ContactEventQueue::Specification SizeContactEvents(const PhysicsWorld::Specification& specification)
 	{
-		// registering default jolt allocator, witch uses malloc and free
-		// this must be done before any other jolt function
-		JPH::RegisterDefaultAllocator();
+		ContactEventQueue::Specification events = {};
+		events.threadCount = specification.jobThreads + 1;
+		events.contactsPerThread = std::max(specification.maxContactConstraints / events.threadCount, 64u);
+		events.maxContactsPerThread = specification.maxContactConstraints * 2;	// begin and persist events plus the end of the previous contacts
+		events.activationsPerThread = 64;
+		events.maxActivationsPerThread = specification.maxBodies;
+
+		return events;
+	}
 
-		// installing trace and assertions
-		JPH::Trace = LoggerPhysics;
-		JPH::AssertFailed = AssertPhysics;
+	PhysicsWorld::PhysicsWorld(Application* application, Specification specification)
+		: mApplication(application), mSpecification(ResolveSpecification(specification)), mContactEvents(SizeContactEvents(mSpecification))
+	{
+		// jolt globals are shared by every world, they're registered by the first one and released by the last one
+		std::unique_lock<std::mutex> lock(sWorldMutex);
 
-		// create a factory, this class is responsable for deserialization of saved data
-		JPH::Factory::sInstance = new JPH::Factory();
+		if (sWorldCount++ == 0)
+		{
+			// registering default jolt allocator, witch uses malloc and free
+			// this must be done before any other jolt function
+			JPH::RegisterDefaultAllocator();
 
-		// register all physics types with the factory and install their collision handlers
-		JPH::RegisterTypes();
+			// installing trace and assertions
+			JPH::Trace = LoggerPhysics;
+			JPH::AssertFailed = AssertPhysics;
 
-		// temp allocator used when updating physics. Allocating 10MB witch is a typical value.
-		// it is possible to avoid using this and use TempAllocatorMalloc to fall back to malloc/free
-		mTempAllocator = new JPH::TempAllocatorImpl(10 * 1024 * 1024);
+			// create a factory, this class is responsable for deserialization of saved data
+			JPH::Factory::sInstance = new JPH::Factory();
 
-		// temporary job system while I don't have one
-		mJobSystem = new JPH::JobSystemThreadPool(JPH::cMaxPhysicsJobs, JPH::cMaxPhysicsBarriers, std::thread::hardware_concurrency() - 1);
+			// register all physics types with the factory and install their collision handlers
+			JPH::RegisterTypes();
+		}
 
-		// how many rigid bodies that can be added to the physics system
-		constexpr uint32_t maxBodies = 32768;
+		lock.unlock();
 
-		// how many mutexes to allocate to protect rigid bodies from concurrent access, 0 for the default settings.
-		constexpr uint32_t numBodyMutexes = 0;
+		// temp allocator used when updating physics, it's usage is tracked so the size can be tuned per world
+		mTempAllocator = new TrackedTempAllocator(mSpecification.tempAllocatorSize);
 
-		// max amount of body pairs that can be queued at any time (the broad phase will detect overlapping body pairs based on their bounding boxes and will insert them into a queue for the narrowphase)
-		constexpr uint32_t maxBodyPairs = 65536;
+		// temporary job system while I don't have one
+		mJobSystem = new JPH::JobSystemThreadPool(JPH::cMaxPhysicsJobs, JPH::cMaxPhysicsBarriers, (int)mSpecification.jobThreads);
 
-		// maximum size of the contact constraint buffer.  If more contacts (collisions between bodies) are detected than this number then these contacts will be ignored and bodies will start interpenetrating / fall through the world.
-		constexpr uint32_t maxContactConstraints = 1024;
-		
 		// initializes the physics system
 		mPhysicsSystem.Init
 		(
-			maxBodies,
-			numBodyMutexes,
-			maxBodyPairs,
-			maxContactConstraints,
+			mSpecification.maxBodies,
+			mSpecification.numBodyMutexes,
+			mSpecification.maxBodyPairs,
+			mSpecification.maxContactConstraints,
 			mBPInterface,
 			mObjectPBCollision,
 			mObjectCollision
 		);
 
 		// a contact listener gets notified when bodies (are about to) collide, and when they separate again
-		// note that this is called from a job so whatever you do here needs to be thread safe
-		// registering one is entirely optional
+		// note that this is called from a job, the listeners only write into the per-thread buffers of the events queue
+		mContactListener.SetQueue(&mContactEvents);
+		mBodyActivationListener.SetQueue(&mContactEvents);
 		mPhysicsSystem.SetContactListener(&mContactListener);
 
 		// the main way to interact with the bodies in the physics system is through the body interface. 
 		// there is a locking and a non-locking variant of thi, we're going to use the locking version
 		mPhysicsSystem.SetBodyActivationListener(&mBodyActivationListener);
+
+		// physical objects state and the simulation lod levels are recorded right after the jolt state on every snapshot
+		mSnapshots.SetLinkedState
+		(
+			[this](JPH::StateRecorder& recorder)
+			{
+				SaveObjectsState(recorder);
+				mSimulationLOD.SaveState(recorder);
+			},
+			[this](JPH::StateRecorder& recorder)
+			{
+				RestoreObjectsState(recorder);
+				mSimulationLOD.RestoreState(mPhysicsSystem, recorder);
+			}
+		);
 	}
 
 	PhysicsWorld::~PhysicsWorld()
 	{
-		// unregisters all types with the factory and cleans up the default material
-		JPH::UnregisterTypes();
-
-		delete JPH::Factory::sInstance;
 		delete mJobSystem;
 		delete mTempAllocator;
+
+		std::lock_guard<std::mutex> lock(sWorldMutex);
+
+		if (--sWorldCount == 0)
+		{
+			// unregisters all types with the factory and cleans up the default material
+			JPH::UnregisterTypes();
+
+			delete JPH::Factory::sInstance;
+			JPH::Factory::sInstance = nullptr;
+		}
 	}
 
 	void PhysicsWorld::OnUpdate(float timestep)
 	{
-		if (mApplication->GetStatus() == Application::Status::Paused)
+		if (mApplication != nullptr && mApplication->GetStatus() == Application::Status::Paused)
 			return;
 
-		mPhysicsSystem.Update(timestep, 1, mTempAllocator, mJobSystem);
+		// non-deterministic mode simply follows the frame timestep
+		if (!mDeterministic)
+		{
+			Step(timestep);
+
+			if (mRecordSnapshots) SaveSnapshot();
+			return;
+		}
+
+		// deterministic mode only advances in fixed steps, the remainder is carried over to the next frame
+		mAccumulator += timestep;
+
+		while (mAccumulator >= mFixedTimestep)
+		{
+			Step(mFixedTimestep);
+			mAccumulator -= mFixedTimestep;
+
+			if (mRecordSnapshots) SaveSnapshot();
+		}
 	}
 
 	void PhysicsWorld::OnEvent(Shared<Event> event)
 	{
 	}
 
+	void PhysicsWorld::SetDeterministic(bool value, float fixedTimestep)
+	{
+		// cross-platform determinism also requires jolt to be built with JPH_CROSS_PLATFORM_DETERMINISTIC
+		JPH::PhysicsSettings settings = mPhysicsSystem.GetPhysicsSettings();
+		settings.mDeterministicSimulation = value;
+		mPhysicsSystem.SetPhysicsSettings(settings);
+
+		mDeterministic = value;
+		mFixedTimestep = fixedTimestep;
+		mAccumulator = 0.0f;
+	}
+
+	void PhysicsWorld::SetSimulationLOD(bool value)
+	{
+		if (mSimulationLODEnabled && !value)
+		{
+			mSimulationLOD.Restore(mPhysicsSystem);
+		}
+
+		mSimulationLODEnabled = value;
+	}
+
+	void PhysicsWorld::SaveSnapshot()
+	{
+		mSnapshots.Save(mPhysicsSystem, mFrame);
+	}
+
+	bool PhysicsWorld::Rewind(uint64_t frame)
+	{
+		if (!mSnapshots.Restore(mPhysicsSystem, frame))
+		{
+			return false;
+		}
+
+		// the snapshot may have been recorded with the lod enabled, every body returns to full simulation
+		if (!mSimulationLODEnabled)
+		{
+			mSimulationLOD.Restore(mPhysicsSystem);
+		}
+
+		mFrame = frame;
+		mAccumulator = 0.0f;
+		return true;
+	}
+
+	void PhysicsWorld::ExecuteQueries(QueryBatch& batch)
+	{
+		batch.Execute(mPhysicsSystem, mJobSystem, mObjectPBCollision, mObjectCollision);
+	}
+
+	void PhysicsWorld::ResetStatistics()
+	{
+		mStatistics = {};
+		mTempAllocator->ResetStatistics();
+	}
+
+	void PhysicsWorld::ReportBodyOverflow()
+	{
+		mStatistics.bodyOverflows++;
+
+		if (mSpecification.logWarnings)
+		{
+			COSMOS_LOG(Logger::Error, "Physics world is full, max bodies is %d", mSpecification.maxBodies);
+		}
+	}
+
+	void PhysicsWorld::Step(float timestep)
+	{
+		JPH::EPhysicsUpdateError errors = mPhysicsSystem.Update(timestep, 1, mTempAllocator, mJobSystem);
+		mFrame++;
+
+		// all jobs are done by now, the events can be safely read on this thread
+		mContactEvents.Dispatch(mPhysicsSystem);
+		UpdateStatistics(errors);
+
+		// bodies are re-evaluated after the step, a slice at a time
+		if (mSimulationLODEnabled)
+		{
+			mSimulationLOD.Evaluate(mPhysicsSystem, mFrame);
+		}
+	}
+
+	void PhysicsWorld::UpdateStatistics(JPH::EPhysicsUpdateError errors)
+	{
+		mStatistics.bodies = mPhysicsSystem.GetNumBodies();
+		mStatistics.bodiesPeak = std::max(mStatistics.bodiesPeak, mStatistics.bodies);
+		mStatistics.activeBodies = mPhysicsSystem.GetNumActiveBodies(JPH::EBodyType::RigidBody);
+		mStatistics.activeBodiesPeak = std::max(mStatistics.activeBodiesPeak, mStatistics.activeBodies);
+		mStatistics.contacts = mContactEvents.GetTouchingCount();
+		mStatistics.contactsPeak = std::max(mStatistics.contactsPeak, mStatistics.contacts);
+		mStatistics.droppedEvents += mContactEvents.GetDroppedCount();
+
+		// the allocator peak is reset every step so the usage of the last step can be read
+		mStatistics.tempAllocatorUsage = mTempAllocator->GetPeakUsage();
+		mStatistics.tempAllocatorPeak = std::max(mStatistics.tempAllocatorPeak, mStatistics.tempAllocatorUsage);
+		mStatistics.tempAllocatorOverflows += mTempAllocator->GetOverflowCount();
+		mStatistics.tempAllocatorOverflowBytes += mTempAllocator->GetOverflowBytes();
+
+		if (mContactEvents.GetDroppedCount() > 0 && mSpecification.logWarnings)
+		{
+			COSMOS_LOG(Logger::Warn, "%d physics events were dropped, contact event buffers are full", mContactEvents.GetDroppedCount());
+		}
+
+		if (mTempAllocator->GetOverflowCount() > 0 && mSpecification.logWarnings)
+		{
+			COSMOS_LOG(Logger::Warn, "Physics temporary memory overflowed by %zu bytes, consider a bigger tempAllocatorSize", mTempAllocator->GetOverflowBytes());
+		}
+
+		mTempAllocator->ResetStatistics();
+
+		if (errors == JPH::EPhysicsUpdateError::None)
+			return;
+
+		if ((errors & JPH::EPhysicsUpdateError::BodyPairCacheFull) != JPH::EPhysicsUpdateError::None)
+		{
+			mStatistics.bodyPairOverflows++;
+
+			if (mSpecification.logWarnings)
+			{
+				COSMOS_LOG(Logger::Warn, "Physics body pair queue is full, max body pairs is %d", mSpecification.maxBodyPairs);
+			}
+		}
+
+		if ((errors & JPH::EPhysicsUpdateError::ContactConstraintsFull) != JPH::EPhysicsUpdateError::None)
+		{
+			mStatistics.contactOverflows++;
+
+			if (mSpecification.logWarnings)
+			{
+				COSMOS_LOG(Logger::Warn, "Physics contact constraints buffer is full, max contact constraints is %d", mSpecification.maxContactConstraints);
+			}
+		}
+
+		if ((errors & JPH::EPhysicsUpdateError::ManifoldCacheFull) != JPH::EPhysicsUpdateError::None)
+		{
+			mStatistics.manifoldOverflows++;
+
+			if (mSpecification.logWarnings)
+			{
+				COSMOS_LOG(Logger::Warn, "Physics contact manifold cache is full");
+			}
+		}
+	}
+
+	void PhysicsWorld::RegisterObject(PhysicalObject* object)
+	{
+		mObjects.push_back(object);
+	}
+
+	void PhysicsWorld::UnregisterObject(PhysicalObject* object)
+	{
+		auto it = std::find(mObjects.begin(), mObjects.end(), object);
+
+		if (it != mObjects.end())
+		{
+			mObjects.erase(it);
+		}
+	}
+
+	void PhysicsWorld::SaveObjectsState(JPH::StateRecorder& recorder)
+	{
+		uint32_t count = 0;
+		for (PhysicalObject* object : mObjects)
+		{
+			if (object->GetBody() != nullptr) count++;
+		}
+
+		recorder.Write(count);
+
+		for (PhysicalObject* object : mObjects)
+		{
+			if (object->GetBody() == nullptr)
+				continue;
+
+			recorder.Write(object->GetBody()->GetID());
+			object->SaveState(recorder);
+		}
+	}
+
+	void PhysicsWorld::RestoreObjectsState(JPH::StateRecorder& recorder)
+	{
+		uint32_t count = 0;
+		recorder.Read(count);
+
+		for (uint32_t i = 0; i < count; i++)
+		{
+			JPH::BodyID id;
+			recorder.Read(id);
+
+			auto it = std::find_if(mObjects.begin(), mObjects.end(), [&](PhysicalObject* object) { return object->GetBody() != nullptr && object->GetBody()->GetID() == id; });
+
+			// the object was destroyed after the snapshot was taken, it's state must still be consumed
+			if (it == mObjects.end())
+			{
+				PhysicalObject::SkipState(recorder);
+				continue;
+			}
+
+			(*it)->RestoreState(recorder);
+		}
+	}
+
 	void PhysicsWorld::RunTest()
 	{
 		// gets a reference to the body interface
@@ -139,18 +407,18 @@ namespace Cosmos::Physics
 			// next step
 			++step;
 
-			// output current position and velocity of the sphere
-			JPH::RVec3 position = body_interface.GetCenterOfMassPosition(sphere_id);
-			JPH::Vec3 velocity = body_interface.GetLinearVelocity(sphere_id);
-			std::cout << "Step " << step << ": Position = (" << position.GetX() << ", " << position.GetY() << ", " << position.GetZ() << "), Velocity = (" << velocity.GetX() << ", " << velocity.GetY() << ", " << velocity.GetZ() << ")" << std::endl;
-
 			// if you take larger steps than 1 / 60th of a second you need to do multiple collision steps in order to keep the simulation stable. Do 1 collision step per 1 / 60th of a second (round up).
 			const int cCollisionSteps = 1;
 
 			// step the world
 			mPhysicsSystem.Update(cDeltaTime, cCollisionSteps, mTempAllocator, mJobSystem);
+			mContactEvents.Dispatch(mPhysicsSystem);
 		}
 
+		// the sphere came to rest, it's final state is reported once instead of every step
+		JPH::RVec3 position = body_interface.GetCenterOfMassPosition(sphere_id);
+		COSMOS_LOG(Logger::Trace, "Physics test: sphere went to sleep after %d steps at (%.3f, %.3f, %.3f)", step, (float)position.GetX(), (float)position.GetY(), (float)position.GetZ());
+
 		// Remove the sphere from the physics system. Note that the sphere itself keeps all of its state and can be re-added at any time.
 		body_interface.RemoveBody(sphere_id);
 
@@ -2,19 +2,57 @@
 
 #include "ObjectCollision.h"
 #include "Listener.h"
+#include "Query.h"
+#include "SimulationLOD.h"
+#include "Snapshot.h"
+#include "TempAllocator.h"
 #include "Util/Memory.h"
 
 // forward declarations
 namespace Cosmos { class Application; class Event; }
+namespace Cosmos::Physics { class PhysicalObject; }
 
 namespace Cosmos::Physics
 {
 	class PhysicsWorld
 	{
+	public:
+
+		struct Specification
+		{
+			uint32_t maxBodies = 32768;						// how many rigid bodies can be added to the world
+			uint32_t numBodyMutexes = 0;					// how many mutexes protect the bodies from concurrent access, 0 for the jolt default
+			uint32_t maxBodyPairs = 65536;					// how many body pairs the broadphase can queue for the narrowphase at any time
+			uint32_t maxContactConstraints = 10240;			// how many contacts can be solved per step, the extra ones are ignored and bodies start interpenetrating
+			size_t tempAllocatorSize = 10 * 1024 * 1024;	// memory pre-allocated for each step, the extra is served by the heap
+			uint32_t jobThreads = 0;						// worker threads used by the simulation, 0 uses one less than the hardware threads
+			bool logWarnings = true;						// logs overflows after a step, worlds stepped off the main thread only count them on the statistics
+		};
+
+		// collected after every step, peaks and overflows are kept until reset
+		struct Statistics
+		{
+			uint32_t bodies = 0;
+			uint32_t bodiesPeak = 0;
+			uint32_t activeBodies = 0;
+			uint32_t activeBodiesPeak = 0;
+			uint32_t contacts = 0;						// touching body pairs on the last step, each one is a contact constraint
+			uint32_t contactsPeak = 0;
+			size_t tempAllocatorUsage = 0;				// highest temporary memory usage on the last step
+			size_t tempAllocatorPeak = 0;
+			uint32_t bodyOverflows = 0;					// bodies that could not be created because the world is full
+			uint32_t bodyPairOverflows = 0;				// steps where the body pair queue was full, jolt doesn't expose it's usage
+			uint32_t contactOverflows = 0;				// steps where the contact constraint buffer was full
+			uint32_t manifoldOverflows = 0;				// steps where the contact manifold cache was full
+			uint32_t tempAllocatorOverflows = 0;		// temporary allocations that didn't fit the pre-allocated memory
+			size_t tempAllocatorOverflowBytes = 0;
+			uint32_t droppedEvents = 0;					// contact and activation events that didn't fit the event buffers
+		};
+
 	public:
 
 		// constructor
-		PhysicsWorld(Application* application);
+		PhysicsWorld(Application* application, Specification specification = Specification());
 
 		// destructor
 		~PhysicsWorld();
@@ -22,22 +60,95 @@ namespace Cosmos::Physics
 		// returns a reference to the physics system
 		inline JPH::PhysicsSystem& GetPhysicsSystemRef() { return mPhysicsSystem; }
 
+		// returns the capacities the world was created with
+		inline const Specification& GetSpecification() const { return mSpecification; }
+
+		// returns the usage and overflow statistics
+		inline const Statistics& GetStatistics() const { return mStatistics; }
+
+		// returns a reference to the contact events queue, systems subscribe to it to be notified of contacts
+		inline ContactEventQueue& GetContactEventsRef() { return mContactEvents; }
+
+		// returns a reference to the simulation lod, relevance sources are set through it
+		inline SimulationLOD& GetSimulationLODRef() { return mSimulationLOD; }
+
+		// returns if distant bodies are being simplified or put to sleep
+		inline bool IsSimulationLODEnabled() const { return mSimulationLODEnabled; }
+
+		// returns a reference to the recorded snapshots
+		inline SnapshotHistory& GetSnapshotHistoryRef() { return mSnapshots; }
+
+		// returns how many steps were simulated so far, used as the snapshot frame
+		inline uint64_t GetFrame() const { return mFrame; }
+
+		// returns if the simulation is running on deterministic mode
+		inline bool IsDeterministic() const { return mDeterministic; }
+
+		// enables/disables recording a snapshot after every step
+		inline void SetSnapshotRecording(bool value) { mRecordSnapshots = value; }
+
+		// returns if a snapshot is recorded after every step
+		inline bool IsRecordingSnapshots() const { return mRecordSnapshots; }
+
 	public:
 
 		// updates the physics world
 		void OnUpdate(float timestep);
 
+		// steps the simulation once and dispatches the events generated by it
+		void Step(float timestep);
+
 		// event handling
 		void OnEvent(Shared<Event> event);
 
+		// deterministic mode steps with a fixed timestep and asks jolt for a deterministic simulation, required for rollbacks
+		void SetDeterministic(bool value, float fixedTimestep = 1.0f / 60.0f);
+
+		// enables/disables the simulation lod, disabling it returns every body to full simulation
+		void SetSimulationLOD(bool value);
+
+		// records the current state as a snapshot of the current frame
+		void SaveSnapshot();
+
+		// restores the world to a previously recorded frame, newer snapshots are discarded
+		bool Rewind(uint64_t frame);
+
+		// executes a batch of ray casts, shape casts and overlap tests in parallel, must not be called while the world is stepping
+		void ExecuteQueries(QueryBatch& batch);
+
+		// resets peaks and overflow counters
+		void ResetStatistics();
+
+		// counts a body that couldn't be created because the world is full
+		void ReportBodyOverflow();
+
+		// keeps track of a physical object, it's state is saved alongside the snapshots
+		void RegisterObject(PhysicalObject* object);
+
+		// stops tracking a physical object
+		void UnregisterObject(PhysicalObject* object);
+
 		// test example
 		void RunTest();
 
+	private:
+
+		// refreshes the statistics with the results of the last step
+		void UpdateStatistics(JPH::EPhysicsUpdateError errors);
+
+		// saves the state of the physical objects, linked to the bodies by their id
+		void SaveObjectsState(JPH::StateRecorder& recorder);
+
+		// restores the state of the physical objects that still exists
+		void RestoreObjectsState(JPH::StateRecorder& recorder);
+
 	private:
 
 		Application* mApplication;
+		Specification mSpecification;
+		Statistics mStatistics = {};
 
-		JPH::TempAllocatorImpl* mTempAllocator;
+		TrackedTempAllocator* mTempAllocator;
 		JPH::JobSystemThreadPool* mJobSystem;
 
 		ObjectCollision mObjectCollision;
@@ -47,6 +158,18 @@ namespace Cosmos::Physics
 
 		OnContactListener mContactListener;
 		OnBodyActivationListener mBodyActivationListener;
+		ContactEventQueue mContactEvents;
+
+		SimulationLOD mSimulationLOD;
+		bool mSimulationLODEnabled = false;
+
+		std::vector<PhysicalObject*> mObjects = {};
+		SnapshotHistory mSnapshots;
+		uint64_t mFrame = 0;
+		bool mRecordSnapshots = false;
+		bool mDeterministic = false;
+		float mFixedTimestep = 1.0f / 60.0f;
+		float mAccumulator = 0.0f;
 	};
 
 	// implements a link between cosmos logger and jolt logger
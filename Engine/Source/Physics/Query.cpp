@@ -0,0 +1,241 @@
+#include "epch.h"
+#include "Query.h"
+
+#include <algorithm>
+
+namespace Cosmos::Physics
+{
+	// collects the overlapping bodies into a fixed range of the batch hits, without allocating
+	class OverlapCollector : public JPH::CollideShapeCollector
+	{
+	public:
+
+		// constructor
+		OverlapCollector(QueryHit* hits, uint32_t maxHits)
+			: mHits(hits), mMaxHits(maxHits)
+		{
+		}
+
+		// returns how many bodies were recorded
+		inline uint32_t GetCount() const { return mCount; }
+
+	public:
+
+		// called for every sub-shape overlapping, the body is only recorded once
+		virtual void AddHit(const JPH::CollideShapeResult& result) override
+		{
+			for (uint32_t i = 0; i < mCount; i++)
+			{
+				if (mHits[i].body == result.mBodyID2)
+					return;
+			}
+
+			QueryHit& hit = mHits[mCount++];
+			hit.body = result.mBodyID2;
+			hit.fraction = 0.0f;
+			hit.point = JPH::RVec3(result.mContactPointOn2);	// relative to the base offset, moved to world space after the query
+			hit.normal = -result.mPenetrationAxis.NormalizedOr(JPH::Vec3::sZero());
+
+			if (mCount == mMaxHits)
+			{
+				ForceEarlyOut();
+			}
+		}
+
+	private:
+
+		QueryHit* mHits;
+		uint32_t mMaxHits;
+		uint32_t mCount = 0;
+	};
+
+	QueryBatch::QueryBatch(Specification specification)
+		: mSpecification(specification)
+	{
+		mSpecification.queriesPerJob = std::max(mSpecification.queriesPerJob, 1u);
+		mSpecification.maxOverlapHits = std::max(mSpecification.maxOverlapHits, 1u);
+	}
+
+	uint32_t QueryBatch::AddRay(JPH::RVec3 origin, JPH::Vec3 direction, JPH::ObjectLayer layer, bool computeNormal)
+	{
+		Query query = {};
+		query.type = Query::Ray;
+		query.layer = layer;
+		query.computeNormal = computeNormal;
+		query.transform = JPH::RMat44::sTranslation(origin);
+		query.direction = direction;
+
+		return Add(query, 1);
+	}
+
+	uint32_t QueryBatch::AddShapeCast(JPH::ShapeRefC shape, JPH::RMat44 transform, JPH::Vec3 direction, JPH::ObjectLayer layer)
+	{
+		Query query = {};
+		query.type = Query::ShapeCast;
+		query.layer = layer;
+		query.shape = shape;
+		query.transform = transform;
+		query.direction = direction;
+
+		return Add(query, 1);
+	}
+
+	uint32_t QueryBatch::AddOverlap(JPH::ShapeRefC shape, JPH::RMat44 transform, JPH::ObjectLayer layer)
+	{
+		Query query = {};
+		query.type = Query::Overlap;
+		query.layer = layer;
+		query.shape = shape;
+		query.transform = transform;
+
+		return Add(query, mSpecification.maxOverlapHits);
+	}
+
+	void QueryBatch::Clear()
+	{
+		mQueries.clear();
+		mResults.clear();
+		mHits.clear();
+	}
+
+	void QueryBatch::Execute(JPH::PhysicsSystem& system, JPH::JobSystem* jobSystem, const JPH::ObjectVsBroadPhaseLayerFilter& broadphaseFilter, const JPH::ObjectLayerPairFilter& layerFilter)
+	{
+		const uint32_t count = (uint32_t)mQueries.size();
+
+		if (count == 0)
+			return;
+
+		// small batches are not worth the jobs overhead
+		if (jobSystem == nullptr || count <= mSpecification.queriesPerJob)
+		{
+			ExecuteRange(system, 0, count, broadphaseFilter, layerFilter);
+			return;
+		}
+
+		// every job works on it's own range of queries and hits, so no synchronization is needed besides the barrier
+		JPH::JobSystem::Barrier* barrier = jobSystem->CreateBarrier();
+
+		for (uint32_t begin = 0; begin < count; begin += mSpecification.queriesPerJob)
+		{
+			uint32_t end = std::min(begin + mSpecification.queriesPerJob, count);
+
+			JPH::JobHandle job = jobSystem->CreateJob
+			(
+				"Physics Queries",
+				JPH::Color::sGreen,
+				[this, &system, &broadphaseFilter, &layerFilter, begin, end]() { ExecuteRange(system, begin, end, broadphaseFilter, layerFilter); }
+			);
+
+			barrier->AddJob(job);
+		}
+
+		jobSystem->WaitForJobs(barrier);
+		jobSystem->DestroyBarrier(barrier);
+	}
+
+	void QueryBatch::ExecuteRange(JPH::PhysicsSystem& system, uint32_t begin, uint32_t end, const JPH::ObjectVsBroadPhaseLayerFilter& broadphaseFilter, const JPH::ObjectLayerPairFilter& layerFilter)
+	{
+		const JPH::NarrowPhaseQuery& narrowPhase = system.GetNarrowPhaseQuery();
+		const JPH::BodyLockInterface& lockInterface = system.GetBodyLockInterface();
+		const JPH::BodyInterface& bodyInterface = system.GetBodyInterface();
+
+		for (uint32_t i = begin; i < end; i++)
+		{
+			const Query& query = mQueries[i];
+			QueryResult& result = mResults[i];
+			QueryHit* hits = &mHits[query.firstHit];
+
+			JPH::DefaultBroadPhaseLayerFilter broadphase(broadphaseFilter, query.layer);
+			JPH::DefaultObjectLayerFilter layer(layerFilter, query.layer);
+
+			result.first = query.firstHit;
+			result.count = 0;
+
+			switch (query.type)
+			{
+				case Query::Ray:
+				{
+					JPH::RRayCast ray(query.transform.GetTranslation(), query.direction);
+					JPH::RayCastResult cast;
+
+					if (!narrowPhase.CastRay(ray, cast, broadphase, layer))
+						break;
+
+					hits[0].body = cast.mBodyID;
+					hits[0].fraction = cast.mFraction;
+					hits[0].point = ray.GetPointOnRay(cast.mFraction);
+					hits[0].normal = JPH::Vec3::sZero();
+
+					if (query.computeNormal)
+					{
+						JPH::BodyLockRead lock(lockInterface, cast.mBodyID);
+
+						if (lock.Succeeded())
+						{
+							hits[0].normal = lock.GetBody().GetWorldSpaceSurfaceNormal(cast.mSubShapeID2, hits[0].point);
+						}
+					}
+
+					result.count = 1;
+					break;
+				}
+
+				case Query::ShapeCast:
+				{
+					JPH::RShapeCast cast(query.shape, JPH::Vec3::sReplicate(1.0f), query.transform, query.direction);
+					JPH::ShapeCastSettings settings;
+					JPH::ClosestHitCollisionCollector<JPH::CastShapeCollector> collector;
+
+					// contact points are reported relative to the base offset
+					JPH::RVec3 baseOffset = query.transform.GetTranslation();
+					narrowPhase.CastShape(cast, settings, baseOffset, collector, broadphase, layer);
+
+					if (!collector.HadHit())
+						break;
+
+					hits[0].body = collector.mHit.mBodyID2;
+					hits[0].fraction = collector.mHit.mFraction;
+					hits[0].point = baseOffset + collector.mHit.mContactPointOn2;
+					hits[0].normal = -collector.mHit.mPenetrationAxis.NormalizedOr(JPH::Vec3::sZero());
+
+					result.count = 1;
+					break;
+				}
+
+				case Query::Overlap:
+				{
+					JPH::CollideShapeSettings settings;
+					OverlapCollector collector(hits, mSpecification.maxOverlapHits);
+
+					JPH::RVec3 baseOffset = query.transform.GetTranslation();
+					narrowPhase.CollideShape(query.shape, JPH::Vec3::sReplicate(1.0f), query.transform, settings, baseOffset, collector, broadphase, layer);
+
+					for (uint32_t j = 0; j < collector.GetCount(); j++)
+					{
+						hits[j].point = baseOffset + hits[j].point;
+					}
+
+					result.count = collector.GetCount();
+					break;
+				}
+			}
+
+			// hits are mapped to the entities stored on the body user data
+			for (uint32_t j = 0; j < result.count; j++)
+			{
+				hits[j].entity = bodyInterface.GetUserData(hits[j].body);
+			}
+		}
+	}
+
+	uint32_t QueryBatch::Add(Query& query, uint32_t maxHits)
+	{
+		query.firstHit = (uint32_t)mHits.size();
+
+		mQueries.push_back(query);
+		mResults.push_back({ query.firstHit, 0 });
+		mHits.resize(mHits.size() + maxHits);
+
+		return (uint32_t)mQueries.size() - 1;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "ObjectCollision.h"
+
+#include <vector>
+
+namespace Cosmos::Physics
+{
+	// a body hit by a query
+	struct QueryHit
+	{
+		uint64_t entity = 0;		// user data of the body, entities store their id there
+		JPH::BodyID body;
+		float fraction = 0.0f;		// fraction along the ray/cast where the hit happened, zero for overlaps
+		JPH::RVec3 point = {};		// world space hit position
+		JPH::Vec3 normal = {};		// world space surface normal, only computed for rays that asked for it
+	};
+
+	// the hits of a query inside the batch results
+	struct QueryResult
+	{
+		uint32_t first = 0;
+		uint32_t count = 0;
+
+		// returns if anything was hit
+		inline bool HasHit() const { return count > 0; }
+	};
+
+	// collection of ray casts, shape casts and overlap tests that are executed together on the job system
+	class QueryBatch
+	{
+	public:
+
+		struct Specification
+		{
+			uint32_t queriesPerJob = 64;	// how many queries each job executes
+			uint32_t maxOverlapHits = 16;	// bodies an overlap test records, the rest is ignored
+		};
+
+	public:
+
+		// constructor
+		QueryBatch(Specification specification = Specification());
+
+		// destructor
+		~QueryBatch() = default;
+
+		// returns how many queries were added
+		inline uint32_t GetCount() const { return (uint32_t)mQueries.size(); }
+
+		// returns the result of a query, valid after the batch is executed
+		inline const QueryResult& GetResult(uint32_t query) const { return mResults[query]; }
+
+		// returns a hit of a query, index must be lower than the result count
+		inline const QueryHit& GetHit(uint32_t query, uint32_t index) const { return mHits[mResults[query].first + index]; }
+
+	public:
+
+		// adds a ray from origin along direction, the direction length is the ray distance, returns the query index
+		uint32_t AddRay(JPH::RVec3 origin, JPH::Vec3 direction, JPH::ObjectLayer layer = Dynamic_Layer, bool computeNormal = false);
+
+		// adds a shape moving from transform along direction, returns the query index
+		uint32_t AddShapeCast(JPH::ShapeRefC shape, JPH::RMat44 transform, JPH::Vec3 direction, JPH::ObjectLayer layer = Dynamic_Layer);
+
+		// adds a test for bodies overlapping a shape placed at transform, returns the query index
+		uint32_t AddOverlap(JPH::ShapeRefC shape, JPH::RMat44 transform, JPH::ObjectLayer layer = Dynamic_Layer);
+
+		// removes all queries and results, keeping the memory for the next batch
+		void Clear();
+
+		// executes all queries in parallel and waits for them to finish, the physics world must not be stepping
+		void Execute(JPH::PhysicsSystem& system, JPH::JobSystem* jobSystem, const JPH::ObjectVsBroadPhaseLayerFilter& broadphaseFilter, const JPH::ObjectLayerPairFilter& layerFilter);
+
+	private:
+
+		struct Query
+		{
+			enum Type : uint8_t
+			{
+				Ray = 0,
+				ShapeCast,
+				Overlap
+			};
+
+			Type type = Type::Ray;
+			JPH::ObjectLayer layer = Dynamic_Layer;
+			bool computeNormal = false;
+			uint32_t firstHit = 0;
+			JPH::ShapeRefC shape = nullptr;
+			JPH::RMat44 transform = JPH::RMat44::sIdentity();	// origin of rays is stored on the translation
+			JPH::Vec3 direction = {};
+		};
+
+		// executes a range of queries
+		void ExecuteRange(JPH::PhysicsSystem& system, uint32_t begin, uint32_t end, const JPH::ObjectVsBroadPhaseLayerFilter& broadphaseFilter, const JPH::ObjectLayerPairFilter& layerFilter);
+
+		// adds a query and reserves it's hits
+		uint32_t Add(Query& query, uint32_t maxHits);
+
+	private:
+
+		Specification mSpecification;
+		std::vector<Query> mQueries = {};
+		std::vector<QueryResult> mResults = {};
+		std::vector<QueryHit> mHits = {};	// every query owns a fixed range, jobs never write on the same range
+	};
+}
\ No newline at end of file
@@ -0,0 +1,349 @@
+#include "epch.h"
+#include "SimulationLOD.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace Cosmos::Physics
+{
+	SimulationLOD::SimulationLOD(Specification specification)
+		: mSpecification(specification)
+	{
+		mSpecification.slices = std::max(mSpecification.slices, 1u);
+	}
+
+	uint32_t SimulationLOD::AddSource(JPH::RVec3 position)
+	{
+		for (uint32_t i = 0; i < (uint32_t)mSources.size(); i++)
+		{
+			if (!mSources[i].used)
+			{
+				mSources[i] = { position, true };
+				return i;
+			}
+		}
+
+		mSources.push_back({ position, true });
+		return (uint32_t)mSources.size() - 1;
+	}
+
+	void SimulationLOD::SetSource(uint32_t source, JPH::RVec3 position)
+	{
+		if (source < mSources.size())
+		{
+			mSources[source].position = position;
+		}
+	}
+
+	void SimulationLOD::RemoveSource(uint32_t source)
+	{
+		if (source < mSources.size())
+		{
+			mSources[source].used = false;
+		}
+	}
+
+	void SimulationLOD::Evaluate(JPH::PhysicsSystem& system, uint64_t frame)
+	{
+		// without sources there's nothing to compare against, bodies keep their current level
+		if (std::none_of(mSources.begin(), mSources.end(), [](const Source& source) { return source.used; }))
+			return;
+
+		const uint32_t slice = (uint32_t)(frame % mSpecification.slices);
+		const JPH::BodyLockInterfaceNoLock& lockInterface = system.GetBodyLockInterfaceNoLock();
+
+		mStatistics.evaluated = 0;
+
+		// active bodies may need to be reduced or put to sleep
+		system.GetActiveBodies(JPH::EBodyType::RigidBody, mActiveBodies);
+
+		for (const JPH::BodyID& id : mActiveBodies)
+		{
+			if (id.GetIndex() % mSpecification.slices != slice)
+				continue;
+
+			JPH::RVec3 position;
+			{
+				JPH::BodyLockRead lock(lockInterface, id);
+
+				if (!lock.Succeeded() || !lock.GetBody().IsDynamic())
+					continue;
+
+				position = lock.GetBody().GetCenterOfMassPosition();
+			}
+
+			auto it = mEntries.find(id.GetIndexAndSequenceNumber());
+			Entry empty = {};
+			Entry& entry = it != mEntries.end() ? it->second : empty;
+
+			// something woke up a body that was put to sleep, it's stored velocity is outdated now
+			if (entry.level == Level::Asleep)
+			{
+				entry.level = Level::Reduced;
+			}
+
+			Level level = SelectLevel(entry.level, GetClosestDistanceSq(position));
+			mStatistics.evaluated++;
+
+			if (level != entry.level)
+			{
+				ChangeLevel(system, id, entry, level);
+			}
+		}
+
+		// bodies put to sleep may have become relevant again
+		mRemoved.clear();
+
+		for (auto& [key, entry] : mEntries)
+		{
+			if (entry.level != Level::Asleep)
+				continue;
+
+			JPH::BodyID id(key);
+
+			if (id.GetIndex() % mSpecification.slices != slice)
+				continue;
+
+			JPH::RVec3 position;
+			{
+				JPH::BodyLockRead lock(lockInterface, id);
+
+				// the body was destroyed while asleep
+				if (!lock.Succeeded())
+				{
+					mRemoved.push_back(key);
+					continue;
+				}
+
+				position = lock.GetBody().GetCenterOfMassPosition();
+			}
+
+			Level level = SelectLevel(entry.level, GetClosestDistanceSq(position));
+			mStatistics.evaluated++;
+
+			if (level != entry.level)
+			{
+				ChangeLevel(system, id, entry, level);
+			}
+		}
+
+		for (uint32_t key : mRemoved)
+		{
+			mEntries.erase(key);
+		}
+
+		// bodies moved back to full level are not tracked anymore
+		mStatistics.reduced = 0;
+		mStatistics.asleep = 0;
+
+		for (auto it = mEntries.begin(); it != mEntries.end();)
+		{
+			if (it->second.level == Level::Full)
+			{
+				it = mEntries.erase(it);
+				continue;
+			}
+
+			if (it->second.level == Level::Reduced) mStatistics.reduced++;
+			else mStatistics.asleep++;
+
+			it++;
+		}
+
+		// sleeping bodies are not active, every active body that's not reduced is simulated on full level
+		uint32_t active = system.GetNumActiveBodies(JPH::EBodyType::RigidBody);
+		mStatistics.full = active > mStatistics.reduced ? active - mStatistics.reduced : 0;
+	}
+
+	void SimulationLOD::Restore(JPH::PhysicsSystem& system)
+	{
+		for (auto& [key, entry] : mEntries)
+		{
+			ChangeLevel(system, JPH::BodyID(key), entry, Level::Full);
+		}
+
+		mEntries.clear();
+		mStatistics = {};
+	}
+
+	void SimulationLOD::SaveState(JPH::StateRecorder& recorder) const
+	{
+		// written in body order, so consecutive snapshots only differ where levels changed
+		std::vector<uint32_t> keys = {};
+		keys.reserve(mEntries.size());
+
+		for (auto& [key, entry] : mEntries)
+		{
+			keys.push_back(key);
+		}
+
+		std::sort(keys.begin(), keys.end());
+		recorder.Write((uint32_t)keys.size());
+
+		for (uint32_t key : keys)
+		{
+			const Entry& entry = mEntries.at(key);
+
+			recorder.Write(key);
+			recorder.Write(entry.level);
+			recorder.Write(entry.quality);
+			recorder.Write(entry.velocitySteps);
+			recorder.Write(entry.positionSteps);
+			recorder.Write(entry.linearVelocity);
+			recorder.Write(entry.angularVelocity);
+		}
+	}
+
+	void SimulationLOD::RestoreState(JPH::PhysicsSystem& system, JPH::StateRecorder& recorder)
+	{
+		// jolt doesn't save the solver settings, the bodies managed now get their original ones back
+		// activation is part of the jolt state, bodies asleep on the snapshot are already deactivated
+		for (auto& [key, entry] : mEntries)
+		{
+			ApplySettings(system, JPH::BodyID(key), entry, false);
+		}
+
+		mEntries.clear();
+		mStatistics = {};
+
+		uint32_t count = 0;
+		recorder.Read(count);
+
+		for (uint32_t i = 0; i < count; i++)
+		{
+			uint32_t key = 0;
+			Entry entry = {};
+
+			recorder.Read(key);
+			recorder.Read(entry.level);
+			recorder.Read(entry.quality);
+			recorder.Read(entry.velocitySteps);
+			recorder.Read(entry.positionSteps);
+			recorder.Read(entry.linearVelocity);
+			recorder.Read(entry.angularVelocity);
+
+			ApplySettings(system, JPH::BodyID(key), entry, true);
+			mEntries[key] = entry;
+		}
+	}
+
+	float SimulationLOD::GetClosestDistanceSq(JPH::RVec3 position) const
+	{
+		float closest = FLT_MAX;
+
+		for (const Source& source : mSources)
+		{
+			if (source.used)
+			{
+				closest = std::min(closest, (float)(position - source.position).LengthSq());
+			}
+		}
+
+		return closest;
+	}
+
+	SimulationLOD::Level SimulationLOD::SelectLevel(Level current, float distanceSq) const
+	{
+		const float distance = std::sqrt(distanceSq);
+
+		Level level = Level::Full;
+		if (distance > mSpecification.reducedDistance) level = Level::Reduced;
+		if (distance > mSpecification.sleepDistance) level = Level::Asleep;
+
+		if (level >= current)
+			return level;
+
+		// coming back to a higher level requires crossing the border by the hysteresis
+		Level closer = Level::Full;
+		if (distance > mSpecification.reducedDistance - mSpecification.hysteresis) closer = Level::Reduced;
+		if (distance > mSpecification.sleepDistance - mSpecification.hysteresis) closer = Level::Asleep;
+
+		return std::min(closer, current);
+	}
+
+	void SimulationLOD::ChangeLevel(JPH::PhysicsSystem& system, const JPH::BodyID& id, Entry& entry, Level level)
+	{
+		JPH::BodyInterface& bodyInterface = system.GetBodyInterfaceNoLock();
+		const uint32_t key = id.GetIndexAndSequenceNumber();
+
+		// the body settings are saved once, when it leaves the full level
+		if (entry.level == Level::Full)
+		{
+			JPH::BodyLockWrite lock(system.GetBodyLockInterfaceNoLock(), id);
+
+			if (!lock.Succeeded())
+				return;
+
+			JPH::MotionProperties* motion = lock.GetBody().GetMotionProperties();
+			entry.quality = motion->GetMotionQuality();
+			entry.velocitySteps = motion->GetNumVelocityStepsOverride();
+			entry.positionSteps = motion->GetNumPositionStepsOverride();
+			motion->SetNumVelocityStepsOverride(mSpecification.reducedVelocitySteps);
+			motion->SetNumPositionStepsOverride(mSpecification.reducedPositionSteps);
+		}
+
+		if (entry.level == Level::Full && entry.quality != JPH::EMotionQuality::Discrete)
+		{
+			bodyInterface.SetMotionQuality(id, JPH::EMotionQuality::Discrete);
+		}
+
+		// deactivating a body clears it's velocity, it's kept to be restored later
+		if (level == Level::Asleep)
+		{
+			entry.linearVelocity = bodyInterface.GetLinearVelocity(id);
+			entry.angularVelocity = bodyInterface.GetAngularVelocity(id);
+			bodyInterface.DeactivateBody(id);
+		}
+
+		if (entry.level == Level::Asleep)
+		{
+			bodyInterface.ActivateBody(id);
+			bodyInterface.SetLinearAndAngularVelocity(id, entry.linearVelocity, entry.angularVelocity);
+		}
+
+		if (level == Level::Full)
+		{
+			JPH::BodyLockWrite lock(system.GetBodyLockInterfaceNoLock(), id);
+
+			if (lock.Succeeded())
+			{
+				JPH::MotionProperties* motion = lock.GetBody().GetMotionProperties();
+				motion->SetNumVelocityStepsOverride(entry.velocitySteps);
+				motion->SetNumPositionStepsOverride(entry.positionSteps);
+			}
+
+			if (entry.quality != JPH::EMotionQuality::Discrete)
+			{
+				bodyInterface.SetMotionQuality(id, entry.quality);
+			}
+		}
+
+		entry.level = level;
+
+		// bodies that left the full level start being tracked
+		if (level != Level::Full && mEntries.find(key) == mEntries.end())
+		{
+			mEntries[key] = entry;
+		}
+	}
+	void SimulationLOD::ApplySettings(JPH::PhysicsSystem& system, const JPH::BodyID& id, const Entry& entry, bool reduced)
+	{
+		{
+			JPH::BodyLockWrite lock(system.GetBodyLockInterfaceNoLock(), id);
+
+			// the body was destroyed after the snapshot was taken
+			if (!lock.Succeeded())
+				return;
+
+			JPH::MotionProperties* motion = lock.GetBody().GetMotionProperties();
+			motion->SetNumVelocityStepsOverride(reduced ? mSpecification.reducedVelocitySteps : entry.velocitySteps);
+			motion->SetNumPositionStepsOverride(reduced ? mSpecification.reducedPositionSteps : entry.positionSteps);
+		}
+
+		if (entry.quality != JPH::EMotionQuality::Discrete)
+		{
+			system.GetBodyInterfaceNoLock().SetMotionQuality(id, reduced ? JPH::EMotionQuality::Discrete : entry.quality);
+		}
+	}
+}
\ No newline at end of file
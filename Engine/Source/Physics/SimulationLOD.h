@@ -0,0 +1,117 @@
+#pragma once
+
+#include "Wrapper/jolt.h"
+
+#include <unordered_map>
+#include <vector>
+
+namespace Cosmos::Physics
+{
+	// lowers the simulation cost of dynamic bodies far away from every relevance source (cameras, players)
+	class SimulationLOD
+	{
+	public:
+
+		enum Level : uint8_t
+		{
+			Full = 0,	// simulated with the body settings
+			Reduced,	// simulated with less solver steps and without continuous collision
+			Asleep		// deactivated, it's velocity is restored once it becomes relevant again
+		};
+
+		struct Specification
+		{
+			float reducedDistance = 50.0f;		// bodies further than this from every source are reduced
+			float sleepDistance = 150.0f;		// bodies further than this from every source are put to sleep
+			float hysteresis = 5.0f;			// distance a body must come back before returning to a higher level, avoids flickering on the borders
+			uint32_t reducedVelocitySteps = 2;	// solver velocity steps of reduced bodies
+			uint32_t reducedPositionSteps = 1;	// solver position steps of reduced bodies
+			uint32_t slices = 4;				// bodies are evaluated in slices, one slice per step
+		};
+
+		// how many bodies are on each level after the last evaluation
+		struct Statistics
+		{
+			uint32_t full = 0;
+			uint32_t reduced = 0;
+			uint32_t asleep = 0;
+			uint32_t evaluated = 0;
+		};
+
+	public:
+
+		// constructor
+		SimulationLOD(Specification specification = Specification());
+
+		// destructor
+		~SimulationLOD() = default;
+
+		// returns the lod specification
+		inline Specification& GetSpecificationRef() { return mSpecification; }
+
+		// returns how many bodies are on each level
+		inline const Statistics& GetStatistics() const { return mStatistics; }
+
+	public:
+
+		// adds a position the bodies are relevant around, returns it's handle
+		uint32_t AddSource(JPH::RVec3 position);
+
+		// moves a relevance source
+		void SetSource(uint32_t source, JPH::RVec3 position);
+
+		// removes a relevance source
+		void RemoveSource(uint32_t source);
+
+		// evaluates one slice of the bodies, must be called after the step on the thread that steps the world
+		void Evaluate(JPH::PhysicsSystem& system, uint64_t frame);
+
+		// returns every managed body to full simulation, waking up the ones put to sleep
+		void Restore(JPH::PhysicsSystem& system);
+
+		// writes the level of every managed body, it's saved alongside the physics snapshots
+		void SaveState(JPH::StateRecorder& recorder) const;
+
+		// reads the levels of a snapshot and applies their settings, the jolt state must have been restored already
+		void RestoreState(JPH::PhysicsSystem& system, JPH::StateRecorder& recorder);
+
+	private:
+
+		struct Source
+		{
+			JPH::RVec3 position = {};
+			bool used = false;
+		};
+
+		struct Entry
+		{
+			Level level = Level::Full;
+			JPH::EMotionQuality quality = JPH::EMotionQuality::Discrete;	// original settings of a reduced body
+			uint32_t velocitySteps = 0;
+			uint32_t positionSteps = 0;
+			JPH::Vec3 linearVelocity = {};									// velocity of a body before it was put to sleep
+			JPH::Vec3 angularVelocity = {};
+		};
+
+		// returns the squared distance from a position to the closest source
+		float GetClosestDistanceSq(JPH::RVec3 position) const;
+
+		// returns the level a body should be on given it's distance to the closest source
+		Level SelectLevel(Level current, float distanceSq) const;
+
+		// moves a body from it's current level into another one
+		void ChangeLevel(JPH::PhysicsSystem& system, const JPH::BodyID& id, Entry& entry, Level level);
+
+		// sets the solver settings of a managed body, either the reduced ones or the original ones kept on the entry
+		void ApplySettings(JPH::PhysicsSystem& system, const JPH::BodyID& id, const Entry& entry, bool reduced);
+
+	private:
+
+		Specification mSpecification;
+		Statistics mStatistics = {};
+		std::vector<Source> mSources = {};
+		std::unordered_map<uint32_t, Entry> mEntries = {};	// bodies not on full level, keyed by the body id
+		JPH::BodyIDVector mActiveBodies = {};				// reused every evaluation
+		std::vector<uint32_t> mRemoved = {};				// reused every evaluation
+	};
+}
\ No newline at end of file
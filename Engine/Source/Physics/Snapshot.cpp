@@ -0,0 +1,279 @@
+#include "epch.h"
+#include "Snapshot.h"
+
+#include "Util/Logger.h"
+
+namespace Cosmos::Physics
+{
+	// writes a variable length unsigned integer, 7 bits per byte
+	static void WriteVarint(std::vector<uint8_t>& out, size_t value)
+	{
+		while (value >= 0x80)
+		{
+			out.push_back((uint8_t)(value | 0x80));
+			value >>= 7;
+		}
+
+		out.push_back((uint8_t)value);
+	}
+
+	// reads a variable length unsigned integer, 7 bits per byte
+	static size_t ReadVarint(const uint8_t*& data)
+	{
+		size_t value = 0;
+		uint32_t shift = 0;
+
+		while (*data & 0x80)
+		{
+			value |= (size_t)(*data & 0x7f) << shift;
+			shift += 7;
+			data++;
+		}
+
+		value |= (size_t)(*data) << shift;
+		data++;
+
+		return value;
+	}
+
+	SnapshotHistory::SnapshotHistory(Specification specification)
+		: mSpecification(specification)
+	{
+		COSMOS_ASSERT(mSpecification.capacity > 0, "Snapshot history must be able to hold at least one snapshot");
+
+		if (mSpecification.keyframeInterval == 0)
+		{
+			mSpecification.keyframeInterval = 1;
+		}
+
+		mEntries.resize(mSpecification.capacity);
+	}
+
+	size_t SnapshotHistory::GetMemoryUsage() const
+	{
+		size_t bytes = mPrevious.capacity() + mScratch.capacity();
+
+		for (const Entry& entry : mEntries)
+		{
+			bytes += entry.data.capacity();
+		}
+
+		return bytes;
+	}
+
+	bool SnapshotHistory::Contains(uint64_t frame) const
+	{
+		return Find(frame) >= 0;
+	}
+
+	void SnapshotHistory::SetLinkedState(LinkedStateFn save, LinkedStateFn restore)
+	{
+		mSaveLinked = save;
+		mRestoreLinked = restore;
+	}
+
+	void SnapshotHistory::Save(JPH::PhysicsSystem& system, uint64_t frame)
+	{
+		if (mCount > 0 && frame <= GetNewestFrame())
+		{
+			COSMOS_LOG(Logger::Error, "Physics snapshot for frame %llu is older than the newest snapshot", frame);
+			return;
+		}
+
+		// the jolt state is written first and the linked state right after it, they're restored in the same order
+		JPH::StateRecorderImpl recorder;
+		system.SaveState(recorder);
+
+		if (mSaveLinked)
+		{
+			mSaveLinked(recorder);
+		}
+
+		mScratch = recorder.GetData();
+
+		// ring is full, drop the oldest and make sure the new oldest can still be decoded on it's own
+		if (mCount == mEntries.size())
+		{
+			if (mCount > 1 && !At(1).keyframe)
+			{
+				std::string state;
+				Reconstruct(1, state);
+
+				At(1).keyframe = true;
+				At(1).data.assign(state.begin(), state.end());
+			}
+
+			mHead = (mHead + 1) % (uint32_t)mEntries.size();
+			mCount--;
+		}
+
+		Entry& entry = At(mCount);
+		entry.frame = frame;
+		entry.size = mScratch.size();
+		entry.keyframe = mCount == 0 || mSinceKeyframe + 1 >= mSpecification.keyframeInterval;
+
+		if (entry.keyframe)
+		{
+			entry.data.assign(mScratch.begin(), mScratch.end());
+			mSinceKeyframe = 0;
+		}
+
+		else
+		{
+			Encode(mPrevious, mScratch, entry);
+			mSinceKeyframe++;
+		}
+
+		mCount++;
+		mPrevious.swap(mScratch);
+	}
+
+	bool SnapshotHistory::Restore(JPH::PhysicsSystem& system, uint64_t frame)
+	{
+		int32_t index = Find(frame);
+
+		if (index < 0)
+		{
+			COSMOS_LOG(Logger::Error, "No physics snapshot was recorded for frame %llu", frame);
+			return false;
+		}
+
+		Reconstruct((uint32_t)index, mScratch);
+
+		JPH::StateRecorderImpl recorder;
+		recorder.WriteBytes(mScratch.data(), mScratch.size());
+		recorder.Rewind();
+
+		if (!system.RestoreState(recorder))
+		{
+			COSMOS_LOG(Logger::Error, "Failed to restore physics snapshot of frame %llu", frame);
+			return false;
+		}
+
+		if (mRestoreLinked)
+		{
+			mRestoreLinked(recorder);
+		}
+
+		// whatever comes after the restored frame will be re-simulated
+		mCount = (uint32_t)index + 1;
+		mPrevious.swap(mScratch);
+
+		mSinceKeyframe = 0;
+		for (int32_t i = index; i >= 0 && !At((uint32_t)i).keyframe; i--)
+		{
+			mSinceKeyframe++;
+		}
+
+		return true;
+	}
+
+	void SnapshotHistory::Clear()
+	{
+		for (Entry& entry : mEntries)
+		{
+			entry.data.clear();
+		}
+
+		mHead = 0;
+		mCount = 0;
+		mSinceKeyframe = 0;
+		mPrevious.clear();
+	}
+
+	int32_t SnapshotHistory::Find(uint64_t frame) const
+	{
+		if (mCount == 0 || frame < GetOldestFrame() || frame > GetNewestFrame())
+		{
+			return -1;
+		}
+
+		// frames are stored in increasing order
+		uint32_t low = 0;
+		uint32_t high = mCount;
+
+		while (low < high)
+		{
+			uint32_t middle = (low + high) / 2;
+
+			if (At(middle).frame < frame) low = middle + 1;
+			else high = middle;
+		}
+
+		return (low < mCount && At(low).frame == frame) ? (int32_t)low : -1;
+	}
+
+	void SnapshotHistory::Reconstruct(uint32_t index, std::string& state) const
+	{
+		// walk back to the closest keyframe, the oldest entry is always one
+		uint32_t keyframe = index;
+		while (!At(keyframe).keyframe)
+		{
+			keyframe--;
+		}
+
+		const Entry& base = At(keyframe);
+		state.assign(base.data.begin(), base.data.end());
+
+		for (uint32_t i = keyframe + 1; i <= index; i++)
+		{
+			Decode(At(i), state);
+		}
+	}
+
+	void SnapshotHistory::Encode(const std::string& previous, const std::string& current, Entry& entry)
+	{
+		entry.data.clear();
+
+		// bodies barely change between two frames, so the xor is mostly zeroes
+		const size_t size = current.size();
+		size_t i = 0;
+
+		while (i < size)
+		{
+			size_t zeroes = 0;
+			while (i < size && current[i] == (i < previous.size() ? previous[i] : 0))
+			{
+				zeroes++;
+				i++;
+			}
+
+			size_t start = i;
+			while (i < size && current[i] != (i < previous.size() ? previous[i] : 0))
+			{
+				i++;
+			}
+
+			WriteVarint(entry.data, zeroes);
+			WriteVarint(entry.data, i - start);
+
+			for (size_t j = start; j < i; j++)
+			{
+				entry.data.push_back((uint8_t)(current[j] ^ (j < previous.size() ? previous[j] : 0)));
+			}
+		}
+	}
+
+	void SnapshotHistory::Decode(const Entry& entry, std::string& state)
+	{
+		// bytes beyond the previous state were encoded against zero
+		state.resize(entry.size, 0);
+
+		const uint8_t* data = entry.data.data();
+		const uint8_t* end = data + entry.data.size();
+		size_t position = 0;
+
+		while (data < end)
+		{
+			position += ReadVarint(data);
+			size_t literals = ReadVarint(data);
+
+			for (size_t j = 0; j < literals; j++)
+			{
+				state[position] = (char)(state[position] ^ *data);
+				position++;
+				data++;
+			}
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "Wrapper/jolt.h"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace Cosmos::Physics
+{
+	// in-memory ring of recent physics states, every snapshot is delta-compressed against the previous one
+	class SnapshotHistory
+	{
+	public:
+
+		struct Specification
+		{
+			uint32_t capacity = 120;		// how many snapshots are kept before the oldest one is discarded
+			uint32_t keyframeInterval = 30;	// a full copy is stored every N snapshots, this bounds the cost of a restore
+		};
+
+		// saves/restores state that is linked to the physics bodies (like entity transforms), it's written after the jolt state
+		using LinkedStateFn = std::function<void(JPH::StateRecorder& recorder)>;
+
+	public:
+
+		// constructor
+		SnapshotHistory(Specification specification = Specification());
+
+		// destructor
+		~SnapshotHistory() = default;
+
+		// returns how many snapshots are currently stored
+		inline uint32_t GetCount() const { return mCount; }
+
+		// returns the frame of the oldest snapshot stored
+		inline uint64_t GetOldestFrame() const { return mCount > 0 ? At(0).frame : 0; }
+
+		// returns the frame of the newest snapshot stored
+		inline uint64_t GetNewestFrame() const { return mCount > 0 ? At(mCount - 1).frame : 0; }
+
+		// returns the size in bytes of the decoded newest snapshot
+		inline size_t GetStateSize() const { return mPrevious.size(); }
+
+		// returns how many bytes all stored snapshots are using
+		size_t GetMemoryUsage() const;
+
+		// returns if a snapshot of a given frame is stored
+		bool Contains(uint64_t frame) const;
+
+		// sets the callbacks used to save and restore the state linked with the physics world
+		void SetLinkedState(LinkedStateFn save, LinkedStateFn restore);
+
+	public:
+
+		// records the current physics state as the given frame, frames must be saved in increasing order
+		void Save(JPH::PhysicsSystem& system, uint64_t frame);
+
+		// restores the physics state of a given frame, snapshots newer than it are discarded
+		bool Restore(JPH::PhysicsSystem& system, uint64_t frame);
+
+		// erases all snapshots
+		void Clear();
+
+	private:
+
+		struct Entry
+		{
+			uint64_t frame = 0;
+			bool keyframe = false;
+			size_t size = 0;				// size of the decoded state
+			std::vector<uint8_t> data = {};	// raw state if keyframe, otherwise the encoded delta
+		};
+
+		// returns the entry at the ring position, 0 is the oldest
+		inline Entry& At(uint32_t index) { return mEntries[(mHead + index) % mEntries.size()]; }
+
+		// returns the entry at the ring position, 0 is the oldest
+		inline const Entry& At(uint32_t index) const { return mEntries[(mHead + index) % mEntries.size()]; }
+
+		// returns the ring position of a frame, or -1 if it's not stored
+		int32_t Find(uint64_t frame) const;
+
+		// reconstructs the full state stored at a ring position
+		void Reconstruct(uint32_t index, std::string& state) const;
+
+		// writes into entry the xor of current against previous, zero runs are length encoded
+		static void Encode(const std::string& previous, const std::string& current, Entry& entry);
+
+		// applies a delta entry over state, turning it into the entry's state
+		static void Decode(const Entry& entry, std::string& state);
+
+	private:
+
+		Specification mSpecification;
+		std::vector<Entry> mEntries = {};
+		uint32_t mHead = 0;
+		uint32_t mCount = 0;
+		uint32_t mSinceKeyframe = 0;
+		std::string mPrevious = {};		// decoded state of the newest snapshot, base for the next delta
+		std::string mScratch = {};		// reused buffer for the state being saved or restored
+		LinkedStateFn mSaveLinked = nullptr;
+		LinkedStateFn mRestoreLinked = nullptr;
+	};
+}
\ No newline at end of file
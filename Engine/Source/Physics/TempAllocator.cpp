@@ -0,0 +1,56 @@
+#include "epch.h"
+#include "TempAllocator.h"
+
+#include "Util/Logger.h"
+
+namespace Cosmos::Physics
+{
+	TrackedTempAllocator::TrackedTempAllocator(size_t size)
+		: mArena(size, size)
+	{
+	}
+
+	TrackedTempAllocator::~TrackedTempAllocator()
+	{
+		COSMOS_ASSERT(mArena.GetUsage() == 0, "Physics temporary memory was not freed");
+	}
+
+	void* TrackedTempAllocator::Allocate(JPH::uint size)
+	{
+		if (size == 0)
+			return nullptr;
+
+		size_t aligned = JPH::AlignUp(size, JPH_RVECTOR_ALIGNMENT);
+		void* address = mArena.TryAllocate(aligned, JPH_RVECTOR_ALIGNMENT);
+
+		// the arena is too small for this step, the allocation is served by the heap and counted so the world can be resized
+		if (address == nullptr)
+		{
+			mOverflows++;
+			mOverflowBytes += aligned;
+			return JPH::AlignedAllocate(aligned, JPH_RVECTOR_ALIGNMENT);
+		}
+
+		return address;
+	}
+
+	void TrackedTempAllocator::Free(void* address, JPH::uint size)
+	{
+		if (address == nullptr)
+			return;
+
+		// memory outside the arena came from the heap fallback
+		if (!mArena.Owns(address))
+		{
+			JPH::AlignedFree(address);
+			return;
+		}
+
+		// jolt frees in reverse order, so the freed block is always the top of the arena
+		size_t aligned = JPH::AlignUp(size, JPH_RVECTOR_ALIGNMENT);
+		size_t marker = mArena.GetOffset(address);
+
+		COSMOS_ASSERT(marker + aligned == mArena.GetMarker(), "Physics temporary memory must be freed in reverse order");
+		mArena.Rewind(marker);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "Util/Arena.h"
+#include "Wrapper/jolt.h"
+
+namespace Cosmos::Physics
+{
+	// jolt's step allocator backed by a linear arena, keeps track of it's peak usage and falls back to the heap instead of asserting when it's full
+	class TrackedTempAllocator final : public JPH::TempAllocator
+	{
+	public:
+
+		// constructor
+		TrackedTempAllocator(size_t size);
+
+		// destructor
+		virtual ~TrackedTempAllocator();
+
+		// returns the size of the pre-allocated buffer
+		inline size_t GetSize() const { return mArena.GetCapacity(); }
+
+		// returns how many bytes are currently in use
+		inline size_t GetUsage() const { return mArena.GetUsage(); }
+
+		// returns the highest usage since the last reset
+		inline size_t GetPeakUsage() const { return mArena.GetPeak(); }
+
+		// returns how many allocations didn't fit the buffer since the last reset
+		inline uint32_t GetOverflowCount() const { return mOverflows; }
+
+		// returns how many bytes were requested by the allocations that didn't fit the buffer since the last reset
+		inline size_t GetOverflowBytes() const { return mOverflowBytes; }
+
+		// resets the peak usage and overflow counters
+		inline void ResetStatistics() { mArena.ResetStatistics(); mOverflows = 0; mOverflowBytes = 0; }
+
+	public:
+
+		// allocates memory, it must be freed in reverse order
+		virtual void* Allocate(JPH::uint size) override;
+
+		// frees memory, it must be the last allocation
+		virtual void Free(void* address, JPH::uint size) override;
+
+	private:
+
+		LinearArena mArena;
+		uint32_t mOverflows = 0;
+		size_t mOverflowBytes = 0;
+	};
+}
\ No newline at end of file
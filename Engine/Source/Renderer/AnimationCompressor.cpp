@@ -0,0 +1,190 @@
+#include "epch.h"
+#include "AnimationCompressor.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Cosmos::AnimationCompressor
+{
+	// the three smallest components of an unit quaternion lie within plus and minus this
+	constexpr float SmallestThreeRange = 0.70710678f;
+
+	// keys are removed against at most this many previous ones, keeping long constant runs linear to reduce
+	constexpr size_t MaxReductionWindow = 256;
+
+	// returns the largest component difference, rotations are compared on the same hemisphere
+	static float Difference(const glm::vec4& a, const glm::vec4& b, bool rotation)
+	{
+		glm::vec4 diff = glm::abs(a - b);
+		float result = std::max(std::max(diff.x, diff.y), std::max(diff.z, diff.w));
+
+		if (rotation)
+		{
+			glm::vec4 flipped = glm::abs(a + b);
+			result = std::min(result, std::max(std::max(flipped.x, flipped.y), std::max(flipped.z, flipped.w)));
+		}
+
+		return result;
+	}
+
+	// interpolates two keys the same way the samplers do
+	static glm::vec4 Interpolate(const glm::vec4& a, const glm::vec4& b, float u, bool rotation)
+	{
+		if (!rotation)
+			return glm::mix(a, b, u);
+
+		glm::quat q = glm::normalize(glm::slerp(glm::quat(a.w, a.x, a.y, a.z), glm::quat(b.w, b.x, b.y, b.z), u));
+		return glm::vec4(q.x, q.y, q.z, q.w);
+	}
+
+	glm::vec4 Track::Decode(size_t key) const
+	{
+		const uint16_t* packed = &keys[key * 4];
+		glm::vec4 value;
+
+#if defined COSMOS_SIMD_SSE2
+		__m128i integers = _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i*)packed), _mm_setzero_si128());
+		__m128 result = _mm_add_ps(_mm_loadu_ps(&rangeMin[0]), _mm_mul_ps(_mm_cvtepi32_ps(integers), _mm_loadu_ps(&rangeScale[0])));
+		_mm_storeu_ps(&value[0], result);
+#else
+		value = rangeMin + glm::vec4(packed[0], packed[1], packed[2], packed[3]) * rangeScale;
+#endif
+
+		if (!rotation)
+			return value;
+
+		// the largest component is positive, the quaternion's sign was chosen when encoding
+		uint32_t largest = packed[3] & 3;
+		float squared = value.x * value.x + value.y * value.y + value.z * value.z;
+		float components[3] = { value.x, value.y, value.z };
+		glm::vec4 rotationValue;
+
+		for (uint32_t i = 0, j = 0; i < 4; i++)
+		{
+			rotationValue[i] = i == largest ? std::sqrt(std::max(0.0f, 1.0f - squared)) : components[j++];
+		}
+
+		return rotationValue;
+	}
+
+	void ReduceKeys(std::vector<float>& times, std::vector<glm::vec4>& values, float tolerance, bool rotation, bool step)
+	{
+		size_t count = std::min(times.size(), values.size());
+
+		if (count <= 2)
+			return;
+
+		std::vector<size_t> kept = { 0 };
+		size_t anchor = 0;
+
+		for (size_t i = 1; i + 1 < count; i++)
+		{
+			bool removable = i - anchor < MaxReductionWindow;
+
+			// every key between the anchor and this one is already equal to the anchor
+			if (step)
+			{
+				removable = removable && Difference(values[i], values[anchor], rotation) <= tolerance;
+			}
+
+			// the segment from the anchor to the next key must still pass through every key it would replace
+			else
+			{
+				float duration = times[i + 1] - times[anchor];
+
+				for (size_t j = anchor + 1; j <= i && removable; j++)
+				{
+					float u = duration > 0.0f ? (times[j] - times[anchor]) / duration : 0.0f;
+					removable = Difference(Interpolate(values[anchor], values[i + 1], u, rotation), values[j], rotation) <= tolerance;
+				}
+			}
+
+			if (!removable)
+			{
+				kept.push_back(i);
+				anchor = i;
+			}
+		}
+
+		kept.push_back(count - 1);
+
+		for (size_t i = 0; i < kept.size(); i++)
+		{
+			times[i] = times[kept[i]];
+			values[i] = values[kept[i]];
+		}
+
+		times.resize(kept.size());
+		values.resize(kept.size());
+	}
+
+	Track Quantize(const std::vector<glm::vec4>& values, bool rotation)
+	{
+		Track track = {};
+		track.rotation = rotation;
+		track.keys.resize(values.size() * 4);
+
+		if (values.empty())
+			return track;
+
+		if (rotation)
+		{
+			track.rangeMin = glm::vec4(-SmallestThreeRange, -SmallestThreeRange, -SmallestThreeRange, 0.0f);
+			track.rangeScale = glm::vec4(glm::vec3(2.0f * SmallestThreeRange / 65535.0f), 1.0f);
+
+			for (size_t k = 0; k < values.size(); k++)
+			{
+				glm::vec4 q = values[k];
+				uint32_t largest = 0;
+
+				for (uint32_t i = 1; i < 4; i++)
+				{
+					if (std::abs(q[i]) > std::abs(q[largest]))
+						largest = i;
+				}
+
+				// q and -q are the same rotation, the dropped component is made positive
+				if (q[largest] < 0.0f)
+				{
+					q = -q;
+				}
+
+				for (uint32_t i = 0, j = 0; i < 4; i++)
+				{
+					if (i == largest)
+						continue;
+
+					float normalized = (glm::clamp(q[i], -SmallestThreeRange, SmallestThreeRange) + SmallestThreeRange) / (2.0f * SmallestThreeRange);
+					track.keys[k * 4 + j++] = (uint16_t)std::lround(normalized * 65535.0f);
+				}
+
+				track.keys[k * 4 + 3] = (uint16_t)largest;
+			}
+
+			return track;
+		}
+
+		glm::vec4 rangeMax = values[0];
+		track.rangeMin = values[0];
+
+		for (const glm::vec4& value : values)
+		{
+			track.rangeMin = glm::min(track.rangeMin, value);
+			rangeMax = glm::max(rangeMax, value);
+		}
+
+		glm::vec4 extent = rangeMax - track.rangeMin;
+		track.rangeScale = extent / 65535.0f;
+
+		for (size_t k = 0; k < values.size(); k++)
+		{
+			for (uint32_t i = 0; i < 4; i++)
+			{
+				float normalized = extent[i] > 0.0f ? (values[k][i] - track.rangeMin[i]) / extent[i] : 0.0f;
+				track.keys[k * 4 + i] = (uint16_t)std::lround(glm::clamp(normalized, 0.0f, 1.0f) * 65535.0f);
+			}
+		}
+
+		return track;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "Util/Math.h"
+
+#include <cstdint>
+#include <vector>
+
+// import time compression of animation tracks, keys are reduced and quantized to 8 bytes each
+namespace Cosmos::AnimationCompressor
+{
+	// largest error allowed when removing keys, in the units of the track
+	struct Tolerance
+	{
+		float translation = 0.0005f;	// half a millimeter on meter scaled models
+		float rotation = 0.0005f;		// per quaternion component, a few hundredths of a degree
+		float scale = 0.0005f;
+	};
+
+	// a compressed linear or step track, every key is four 16-bit values so a key is dequantized by one simd conversion
+	// vector keys are quantized against the track's range, rotation keys are smallest-three encoded with the largest component's index last
+	struct Track
+	{
+		std::vector<uint16_t> keys = {};				// four per key
+		glm::vec4 rangeMin = glm::vec4(0.0f);
+		glm::vec4 rangeScale = glm::vec4(0.0f);		// extent of the range over 65535
+		bool rotation = false;
+
+		// returns how many keys the track has
+		inline size_t GetKeyCount() const { return keys.size() / 4; }
+
+		// returns the bytes the track uses
+		inline size_t GetSize() const { return keys.size() * sizeof(uint16_t); }
+
+		// decodes a key, rotations are returned as x, y, z, w
+		glm::vec4 Decode(size_t key) const;
+	};
+
+	// removes the keys it's neighbours interpolate within the tolerance, the first and last keys are always kept
+	// rotations are compared after aligning their hemispheres, step tracks only lose keys repeating the previous one
+	void ReduceKeys(std::vector<float>& times, std::vector<glm::vec4>& values, float tolerance, bool rotation, bool step);
+
+	// quantizes the values into a track, rotations must be normalized
+	Track Quantize(const std::vector<glm::vec4>& values, bool rotation);
+}
\ No newline at end of file
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+
+// baked animation blob (.cvat), the joint palettes of every clip sampled at a fixed rate, cooked from a loaded mesh
+// layout: header | clip table | palettes, every section starts 16 bytes aligned
+// a palette row is a frame, every joint is it's matrix's first three rows so a row is joint count * 3 texels of four floats
+namespace Cosmos::AnimationFormat
+{
+	constexpr uint32_t Magic = 0x54415643;	// "CVAT"
+	constexpr uint32_t Version = 1;
+	constexpr uint32_t SectionAlignment = 16;
+	constexpr uint32_t NameMaxChars = 64;
+	constexpr uint32_t TexelsPerJoint = 3;
+
+	struct Header
+	{
+		uint32_t magic = Magic;
+		uint32_t version = Version;
+		uint32_t jointCount = 0;
+		uint32_t frameCount = 0;				// frames of every clip together, the rows of the texture
+		uint32_t clipCount = 0;
+		float framerate = 30.0f;
+		uint64_t clipsOffset = 0;
+		uint64_t palettesOffset = 0;
+	};
+
+	struct Clip
+	{
+		uint32_t firstFrame = 0;
+		uint32_t frameCount = 0;				// the last frame is the clip's end, looping clips wrap before it
+		float duration = 0.0f;
+		uint32_t reserved = 0;
+		char name[NameMaxChars] = {};
+	};
+
+	static_assert(sizeof(Header) == 40, "Animation format header must not have padding");
+	static_assert(sizeof(Clip) == 80, "Animation format clip must not have padding");
+
+	// rounds an offset up to the section alignment
+	constexpr uint64_t AlignSection(uint64_t offset)
+	{
+		return (offset + SectionAlignment - 1) & ~(uint64_t)(SectionAlignment - 1);
+	}
+}
\ No newline at end of file
@@ -11,6 +11,15 @@ namespace Cosmos
 		alignas(16)glm::mat4 model = glm::mat4(1.0f);
 	};
 
+	// per-instance data of the meshes, entities sharing a mesh are drawn together reading theirs by the instance index
+	struct InstanceData
+	{
+		alignas(16) glm::mat4 model = glm::mat4(1.0f);
+		alignas(4) uint32_t id = 0;
+		alignas(4) uint32_t palette = 0;	// first matrix of the entity's joint palette, skinned meshes only
+		alignas(4) float frame = 0.0f;		// row of the baked animation texture, fractions blend with the next row, baked meshes only
+	};
+
 	// contains the camera's view, projection, view * projection and front
 	struct CameraBuffer
 	{
@@ -16,5 +16,14 @@ namespace Cosmos
 #endif
 	}
 
+	bool Mesh::Cook(std::string source, std::string destination)
+	{
+#if defined COSMOS_RENDERER_VULKAN
+		return Vulkan::VKMesh::Cook(source, destination);
+#else
+		return false;
+#endif
+	}
+
 
 }
\ No newline at end of file
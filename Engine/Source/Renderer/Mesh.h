@@ -31,11 +31,40 @@ namespace Cosmos
 			glm::vec3 max = glm::vec3(-FLT_MAX);
 		};
 
+		// per-entity pose of the mesh's node hierarchy, evaluated by the animation system
+		struct Pose
+		{
+			std::vector<glm::vec3> translations = {};
+			std::vector<glm::quat> rotations = {};
+			std::vector<glm::vec3> scales = {};
+			std::vector<glm::mat4> globals = {};	// global matrix of every node
+			std::vector<uint32_t> cursors = {};		// last keyframe of every channel, sequential playback doesn't search for them
+			uint32_t clip = UINT32_MAX;				// clip the pose was last evaluated with, another one starts again from the rest pose
+		};
+
+		// how long the cpu copy of the vertices is kept once they're on the gpu, only physics cooking and picking read it
+		enum class Residency : uint8_t
+		{
+			Resident = 0,	// kept for the mesh's lifetime
+			Released,		// dropped after the upload, vertex views are empty from then on
+			OnDemand		// cooked meshes drop it after the upload and map their file again when viewed, gltf ones keep it since they'd be parsed again
+		};
+
+		// per-entity state of a mesh shared between entities, kept by the entity's component
+		struct Instance
+		{
+			bool wiredframe = false;				// render mode, wiredframe/fill
+			Shared<Texture2D> colormap;				// overrides the material's colormap if set
+		};
+
 	public:
 
-		// returns a smart-ptr to a new mesh
+		// returns a smart-ptr to a new mesh, entities should load theirs from the renderer's MeshLibrary to share it
 		static Shared<Mesh> Create(Shared<Renderer> renderer);
 
+		// cooks a gltf/glb file into the engine mesh format (.cmesh), loaded without parsing
+		static bool Cook(std::string source, std::string destination);
+
 		// destructor
 		~Mesh() = default;
 
@@ -45,19 +74,25 @@ namespace Cosmos
 		// returns if the mesh is fully loaded
 		virtual bool IsLoaded() const = 0;
 
-		// gets the render mode to wiredframe/fill
-		virtual bool* GetWiredframe() = 0;
+		// returns a view of the mesh's vertices without copying them, on-demand meshes read them back first
+		virtual VertexView GetVertexView() = 0;
 
-		// returns the vector of vertices of the mesh
-		virtual std::vector<Vertex> GetVertices() const = 0;
+		// returns the residency policy of the cpu copy of the vertices
+		virtual Residency GetResidency() const = 0;
+
+		// modifies the residency policy, released and on-demand meshes drop their copy at once
+		virtual void SetResidency(Residency residency) = 0;
+
+		// drops the cpu copy of the vertices until they're viewed again, resident meshes and on-demand gltf ones keep theirs
+		virtual void ReleaseVertices() = 0;
 
 	public:
 
 		// updates the mesh logic
 		virtual void OnUpdate(float timestep) = 0;
 
-		// draws the mesh
-		virtual void OnRender(void* commandBuffer, glm::mat4& transform, uint32_t id) = 0;
+		// draws instanceCount entities sharing the same state at once, their transforms and ids are read from the renderer's instance data
+		virtual void OnRender(void* commandBuffer, uint32_t firstInstance, uint32_t instanceCount, const Instance& instance) = 0;
 
 		// loads the model from a filepath
 		virtual void LoadFromFile(std::string filepath, float scale = 1.0f) = 0;
@@ -65,12 +100,49 @@ namespace Cosmos
 		// returns the mesh dimension
 		virtual Dimension GetDimension() const = 0;
 
+		// returns the bounds instances are culled against, skinned meshes inflate the dimension to fit every pose of their clips
+		virtual Dimension GetCullingDimension() const = 0;
+
 	public: // materials
 
-		// modifies the mesh material's colormap
+		// modifies the mesh material's colormap, affecting every entity sharing the mesh
 		virtual void SetColormapTexture(std::string filepath) = 0;
 		
 		// returns the colormap texture used by the material's mesh
 		virtual Shared<Texture2D> GetColormapTexture() = 0;
+
+	public: // animations
+
+		// returns how many animation clips the mesh has
+		virtual uint32_t GetAnimationCount() const = 0;
+
+		// returns the length of a clip in seconds, zero if it doesn't exist
+		virtual float GetAnimationDuration(uint32_t clip) const = 0;
+
+		// evaluates a clip's time into a pose, it doesn't modify the mesh so poses are evaluated in parallel
+		virtual void Animate(uint32_t clip, float time, Pose& pose) const = 0;
+
+		// interpolates two poses of the mesh into a third one, weight zero is from and one is to
+		virtual void BlendPoses(const Pose& from, const Pose& to, float weight, Pose& result) const = 0;
+
+		// returns how many matrices the joint palette of the mesh has, zero if it isn't skinned
+		virtual uint32_t GetJointCount() const = 0;
+
+		// writes the skinning matrices of a pose into a palette with room for the joint count
+		virtual void WritePalette(const Pose& pose, glm::mat4* palette) const = 0;
+
+	public: // baked animations
+
+		// bakes the joint palettes of every clip sampled at a framerate into a file (.cvat), the mesh must be loaded and use the skinned vertex layout
+		virtual bool BakeAnimations(std::string destination, float framerate = 30.0f) const = 0;
+
+		// loads baked animations, from then on the mesh is drawn posed by them and entities are no longer animated by the cpu, skinned vertex layout only
+		virtual bool LoadBakedAnimations(std::string filepath) = 0;
+
+		// returns if the mesh is drawn with baked animations
+		virtual bool HasBakedAnimations() const = 0;
+
+		// returns the frame a clip's time is drawn with, for the renderer's instance data
+		virtual float GetBakedFrame(uint32_t clip, float time) const = 0;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "Vertex.h"
+
+#include <cstdint>
+
+// engine-native mesh blob (.cmesh), cooked offline from gltf and memory-mapped at runtime
+// layout: header | node table | primitive table | vertex stream | index stream, every section starts 16 bytes aligned
+namespace Cosmos::MeshFormat
+{
+	constexpr uint32_t Magic = 0x48534D43;	// "CMSH"
+	constexpr uint32_t Version = 5;			// 4 could store skinned meshes on the full layout, 3 could truncate 16 bit indices
+	constexpr uint32_t SectionAlignment = 16;
+	constexpr uint32_t NameMaxChars = 64;
+
+	struct Header
+	{
+		uint32_t magic = Magic;
+		uint32_t version = Version;
+		uint32_t vertexSize = sizeof(Vertex);	// stride of the vertex layout, a different size requires cooking again
+		uint32_t indexSize = sizeof(uint32_t);	// 2 if every index fits 16 bits, 4 otherwise
+		uint32_t nodeCount = 0;
+		uint32_t primitiveCount = 0;
+		uint32_t vertexCount = 0;
+		uint32_t indexCount = 0;
+		uint64_t nodesOffset = 0;
+		uint64_t primitivesOffset = 0;
+		uint64_t verticesOffset = 0;
+		uint64_t indicesOffset = 0;
+		float boundsMin[3] = {};				// bounds of the whole mesh with the node transforms applied
+		float boundsMax[3] = {};
+		uint32_t vertexLayout = (uint32_t)VertexLayout::Full;	// the vertex stream is uploaded on this layout as it is
+		uint32_t reserved = 0;
+	};
+
+	// nodes are listed parents first
+	struct Node
+	{
+		int32_t parent = -1;					// index on the node table, -1 for root nodes
+		uint32_t index = 0;						// index of the node on the gltf file
+		int32_t mesh = -1;						// -1 if the node has no mesh
+		uint32_t firstPrimitive = 0;			// index on the primitive table
+		uint32_t primitiveCount = 0;
+		float translation[3] = {};
+		float rotation[4] = { 0.0f, 0.0f, 0.0f, 1.0f };	// quaternion, xyzw
+		float scale[3] = { 1.0f, 1.0f, 1.0f };
+		float matrix[16] = {};
+		char name[NameMaxChars] = {};
+	};
+
+	struct Primitive
+	{
+		uint32_t firstIndex = 0;				// indices are relative to vertexStart, it's drawn as the base vertex
+		uint32_t indexCount = 0;
+		uint32_t vertexStart = 0;
+		uint32_t vertexCount = 0;
+		float boundsMin[3] = {};
+		float boundsMax[3] = {};
+	};
+
+	static_assert(sizeof(Header) == 96, "Mesh format header must not have padding");
+	static_assert(sizeof(Node) == 188, "Mesh format node must not have padding");
+	static_assert(sizeof(Primitive) == 40, "Mesh format primitive must not have padding");
+
+	// rounds an offset up to the section alignment
+	constexpr uint64_t AlignSection(uint64_t offset)
+	{
+		return (offset + SectionAlignment - 1) & ~(uint64_t)(SectionAlignment - 1);
+	}
+}
\ No newline at end of file
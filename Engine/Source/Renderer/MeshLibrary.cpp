@@ -0,0 +1,87 @@
+#include "epch.h"
+#include "MeshLibrary.h"
+
+#include <filesystem>
+#include <system_error>
+
+namespace Cosmos
+{
+	Shared<Mesh> MeshLibrary::Load(Shared<Renderer> renderer, std::string filepath, float scale)
+	{
+		// different spellings of the same file share the mesh, the scale is baked into it
+		std::error_code error;
+		std::filesystem::path canonical = std::filesystem::weakly_canonical(filepath, error);
+		std::string key = (error ? filepath : canonical.string()) + "@" + std::to_string(scale);
+
+		uint64_t contentStamp = GetContentStamp(filepath);
+		auto it = mEntries.find(key);
+
+		if (it != mEntries.end())
+		{
+			if (Shared<Mesh> mesh = it->second.mesh.lock())
+			{
+				if (it->second.contentStamp == contentStamp)
+					return mesh;
+
+				// entities keep the previous version until they load the file again, it must still be updated for them
+				mOutdated.push_back(mesh);
+			}
+		}
+
+		Shared<Mesh> mesh = Mesh::Create(renderer);
+		mesh->LoadFromFile(filepath, scale);
+
+		mEntries[key] = { mesh, contentStamp };
+		return mesh;
+	}
+
+	void MeshLibrary::OnUpdate(float timestep)
+	{
+		for (auto it = mEntries.begin(); it != mEntries.end();)
+		{
+			Shared<Mesh> mesh = it->second.mesh.lock();
+
+			// no entity uses the mesh anymore, it was already released
+			if (mesh == nullptr)
+			{
+				it = mEntries.erase(it);
+				continue;
+			}
+
+			mesh->OnUpdate(timestep);
+			it++;
+		}
+
+		for (size_t i = 0; i < mOutdated.size();)
+		{
+			Shared<Mesh> mesh = mOutdated[i].lock();
+
+			if (mesh == nullptr)
+			{
+				mOutdated[i] = mOutdated.back();
+				mOutdated.pop_back();
+				continue;
+			}
+
+			mesh->OnUpdate(timestep);
+			i++;
+		}
+	}
+
+	uint64_t MeshLibrary::GetContentStamp(const std::string& filepath)
+	{
+		// size and write time stand for the contents, hashing them would read every file on the main thread
+		std::error_code error;
+		uint64_t size = (uint64_t)std::filesystem::file_size(filepath, error);
+
+		if (error)
+			return 0;
+
+		uint64_t writeTime = (uint64_t)std::filesystem::last_write_time(filepath, error).time_since_epoch().count();
+
+		if (error)
+			return 0;
+
+		return size ^ (writeTime + 0x9E3779B97F4A7C15ull + (size << 6) + (size >> 2));
+	}
+}
\ No newline at end of file
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "Mesh.h"
+#include "Util/Memory.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Cosmos
+{
+	// forward declarations
+	class Renderer;
+
+	// meshes are shared between every entity loading the same file, geometry, nodes, skins and animations exist once
+	// the library doesn't own them, a mesh is released once no entity uses it
+	class MeshLibrary
+	{
+	public:
+
+		// constructor
+		MeshLibrary() = default;
+
+		// destructor
+		~MeshLibrary() = default;
+
+		// returns how many meshes are cached, including released ones not yet pruned
+		inline size_t GetCount() const { return mEntries.size(); }
+
+	public:
+
+		// returns the mesh of a file, it's only loaded if not cached or if the file changed since it was
+		Shared<Mesh> Load(Shared<Renderer> renderer, std::string filepath, float scale = 1.0f);
+
+		// updates every cached mesh once, regardless of how many entities use it, including the outdated ones still in use
+		void OnUpdate(float timestep);
+
+	private:
+
+		// returns a stamp of the file contents, it changes whenever the file is written
+		static uint64_t GetContentStamp(const std::string& filepath);
+
+	private:
+
+		struct Entry
+		{
+			std::weak_ptr<Mesh> mesh;
+			uint64_t contentStamp = 0;
+		};
+
+		std::unordered_map<std::string, Entry> mEntries = {};
+		std::vector<std::weak_ptr<Mesh>> mOutdated = {};	// replaced by a newer version of their file but still used by entities
+	};
+}
\ No newline at end of file
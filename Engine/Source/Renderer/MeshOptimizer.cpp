@@ -0,0 +1,389 @@
+#include "epch.h"
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace Cosmos::MeshOptimizer
+{
+	// cache the triangle scores are computed for, larger than the measured one so vertices age out smoothly
+	constexpr uint32_t ScoringCacheSize = 32;
+
+	// returns the score of a vertex given it's position on the cache and how many triangles still use it
+	static float GetVertexScore(int32_t cachePosition, uint32_t valence)
+	{
+		if (valence == 0)
+			return -1.0f;
+
+		float score = 0.0f;
+
+		// the last triangle's vertices get a fixed score, so it's not favoured to reuse them on the next one
+		if (cachePosition >= 0 && cachePosition < 3)
+		{
+			score = 0.75f;
+		}
+
+		else if (cachePosition >= 3)
+		{
+			const float scaler = 1.0f / (float)(ScoringCacheSize - 3);
+			score = std::pow(1.0f - (float)(cachePosition - 3) * scaler, 1.5f);
+		}
+
+		// vertices with few triangles left are finished first, avoiding lone triangles later on
+		return score + 2.0f / std::sqrt((float)valence);
+	}
+
+	// simulates a fifo cache where a vertex is evicted after CacheSize newer ones, returns if the vertex had to be transformed
+	static bool CacheMiss(std::vector<uint32_t>& timestamps, uint32_t& timestamp, uint32_t index)
+	{
+		if (timestamp - timestamps[index] > CacheSize)
+		{
+			timestamps[index] = timestamp++;
+			return true;
+		}
+
+		return false;
+	}
+
+	uint32_t CountCacheMisses(const uint32_t* indices, uint32_t indexCount, uint32_t vertexCount)
+	{
+		std::vector<uint32_t> timestamps(vertexCount, 0);
+		uint32_t timestamp = CacheSize + 1;
+		uint32_t misses = 0;
+
+		for (uint32_t i = 0; i < indexCount; i++)
+		{
+			if (CacheMiss(timestamps, timestamp, indices[i]))
+				misses++;
+		}
+
+		return misses;
+	}
+
+	uint32_t WeldVertices(Vertex* vertices, uint32_t vertexCount, uint32_t* indices, uint32_t indexCount)
+	{
+		// open addressing table of welded vertices, at most half full
+		uint32_t tableSize = 1;
+		while (tableSize < vertexCount * 2) tableSize *= 2;
+
+		std::vector<uint32_t> table(tableSize, UINT32_MAX);
+		std::vector<uint32_t> remap(vertexCount);
+		uint32_t uniqueCount = 0;
+
+		for (uint32_t v = 0; v < vertexCount; v++)
+		{
+			// fnv-1a over the vertex bytes, vertices equal with different bytes (like -0.0 and 0.0) are just not welded
+			const uint8_t* bytes = (const uint8_t*)&vertices[v];
+			uint32_t hash = 2166136261u;
+
+			for (size_t b = 0; b < sizeof(Vertex); b++)
+			{
+				hash = (hash ^ bytes[b]) * 16777619u;
+			}
+
+			uint32_t slot = hash & (tableSize - 1);
+
+			while (table[slot] != UINT32_MAX && !(vertices[table[slot]] == vertices[v]))
+			{
+				slot = (slot + 1) & (tableSize - 1);
+			}
+
+			if (table[slot] == UINT32_MAX)
+			{
+				// unique vertices are compacted in place, the destination never passes the source
+				vertices[uniqueCount] = vertices[v];
+				table[slot] = uniqueCount;
+				uniqueCount++;
+			}
+
+			remap[v] = table[slot];
+		}
+
+		for (uint32_t i = 0; i < indexCount; i++)
+		{
+			indices[i] = remap[indices[i]];
+		}
+
+		return uniqueCount;
+	}
+
+	void OptimizeVertexCache(uint32_t* indices, uint32_t indexCount, uint32_t vertexCount)
+	{
+		const uint32_t triangleCount = indexCount / 3;
+
+		if (triangleCount == 0)
+			return;
+
+		// triangles using each vertex, used ones are swapped out of the vertex's range
+		std::vector<uint32_t> valence(vertexCount, 0);
+		std::vector<uint32_t> adjacencyOffset(vertexCount + 1, 0);
+		std::vector<uint32_t> adjacency(indexCount);
+
+		for (uint32_t i = 0; i < indexCount; i++)
+		{
+			valence[indices[i]]++;
+		}
+
+		for (uint32_t v = 0; v < vertexCount; v++)
+		{
+			adjacencyOffset[v + 1] = adjacencyOffset[v] + valence[v];
+		}
+
+		std::vector<uint32_t> fill(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+
+		for (uint32_t i = 0; i < indexCount; i++)
+		{
+			adjacency[fill[indices[i]]++] = i / 3;
+		}
+
+		std::vector<int32_t> cachePosition(vertexCount, -1);
+		std::vector<float> vertexScore(vertexCount);
+		std::vector<bool> emitted(triangleCount, false);
+
+		for (uint32_t v = 0; v < vertexCount; v++)
+		{
+			vertexScore[v] = GetVertexScore(-1, valence[v]);
+		}
+
+		// starts from the best scored triangle of the whole list
+		uint32_t bestTriangle = 0;
+		float bestScore = -FLT_MAX;
+
+		for (uint32_t t = 0; t < triangleCount; t++)
+		{
+			float score = vertexScore[indices[t * 3 + 0]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+
+			if (score > bestScore)
+			{
+				bestScore = score;
+				bestTriangle = t;
+			}
+		}
+
+		std::vector<uint32_t> result;
+		result.reserve(indexCount);
+
+		uint32_t cache[ScoringCacheSize + 3] = {};
+		uint32_t cacheCount = 0;
+		uint32_t inputCursor = 0;
+
+		while (bestTriangle != UINT32_MAX)
+		{
+			emitted[bestTriangle] = true;
+
+			uint32_t newCache[ScoringCacheSize + 3] = {};
+			uint32_t newCacheCount = 0;
+
+			// the triangle's vertices go to the front of the cache, they no longer reference it
+			for (uint32_t k = 0; k < 3; k++)
+			{
+				uint32_t vertex = indices[bestTriangle * 3 + k];
+				result.push_back(vertex);
+
+				uint32_t* begin = &adjacency[adjacencyOffset[vertex]];
+				uint32_t* end = begin + valence[vertex];
+				uint32_t* found = std::find(begin, end, bestTriangle);
+
+				if (found != end)
+				{
+					std::swap(*found, *(end - 1));
+					valence[vertex]--;
+				}
+
+				if (std::find(newCache, newCache + newCacheCount, vertex) == newCache + newCacheCount)
+				{
+					newCache[newCacheCount++] = vertex;
+				}
+			}
+
+			for (uint32_t i = 0; i < cacheCount; i++)
+			{
+				if (std::find(newCache, newCache + newCacheCount, cache[i]) == newCache + newCacheCount)
+				{
+					newCache[newCacheCount++] = cache[i];
+				}
+			}
+
+			// vertices pushed past the end of the cache lose their cache score
+			for (uint32_t i = 0; i < newCacheCount; i++)
+			{
+				uint32_t vertex = newCache[i];
+				cachePosition[vertex] = i < ScoringCacheSize ? (int32_t)i : -1;
+				vertexScore[vertex] = GetVertexScore(cachePosition[vertex], valence[vertex]);
+			}
+
+			cacheCount = std::min(newCacheCount, ScoringCacheSize);
+			memcpy(cache, newCache, cacheCount * sizeof(uint32_t));
+
+			// only triangles touching the cache had their score changed, the best is searched among them
+			bestTriangle = UINT32_MAX;
+			bestScore = -1.0f;
+
+			for (uint32_t i = 0; i < cacheCount; i++)
+			{
+				uint32_t vertex = cache[i];
+
+				for (uint32_t a = 0; a < valence[vertex]; a++)
+				{
+					uint32_t triangle = adjacency[adjacencyOffset[vertex] + a];
+					float score = vertexScore[indices[triangle * 3 + 0]] + vertexScore[indices[triangle * 3 + 1]] + vertexScore[indices[triangle * 3 + 2]];
+
+					if (score > bestScore)
+					{
+						bestScore = score;
+						bestTriangle = triangle;
+					}
+				}
+			}
+
+			// the cache has nothing left to offer, continue from the next triangle in input order
+			if (bestTriangle == UINT32_MAX)
+			{
+				while (inputCursor < triangleCount && emitted[inputCursor]) inputCursor++;
+
+				if (inputCursor < triangleCount)
+					bestTriangle = inputCursor;
+			}
+		}
+
+		memcpy(indices, result.data(), result.size() * sizeof(uint32_t));
+	}
+
+	void OptimizeOverdraw(uint32_t* indices, uint32_t indexCount, const Vertex* vertices, uint32_t vertexCount)
+	{
+		const uint32_t triangleCount = indexCount / 3;
+
+		if (triangleCount == 0)
+			return;
+
+		// clusters start where every vertex of a triangle missed the cache, moving them around doesn't hurt cache reuse
+		std::vector<uint32_t> clusters = { 0 };
+		std::vector<uint32_t> timestamps(vertexCount, 0);
+		uint32_t timestamp = CacheSize + 1;
+
+		for (uint32_t t = 0; t < triangleCount; t++)
+		{
+			uint32_t triangleMisses = 0;
+
+			for (uint32_t k = 0; k < 3; k++)
+			{
+				if (CacheMiss(timestamps, timestamp, indices[t * 3 + k]))
+					triangleMisses++;
+			}
+
+			if (t > 0 && triangleMisses == 3)
+			{
+				clusters.push_back(t);
+			}
+		}
+
+		if (clusters.size() == 1)
+			return;
+
+		// area weighted centroid of the mesh and of each cluster, with the cluster's average normal
+		struct Cluster
+		{
+			uint32_t start = 0;
+			uint32_t count = 0;
+			float sortKey = 0.0f;
+		};
+
+		std::vector<Cluster> sorted(clusters.size());
+		std::vector<glm::vec3> centroids(clusters.size(), glm::vec3(0.0f));
+		std::vector<glm::vec3> normals(clusters.size(), glm::vec3(0.0f));
+		glm::vec3 meshCentroid = glm::vec3(0.0f);
+		float meshArea = 0.0f;
+
+		for (size_t c = 0; c < clusters.size(); c++)
+		{
+			sorted[c].start = clusters[c];
+			sorted[c].count = (c + 1 < clusters.size() ? clusters[c + 1] : triangleCount) - clusters[c];
+
+			float clusterArea = 0.0f;
+
+			for (uint32_t t = sorted[c].start; t < sorted[c].start + sorted[c].count; t++)
+			{
+				const glm::vec3& p0 = vertices[indices[t * 3 + 0]].position;
+				const glm::vec3& p1 = vertices[indices[t * 3 + 1]].position;
+				const glm::vec3& p2 = vertices[indices[t * 3 + 2]].position;
+
+				glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+				float area = glm::length(normal);
+				glm::vec3 center = (p0 + p1 + p2) / 3.0f;
+
+				centroids[c] += center * area;
+				normals[c] += normal;
+				clusterArea += area;
+			}
+
+			meshCentroid += centroids[c];
+			meshArea += clusterArea;
+			centroids[c] = clusterArea > 0.0f ? centroids[c] / clusterArea : centroids[c];
+		}
+
+		meshCentroid = meshArea > 0.0f ? meshCentroid / meshArea : meshCentroid;
+
+		for (size_t c = 0; c < clusters.size(); c++)
+		{
+			float length = glm::length(normals[c]);
+			sorted[c].sortKey = length > 0.0f ? glm::dot(centroids[c] - meshCentroid, normals[c] / length) : 0.0f;
+		}
+
+		// outward facing clusters are more likely to occlude the others
+		std::stable_sort(sorted.begin(), sorted.end(), [](const Cluster& a, const Cluster& b) { return a.sortKey > b.sortKey; });
+
+		std::vector<uint32_t> result;
+		result.reserve(indexCount);
+
+		for (const Cluster& cluster : sorted)
+		{
+			result.insert(result.end(), indices + cluster.start * 3, indices + (cluster.start + cluster.count) * 3);
+		}
+
+		memcpy(indices, result.data(), result.size() * sizeof(uint32_t));
+	}
+
+	uint32_t OptimizeVertexFetch(Vertex* vertices, uint32_t vertexCount, uint32_t* indices, uint32_t indexCount)
+	{
+		std::vector<uint32_t> remap(vertexCount, UINT32_MAX);
+		std::vector<Vertex> reordered;
+		reordered.reserve(vertexCount);
+
+		for (uint32_t i = 0; i < indexCount; i++)
+		{
+			uint32_t& index = indices[i];
+
+			if (remap[index] == UINT32_MAX)
+			{
+				remap[index] = (uint32_t)reordered.size();
+				reordered.push_back(vertices[index]);
+			}
+
+			index = remap[index];
+		}
+
+		std::copy(reordered.begin(), reordered.end(), vertices);
+		return (uint32_t)reordered.size();
+	}
+
+	Statistics Optimize(Vertex* vertices, uint32_t& vertexCount, uint32_t* indices, uint32_t indexCount)
+	{
+		Statistics statistics = {};
+		statistics.triangleCount = indexCount / 3;
+		statistics.vertexCountBefore = vertexCount;
+		statistics.cacheMissesBefore = CountCacheMisses(indices, indexCount, vertexCount);
+
+		vertexCount = WeldVertices(vertices, vertexCount, indices, indexCount);
+		OptimizeVertexCache(indices, indexCount, vertexCount);
+		OptimizeOverdraw(indices, indexCount, vertices, vertexCount);
+		vertexCount = OptimizeVertexFetch(vertices, vertexCount, indices, indexCount);
+
+		statistics.vertexCountAfter = vertexCount;
+		statistics.cacheMissesAfter = CountCacheMisses(indices, indexCount, vertexCount);
+
+		return statistics;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "Vertex.h"
+
+#include <cstdint>
+
+// import time passes over a triangle list, indices are local to the vertices given
+namespace Cosmos::MeshOptimizer
+{
+	constexpr uint32_t CacheSize = 16;	// post-transform cache size the statistics are measured with
+
+	struct Statistics
+	{
+		uint32_t triangleCount = 0;
+		uint32_t vertexCountBefore = 0;
+		uint32_t vertexCountAfter = 0;
+		uint32_t cacheMissesBefore = 0;
+		uint32_t cacheMissesAfter = 0;
+
+		// returns the average cache miss ratio before the optimization, transformed vertices per triangle
+		inline float GetACMRBefore() const { return triangleCount > 0 ? (float)cacheMissesBefore / (float)triangleCount : 0.0f; }
+
+		// returns the average cache miss ratio after the optimization
+		inline float GetACMRAfter() const { return triangleCount > 0 ? (float)cacheMissesAfter / (float)triangleCount : 0.0f; }
+
+		// accumulates the statistics of another triangle list
+		inline void Add(const Statistics& other)
+		{
+			triangleCount += other.triangleCount;
+			vertexCountBefore += other.vertexCountBefore;
+			vertexCountAfter += other.vertexCountAfter;
+			cacheMissesBefore += other.cacheMissesBefore;
+			cacheMissesAfter += other.cacheMissesAfter;
+		}
+	};
+
+	// returns how many vertices a fifo cache of CacheSize entries transforms to draw the triangles
+	uint32_t CountCacheMisses(const uint32_t* indices, uint32_t indexCount, uint32_t vertexCount);
+
+	// merges identical vertices and remaps the indices to them, returns the new vertex count
+	uint32_t WeldVertices(Vertex* vertices, uint32_t vertexCount, uint32_t* indices, uint32_t indexCount);
+
+	// reorders triangles to reuse the post-transform cache, linear-speed vertex cache optimization by Tom Forsyth
+	void OptimizeVertexCache(uint32_t* indices, uint32_t indexCount, uint32_t vertexCount);
+
+	// reorders clusters of triangles so the ones facing outwards are drawn first, occluding the rest
+	void OptimizeOverdraw(uint32_t* indices, uint32_t indexCount, const Vertex* vertices, uint32_t vertexCount);
+
+	// reorders vertices in the order they're first used, dropping unused ones, returns the new vertex count
+	uint32_t OptimizeVertexFetch(Vertex* vertices, uint32_t vertexCount, uint32_t* indices, uint32_t indexCount);
+
+	// runs every pass above in order, returning their statistics
+	Statistics Optimize(Vertex* vertices, uint32_t& vertexCount, uint32_t* indices, uint32_t indexCount);
+}
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "epch.h"
 #include "Renderer.h"
 
+#include "MeshLibrary.h"
 #include "Entity/Unique/Camera.h"
 #include "Vulkan/VKRenderer.h"
 
@@ -19,6 +20,7 @@ namespace Cosmos
 		: mApplication(application), mWindow(window)
 	{
 		mCamera = CreateShared<Camera>(window);
+		mMeshLibrary = CreateShared<MeshLibrary>();
 	}
 
 	void Renderer::OnUpdate()
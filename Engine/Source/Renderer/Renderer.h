@@ -1,6 +1,7 @@
 #include "Renderer.h"
 #pragma once
 
+#include "Util/Math.h"
 #include "Util/Memory.h"
 
 namespace Cosmos
@@ -9,6 +10,8 @@ namespace Cosmos
 	class Application;
 	class Camera;
 	class Event;
+	struct InstanceData;
+	class MeshLibrary;
 	class Window;
 
 	class Renderer
@@ -29,6 +32,9 @@ namespace Cosmos
 		// returns a smart-ptr to the camera
 		inline Shared<Camera> GetCamera() { return mCamera; }
 
+		// returns a smart-ptr to the library of meshes shared between entities
+		inline Shared<MeshLibrary> GetMeshLibrary() { return mMeshLibrary; }
+
 		// returns the current frame 
 		inline uint32_t GetCurrentFrame() const { return mCurrentFrame; }
 
@@ -46,6 +52,18 @@ namespace Cosmos
 		// event handling
 		virtual void OnEvent(Shared<Event> event);
 
+		// returns the current frame's instance data with room for count instances, it's written once per frame before drawing
+		virtual InstanceData* ReserveInstances(uint32_t count) = 0;
+
+		// returns the current frame's joint palettes with room for count matrices, instances index them by their palette offset
+		virtual glm::mat4* ReservePalettes(uint32_t count) = 0;
+
+		// returns if skinned meshes are skinned once per frame by a compute pre-pass
+		virtual bool IsComputeSkinning() const = 0;
+
+		// skins skinned meshes by a compute pre-pass and draws them as static ones, otherwise every vertex shader skins them
+		virtual void SetComputeSkinning(bool value) = 0;
+
 	public:
 
 		// if using a custom viewport, hint it's size into the renderer
@@ -57,6 +75,7 @@ namespace Cosmos
 		Shared<Window> mWindow;
 
 		Shared<Camera> mCamera;
+		Shared<MeshLibrary> mMeshLibrary;
 		uint32_t mCurrentFrame = 0;
 		uint32_t mImageIndex = 0;
 		const uint32_t mConcurrentlyRenderedFrames = 2;
@@ -0,0 +1,179 @@
+#include "epch.h"
+#include "Vertex.h"
+
+#include <glm/gtc/packing.hpp>
+#include <algorithm>
+#include <cstring>
+
+namespace Cosmos
+{
+    // maps an unit vector onto the [-1, 1] square of an octahedron, zero or missing normals are mapped to +z
+    static glm::vec2 EncodeOctahedral(glm::vec3 normal)
+    {
+        float sum = glm::abs(normal.x) + glm::abs(normal.y) + glm::abs(normal.z);
+
+        if (!(sum > 0.0f))
+            return glm::vec2(0.0f);
+
+        normal /= sum;
+        glm::vec2 encoded = glm::vec2(normal.x, normal.y);
+
+        // the lower hemisphere is folded over the diagonals
+        if (normal.z < 0.0f)
+        {
+            glm::vec2 signs = glm::vec2(encoded.x >= 0.0f ? 1.0f : -1.0f, encoded.y >= 0.0f ? 1.0f : -1.0f);
+            encoded = (1.0f - glm::abs(glm::vec2(encoded.y, encoded.x))) * signs;
+        }
+
+        return encoded;
+    }
+
+    // inverse of the octahedral mapping, mesh_packed.vert does the same
+    static glm::vec3 DecodeOctahedral(glm::vec2 encoded)
+    {
+        glm::vec3 normal = glm::vec3(encoded.x, encoded.y, 1.0f - glm::abs(encoded.x) - glm::abs(encoded.y));
+        float fold = glm::max(-normal.z, 0.0f);
+        normal.x += normal.x >= 0.0f ? -fold : fold;
+        normal.y += normal.y >= 0.0f ? -fold : fold;
+
+        return glm::normalize(normal);
+    }
+
+    // quantizes weights to unorm8, the rounding error goes to the largest weight so they still add up to one
+    static uint32_t PackWeights(glm::vec4 weight)
+    {
+        float sum = weight.x + weight.y + weight.z + weight.w;
+
+        if (sum > 0.0f)
+        {
+            weight /= sum;
+        }
+
+        uint32_t quantized[4] = {};
+        uint32_t total = 0;
+        uint32_t largest = 0;
+
+        for (uint32_t i = 0; i < 4; i++)
+        {
+            quantized[i] = (uint32_t)glm::round(glm::clamp(weight[i], 0.0f, 1.0f) * 255.0f);
+            total += quantized[i];
+
+            if (weight[i] > weight[largest])
+                largest = i;
+        }
+
+        uint32_t others = total - quantized[largest];
+        quantized[largest] = others < 255 ? 255 - others : 0;
+
+        return quantized[0] | (quantized[1] << 8) | (quantized[2] << 16) | (quantized[3] << 24);
+    }
+
+    // packs the joint indices into a byte each, the layout is only chosen if they fit
+    static uint32_t PackJoints(glm::uvec4 joint)
+    {
+        glm::uvec4 clamped = glm::min(joint, glm::uvec4(255));
+        return clamped.x | (clamped.y << 8) | (clamped.z << 16) | (clamped.w << 24);
+    }
+
+    VertexLayout ChooseVertexLayout(const std::vector<Vertex>& vertices, bool skinned)
+    {
+        // vertex colors are not read by the mesh shaders, the compact layouts drop them
+        // a full vertex would also be drawn by the static pipeline, leaving a skinned mesh unanimated
+        return skinned ? VertexLayout::Skinned : VertexLayout::Static;
+    }
+
+    bool FitsSkinnedLayout(const std::vector<Vertex>& vertices)
+    {
+        return std::none_of(vertices.begin(), vertices.end(), [](const Vertex& vertex) { return glm::any(glm::greaterThan(vertex.joint, glm::uvec4(255))); });
+    }
+
+    void PackVertices(VertexLayout layout, const Vertex* vertices, size_t count, void* destination)
+    {
+        switch (layout)
+        {
+            case VertexLayout::Static:
+            {
+                StaticVertex* packed = (StaticVertex*)destination;
+
+                for (size_t i = 0; i < count; i++)
+                {
+                    packed[i].position = vertices[i].position;
+                    packed[i].normal = glm::packSnorm2x16(EncodeOctahedral(vertices[i].normal));
+                    packed[i].uv = glm::packHalf2x16(vertices[i].uv);
+                }
+
+                break;
+            }
+
+            case VertexLayout::Skinned:
+            {
+                SkinnedVertex* packed = (SkinnedVertex*)destination;
+
+                for (size_t i = 0; i < count; i++)
+                {
+                    packed[i].position = vertices[i].position;
+                    packed[i].normal = glm::packSnorm2x16(EncodeOctahedral(vertices[i].normal));
+                    packed[i].uv = glm::packHalf2x16(vertices[i].uv);
+                    packed[i].joint = PackJoints(vertices[i].joint);
+                    packed[i].weight = PackWeights(vertices[i].weight);
+                }
+
+                break;
+            }
+
+            default:
+            {
+                memcpy(destination, vertices, count * sizeof(Vertex));
+                break;
+            }
+        }
+    }
+
+    void UnpackVertices(VertexLayout layout, const void* source, size_t count, Vertex* vertices)
+    {
+        switch (layout)
+        {
+            case VertexLayout::Static:
+            {
+                const StaticVertex* packed = (const StaticVertex*)source;
+
+                for (size_t i = 0; i < count; i++)
+                {
+                    vertices[i].position = packed[i].position;
+                    vertices[i].normal = DecodeOctahedral(glm::unpackSnorm2x16(packed[i].normal));
+                    vertices[i].uv = glm::unpackHalf2x16(packed[i].uv);
+                    vertices[i].joint = glm::uvec4(0);
+                    vertices[i].weight = glm::vec4(1.0f, 0.0f, 0.0f, 0.0f);
+                    vertices[i].color = glm::vec4(1.0f);
+                }
+
+                break;
+            }
+
+            case VertexLayout::Skinned:
+            {
+                const SkinnedVertex* packed = (const SkinnedVertex*)source;
+
+                for (size_t i = 0; i < count; i++)
+                {
+                    uint32_t joint = packed[i].joint;
+
+                    vertices[i].position = packed[i].position;
+                    vertices[i].normal = DecodeOctahedral(glm::unpackSnorm2x16(packed[i].normal));
+                    vertices[i].uv = glm::unpackHalf2x16(packed[i].uv);
+                    vertices[i].joint = glm::uvec4(joint & 0xFF, (joint >> 8) & 0xFF, (joint >> 16) & 0xFF, joint >> 24);
+                    vertices[i].weight = glm::unpackUnorm4x8(packed[i].weight);
+                    vertices[i].color = glm::vec4(1.0f);
+                }
+
+                break;
+            }
+
+            default:
+            {
+                memcpy(vertices, source, count * sizeof(Vertex));
+                break;
+            }
+        }
+    }
+}
\ No newline at end of file
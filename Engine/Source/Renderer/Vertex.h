@@ -2,6 +2,11 @@
 
 #include "Util/Math.h"
 
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
 namespace Cosmos
 {
     struct Vertex
@@ -34,4 +39,87 @@ namespace Cosmos
                 && color == other.color;
         }
     };
+
+    // how a mesh's vertices are stored on the gpu, chosen per mesh when it's loaded or cooked
+    enum class VertexLayout : uint32_t
+    {
+        Full = 0,   // Vertex as it is, how vertices are kept on the cpu, it's drawn by the static pipeline only
+        Static,     // StaticVertex, meshes without skins
+        Skinned     // SkinnedVertex, skinned meshes with up to 256 joints
+    };
+
+    // position, octahedral normal and half-float uv
+    struct StaticVertex
+    {
+        glm::vec3 position;
+        uint32_t normal;    // octahedral encoded, snorm16 x2
+        uint32_t uv;        // half-float x2
+    };
+
+    // static vertex with up to four joint influences
+    struct SkinnedVertex
+    {
+        glm::vec3 position;
+        uint32_t normal;    // octahedral encoded, snorm16 x2
+        uint32_t uv;        // half-float x2
+        uint32_t joint;     // uint8 x4
+        uint32_t weight;    // unorm8 x4, adding up to one
+    };
+
+    static_assert(sizeof(StaticVertex) == 20, "Static vertex must not have padding");
+    static_assert(sizeof(SkinnedVertex) == 28, "Skinned vertex must not have padding");
+
+    // returns the size of a vertex on a given layout
+    constexpr uint32_t GetVertexStride(VertexLayout layout)
+    {
+        switch (layout)
+        {
+            case VertexLayout::Static: return sizeof(StaticVertex);
+            case VertexLayout::Skinned: return sizeof(SkinnedVertex);
+            default: return sizeof(Vertex);
+        }
+    }
+
+    // returns the smallest layout able to hold the vertices without losing what the renderer uses
+    // skinned meshes always get the skinned layout, their joints must fit it
+    VertexLayout ChooseVertexLayout(const std::vector<Vertex>& vertices, bool skinned);
+
+    // returns if every joint index fits the byte the skinned layout stores it on
+    bool FitsSkinnedLayout(const std::vector<Vertex>& vertices);
+
+    // writes vertices on a given layout, destination must hold count * stride bytes
+    void PackVertices(VertexLayout layout, const Vertex* vertices, size_t count, void* destination);
+
+    // reads vertices stored on a given layout back into the full vertex
+    void UnpackVertices(VertexLayout layout, const void* source, size_t count, Vertex* vertices);
+
+    // read-only view of vertices stored on any layout, it doesn't own them and is valid until their mesh releases them
+    struct VertexView
+    {
+        const uint8_t* data = nullptr;
+        size_t count = 0;
+        VertexLayout layout = VertexLayout::Full;
+
+        // returns if there're no vertices to read
+        inline bool IsEmpty() const { return count == 0; }
+
+        // returns how many vertices the view has
+        inline size_t GetCount() const { return count; }
+
+        // returns a vertex's position, every layout starts with it so nothing is unpacked
+        inline glm::vec3 GetPosition(size_t index) const
+        {
+            glm::vec3 position;
+            memcpy(&position, data + index * GetVertexStride(layout), sizeof(glm::vec3));
+            return position;
+        }
+
+        // returns a vertex unpacked into the full vertex
+        inline Vertex GetVertex(size_t index) const
+        {
+            Vertex vertex;
+            UnpackVertices(layout, data + index * GetVertexStride(layout), 1, &vertex);
+            return vertex;
+        }
+    };
 }
\ No newline at end of file
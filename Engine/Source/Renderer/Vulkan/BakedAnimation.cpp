@@ -0,0 +1,223 @@
+#include "epch.h"
+#if defined COSMOS_RENDERER_VULKAN
+
+#include "BakedAnimation.h"
+
+#include "Device.h"
+#include "Renderpass.h"
+#include "VKRenderer.h"
+#include "Util/Logger.h"
+#include "Util/MappedFile.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace Cosmos::Vulkan
+{
+	BakedAnimation::BakedAnimation(Shared<VKRenderer> renderer)
+		: mRenderer(renderer)
+	{
+	}
+
+	BakedAnimation::~BakedAnimation()
+	{
+		// the last frames may still fetch the palettes, they're released once they're done
+		VkDevice device = mRenderer->GetDevice()->GetLogicalDevice();
+		VmaAllocator allocator = mRenderer->GetDevice()->GetAllocator();
+		VkSampler sampler = mSampler;
+		VkImageView view = mView;
+		VkImage image = mImage;
+		VmaAllocation memory = mMemory;
+
+		mRenderer->DeferRelease([device, allocator, sampler, view, image, memory]()
+			{
+				if (sampler != VK_NULL_HANDLE) vkDestroySampler(device, sampler, nullptr);
+				if (view != VK_NULL_HANDLE) vkDestroyImageView(device, view, nullptr);
+				if (image != VK_NULL_HANDLE) vmaDestroyImage(allocator, image, memory);
+			});
+	}
+
+	bool BakedAnimation::Load(std::string path)
+	{
+		MappedFile file;
+
+		if (!file.Open(path))
+		{
+			COSMOS_LOG(Logger::Error, "Failed to load baked animation %s, file could not be mapped", path.c_str());
+			return false;
+		}
+
+		const uint8_t* data = file.GetData();
+		const size_t size = file.GetSize();
+		const AnimationFormat::Header* header = (const AnimationFormat::Header*)data;
+
+		if (size < sizeof(AnimationFormat::Header) || header->magic != AnimationFormat::Magic || header->version != AnimationFormat::Version)
+		{
+			COSMOS_LOG(Logger::Error, "Failed to load baked animation %s, file is not a baked animation or was baked by another version of the engine", path.c_str());
+			return false;
+		}
+
+		const size_t rowSize = (size_t)header->jointCount * AnimationFormat::TexelsPerJoint * 4 * sizeof(float);
+		const bool inside = header->clipsOffset + (uint64_t)header->clipCount * sizeof(AnimationFormat::Clip) <= size
+			&& header->palettesOffset + (uint64_t)header->frameCount * rowSize <= size;
+
+		if (!inside || header->jointCount == 0 || header->frameCount == 0)
+		{
+			COSMOS_LOG(Logger::Error, "Failed to load baked animation %s, file is truncated or has no frames", path.c_str());
+			return false;
+		}
+
+		// every joint is three texels wide and every frame a row, both must fit the device's images
+		const uint32_t maxDimension = mRenderer->GetDevice()->GetPropertiesRef().limits.maxImageDimension2D;
+
+		if (header->jointCount * AnimationFormat::TexelsPerJoint > maxDimension || header->frameCount > maxDimension)
+		{
+			COSMOS_LOG(Logger::Error, "Failed to load baked animation %s, %d joints over %d frames exceed the %d texels an image may have per side", path.c_str(), header->jointCount, header->frameCount, maxDimension);
+			return false;
+		}
+
+		const AnimationFormat::Clip* clips = (const AnimationFormat::Clip*)(data + header->clipsOffset);
+
+		for (uint32_t i = 0; i < header->clipCount; i++)
+		{
+			if (clips[i].frameCount == 0 || clips[i].firstFrame + clips[i].frameCount > header->frameCount)
+			{
+				COSMOS_LOG(Logger::Error, "Failed to load baked animation %s, clip %d is outside of the frames", path.c_str(), i);
+				return false;
+			}
+		}
+
+		mHeader = *header;
+		mClips.assign(clips, clips + header->clipCount);
+
+		Upload(data + header->palettesOffset, (size_t)header->frameCount * rowSize);
+		return true;
+	}
+
+	float BakedAnimation::GetFrame(uint32_t clip, float time) const
+	{
+		if (clip >= (uint32_t)mClips.size())
+			return 0.0f;
+
+		const AnimationFormat::Clip& baked = mClips[clip];
+		float progress = baked.duration > 0.0f ? std::clamp(time / baked.duration, 0.0f, 1.0f) : 0.0f;
+
+		return (float)baked.firstFrame + progress * (float)(baked.frameCount - 1);
+	}
+
+	void BakedAnimation::Upload(const void* palettes, size_t size)
+	{
+		Shared<Device> device = mRenderer->GetDevice();
+		const uint32_t width = mHeader.jointCount * AnimationFormat::TexelsPerJoint;
+		const uint32_t height = mHeader.frameCount;
+
+		// create staging buffer for the palettes
+		VkBuffer stagingBuffer;
+		VmaAllocation stagingMemory;
+
+		device->CreateBuffer
+		(
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			(VkDeviceSize)size,
+			&stagingBuffer,
+			&stagingMemory
+		);
+
+		void* data = nullptr;
+		vmaMapMemory(device->GetAllocator(), stagingMemory, &data);
+		memcpy(data, palettes, size);
+		vmaUnmapMemory(device->GetAllocator(), stagingMemory);
+
+		// the texture is only fetched, a single level of full precision texels
+		device->CreateImage
+		(
+			width,
+			height,
+			1,
+			1,
+			VK_SAMPLE_COUNT_1_BIT,
+			VK_FORMAT_R32G32B32A32_SFLOAT,
+			VK_IMAGE_TILING_OPTIMAL,
+			VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			mImage,
+			mMemory
+		);
+
+		// copy buffer to image, the transitions are recorded with the copy since it's read by the vertex shader
+		auto& renderpass = mRenderer->GetRenderpassManager()->GetMainRenderpass()->GetSpecificationRef();
+		VkCommandBuffer cmdBuffer = device->CreateCommandBuffer(renderpass.commandPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
+
+		VkImageSubresourceRange range = {};
+		range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		range.baseMipLevel = 0;
+		range.levelCount = 1;
+		range.baseArrayLayer = 0;
+		range.layerCount = 1;
+
+		device->InsertImageMemoryBarrier
+		(
+			cmdBuffer,
+			mImage,
+			0,
+			VK_ACCESS_TRANSFER_WRITE_BIT,
+			VK_IMAGE_LAYOUT_UNDEFINED,
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+			VK_PIPELINE_STAGE_TRANSFER_BIT,
+			range
+		);
+
+		VkBufferImageCopy region = {};
+		region.bufferOffset = 0;
+		region.bufferRowLength = 0;
+		region.bufferImageHeight = 0;
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.mipLevel = 0;
+		region.imageSubresource.baseArrayLayer = 0;
+		region.imageSubresource.layerCount = 1;
+		region.imageOffset = { 0, 0, 0 };
+		region.imageExtent = { width, height, 1 };
+		vkCmdCopyBufferToImage(cmdBuffer, stagingBuffer, mImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+		// the frames submitted after the upload wait for the transition before fetching
+		device->InsertImageMemoryBarrier
+		(
+			cmdBuffer,
+			mImage,
+			VK_ACCESS_TRANSFER_WRITE_BIT,
+			VK_ACCESS_SHADER_READ_BIT,
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+			VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
+			range
+		);
+
+		COSMOS_ASSERT(vkEndCommandBuffer(cmdBuffer) == VK_SUCCESS, "Failed to end the recording of the command buffer");
+
+		VkSubmitInfo submitInfo = {};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &cmdBuffer;
+
+		// not waited for, the fence of the next frame signals after it so the staging buffer is released with the frames in flight
+		COSMOS_ASSERT(vkQueueSubmit(device->GetGraphicsQueue(), 1, &submitInfo, VK_NULL_HANDLE) == VK_SUCCESS, "Failed to submit the baked animation upload");
+
+		VkDevice logicalDevice = device->GetLogicalDevice();
+		VmaAllocator allocator = device->GetAllocator();
+		VkCommandPool commandPool = renderpass.commandPool;
+
+		mRenderer->DeferRelease([logicalDevice, allocator, commandPool, cmdBuffer, stagingBuffer, stagingMemory]()
+			{
+				vkFreeCommandBuffers(logicalDevice, commandPool, 1, &cmdBuffer);
+				vmaDestroyBuffer(allocator, stagingBuffer, stagingMemory);
+			});
+
+		mView = device->CreateImageView(mImage, VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_ASPECT_COLOR_BIT);
+		mSampler = device->CreateSampler(VK_FILTER_NEAREST, VK_FILTER_NEAREST, VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE, VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE, VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE);
+	}
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,67 @@
+#pragma once
+#if defined COSMOS_RENDERER_VULKAN
+
+#include "Renderer/AnimationFormat.h"
+#include "Util/Memory.h"
+#include <volk.h>
+#include "Wrapper/vma.h" // including vma after volk
+
+#include <string>
+#include <vector>
+
+namespace Cosmos::Vulkan
+{
+	// forward declarations
+	class VKRenderer;
+
+	// the clips of a mesh baked into a texture of joint palettes (.cvat), a row per frame
+	// instances only carry their frame, the vertex shader fetches and blends the joints of two rows, nothing is animated by the cpu
+	class BakedAnimation
+	{
+	public:
+
+		// constructor
+		BakedAnimation(Shared<VKRenderer> renderer);
+
+		// destructor, the texture is released once the frames using it are done
+		~BakedAnimation();
+
+		// returns the image view of the animation texture
+		inline VkImageView GetView() const { return mView; }
+
+		// returns the sampler of the animation texture, texels are fetched so it never filters
+		inline VkSampler GetSampler() const { return mSampler; }
+
+		// returns how many joints every frame has
+		inline uint32_t GetJointCount() const { return mHeader.jointCount; }
+
+		// returns the baked clips
+		inline const std::vector<AnimationFormat::Clip>& GetClips() const { return mClips; }
+
+	public:
+
+		// loads a baked file and uploads it's palettes, returns false if it's invalid or doesn't fit an image
+		bool Load(std::string path);
+
+		// returns the texture row of a clip's time, the fraction blends it with the next row
+		float GetFrame(uint32_t clip, float time) const;
+
+	private:
+
+		// creates the image from the palettes, the copy and transitions are submitted without waiting for them
+		void Upload(const void* palettes, size_t size);
+
+	private:
+
+		Shared<VKRenderer> mRenderer;
+		AnimationFormat::Header mHeader = {};
+		std::vector<AnimationFormat::Clip> mClips = {};
+
+		VkImage mImage = VK_NULL_HANDLE;
+		VmaAllocation mMemory = VK_NULL_HANDLE;
+		VkImageView mView = VK_NULL_HANDLE;
+		VkSampler mSampler = VK_NULL_HANDLE;
+	};
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,413 @@
+#include "epch.h"
+#if defined COSMOS_RENDERER_VULKAN
+
+#include "CullingPass.h"
+
+#include "Device.h"
+#include "Shader.h"
+#include "Util/Files.h"
+#include "Util/Logger.h"
+
+#include <algorithm>
+#include <array>
+
+namespace Cosmos::Vulkan
+{
+	CullingPass::CullingPass(Shared<Device> device, uint32_t framesInFlight)
+		: mDevice(device)
+	{
+		const Device::QueueFamilyIndices& families = mDevice->GetQueueFamilies();
+
+		// buffers are shared by both queues without ownership transfers
+		if (families.graphics.value() != families.compute.value())
+		{
+			mQueueFamilies = { families.graphics.value(), families.compute.value() };
+		}
+
+		VkCommandPoolCreateInfo cmdPoolInfo = {};
+		cmdPoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		cmdPoolInfo.queueFamilyIndex = families.compute.value();
+		cmdPoolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+		COSMOS_ASSERT(vkCreateCommandPool(mDevice->GetLogicalDevice(), &cmdPoolInfo, nullptr, &mCommandPool) == VK_SUCCESS, "Failed to create command pool");
+
+		mFrames.resize(framesInFlight);
+		CreatePipelines();
+
+		for (FrameData& frame : mFrames)
+		{
+			// every buffer exists from the start, descriptors are always written with valid buffers
+			Reserve(frame.instances, 1024 * sizeof(InstanceData), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, true);
+			Reserve(frame.instanceBatches, 1024 * sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, true);
+			Reserve(frame.batches, 256 * sizeof(Batch), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, true);
+			Reserve(frame.templates, 1024 * sizeof(DrawTemplate), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, true);
+			Reserve(frame.visible, 1024 * sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, false);
+			Reserve(frame.visibleCounts, 256 * sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, false);
+			Reserve(frame.commands, 1024 * sizeof(VkDrawIndexedIndirectCommand), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, false);
+			Reserve(frame.drawCounts, 256 * sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, false);
+			frame.version = 1;
+
+			frame.commandBuffer = mDevice->CreateCommandBuffer(mCommandPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+
+			VkSemaphoreCreateInfo semaphoreCI = {};
+			semaphoreCI.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+			COSMOS_ASSERT(vkCreateSemaphore(mDevice->GetLogicalDevice(), &semaphoreCI, nullptr, &frame.semaphore) == VK_SUCCESS, "Failed to create culling semaphore");
+
+			VkDescriptorSetAllocateInfo descSetAllocInfo = {};
+			descSetAllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+			descSetAllocInfo.descriptorPool = mDescriptorPool;
+			descSetAllocInfo.descriptorSetCount = 1;
+			descSetAllocInfo.pSetLayouts = &mDescriptorSetLayout;
+			COSMOS_ASSERT(vkAllocateDescriptorSets(mDevice->GetLogicalDevice(), &descSetAllocInfo, &frame.descriptorSet) == VK_SUCCESS, "Failed to allocate culling descriptor set");
+		}
+	}
+
+	CullingPass::~CullingPass()
+	{
+		VkDevice device = mDevice->GetLogicalDevice();
+		vkDeviceWaitIdle(device);
+
+		for (FrameData& frame : mFrames)
+		{
+			Destroy(frame.instances);
+			Destroy(frame.instanceBatches);
+			Destroy(frame.batches);
+			Destroy(frame.templates);
+			Destroy(frame.visible);
+			Destroy(frame.visibleCounts);
+			Destroy(frame.commands);
+			Destroy(frame.drawCounts);
+			vkDestroySemaphore(device, frame.semaphore, nullptr);
+		}
+
+		vkDestroyPipeline(device, mCullPipeline, nullptr);
+		vkDestroyPipeline(device, mCommandsPipeline, nullptr);
+		vkDestroyPipelineLayout(device, mPipelineLayout, nullptr);
+		vkDestroyDescriptorSetLayout(device, mDescriptorSetLayout, nullptr);
+		vkDestroyDescriptorPool(device, mDescriptorPool, nullptr);
+		vkDestroyCommandPool(device, mCommandPool, nullptr);
+	}
+
+	InstanceData* CullingPass::BeginFrame(uint32_t frame, uint32_t count)
+	{
+		mCurrentFrame = frame;
+		FrameData& data = mFrames[frame];
+
+		mBatches.clear();
+		mTemplates.clear();
+		mInstanceBatches.resize(count);
+		mInstanceCount = count;
+
+		// the frame's previous submission is done and nothing was recorded with it's buffers yet
+		bool recreated = Reserve(data.instances, count * sizeof(InstanceData), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, true);
+		recreated |= Reserve(data.visible, count * sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, false);
+
+		if (recreated)
+		{
+			data.version++;
+		}
+
+		// batches that didn't fit the last time are drawn indirectly from now on
+		Reserve(data.commands, mRequiredCommands * sizeof(VkDrawIndexedIndirectCommand), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, false);
+		Reserve(data.drawCounts, mRequiredBatches * sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, false);
+		mRequiredCommands = 0;
+		mRequiredBatches = 0;
+
+		return (InstanceData*)data.instances.mapped;
+	}
+
+	void CullingPass::DrawBatch(VkCommandBuffer commandBuffer, const glm::vec3& boundsMin, const glm::vec3& boundsMax, uint32_t firstInstance, uint32_t instanceCount, const VkDrawIndexedIndirectCommand* commands, uint32_t commandCount)
+	{
+		FrameData& data = mFrames[mCurrentFrame];
+		uint32_t batchIndex = (uint32_t)mBatches.size();
+		uint32_t firstCommand = (uint32_t)mTemplates.size();
+
+		mRequiredBatches++;
+		mRequiredCommands += commandCount;
+
+		Batch batch = {};
+		batch.boundsMin = glm::vec4(boundsMin, 0.0f);
+		batch.boundsMax = glm::vec4(boundsMax, 0.0f);
+		batch.firstInstance = firstInstance;
+		batch.instanceCount = instanceCount;
+		batch.firstCommand = firstCommand;
+		batch.commandCount = commandCount;
+		batch.culled = (batchIndex + 1) * sizeof(uint32_t) <= data.drawCounts.size && (firstCommand + commandCount) * sizeof(VkDrawIndexedIndirectCommand) <= data.commands.size;
+		mBatches.push_back(batch);
+
+		std::fill(mInstanceBatches.begin() + firstInstance, mInstanceBatches.begin() + firstInstance + instanceCount, batchIndex);
+
+		// the indirect buffers are full until the next frame, every instance is drawn
+		if (!batch.culled)
+		{
+			for (uint32_t i = 0; i < commandCount; i++)
+			{
+				vkCmdDrawIndexed(commandBuffer, commands[i].indexCount, instanceCount, commands[i].firstIndex, commands[i].vertexOffset, firstInstance);
+			}
+
+			return;
+		}
+
+		for (uint32_t i = 0; i < commandCount; i++)
+		{
+			DrawTemplate drawTemplate = {};
+			drawTemplate.command = commands[i];
+			drawTemplate.command.instanceCount = 0;
+			drawTemplate.command.firstInstance = firstInstance;
+			drawTemplate.batch = batchIndex;
+			mTemplates.push_back(drawTemplate);
+		}
+
+		constexpr uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+		VkDeviceSize offset = (VkDeviceSize)firstCommand * stride;
+
+		// the count is either every command of the batch or none, when no instance is visible
+		if (mDevice->IsDrawIndirectCountSupported())
+		{
+			vkCmdDrawIndexedIndirectCount(commandBuffer, data.commands.buffer, offset, data.drawCounts.buffer, batchIndex * sizeof(uint32_t), commandCount, stride);
+		}
+
+		// commands without visible instances draw nothing
+		else if (mDevice->GetFeaturesRef().multiDrawIndirect)
+		{
+			vkCmdDrawIndexedIndirect(commandBuffer, data.commands.buffer, offset, commandCount, stride);
+		}
+
+		else
+		{
+			for (uint32_t i = 0; i < commandCount; i++)
+			{
+				vkCmdDrawIndexedIndirect(commandBuffer, data.commands.buffer, offset + i * stride, 1, stride);
+			}
+		}
+	}
+
+	VkSemaphore CullingPass::Submit(const glm::mat4& viewProjection)
+	{
+		if (mBatches.empty())
+			return VK_NULL_HANDLE;
+
+		FrameData& data = mFrames[mCurrentFrame];
+		VmaAllocator allocator = mDevice->GetAllocator();
+
+		// only read by the culling pass, they can grow now
+		Reserve(data.instanceBatches, mInstanceCount * sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, true);
+		Reserve(data.batches, mBatches.size() * sizeof(Batch), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, true);
+		Reserve(data.templates, mTemplates.size() * sizeof(DrawTemplate), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, true);
+		Reserve(data.visibleCounts, mBatches.size() * sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, false);
+
+		memcpy(data.instanceBatches.mapped, mInstanceBatches.data(), mInstanceCount * sizeof(uint32_t));
+		memcpy(data.batches.mapped, mBatches.data(), mBatches.size() * sizeof(Batch));
+
+		if (mTemplates.size() > 0)
+		{
+			memcpy(data.templates.mapped, mTemplates.data(), mTemplates.size() * sizeof(DrawTemplate));
+		}
+
+		// no-op on coherent memory
+		vmaFlushAllocation(allocator, data.instances.memory, 0, VK_WHOLE_SIZE);
+		vmaFlushAllocation(allocator, data.instanceBatches.memory, 0, VK_WHOLE_SIZE);
+		vmaFlushAllocation(allocator, data.batches.memory, 0, VK_WHOLE_SIZE);
+		vmaFlushAllocation(allocator, data.templates.memory, 0, VK_WHOLE_SIZE);
+
+		UpdateDescriptorSet(data);
+
+		// gribb-hartmann extraction, the near plane is the opengl one, a little conservative on zero to one depth
+		CullPushConstant constants = {};
+		glm::vec4 rows[4] = {};
+
+		for (int i = 0; i < 4; i++)
+		{
+			rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+		}
+
+		constants.planes[0] = rows[3] + rows[0];
+		constants.planes[1] = rows[3] - rows[0];
+		constants.planes[2] = rows[3] + rows[1];
+		constants.planes[3] = rows[3] - rows[1];
+		constants.planes[4] = rows[3] + rows[2];
+		constants.planes[5] = rows[3] - rows[2];
+
+		for (glm::vec4& plane : constants.planes)
+		{
+			plane /= glm::length(glm::vec3(plane));
+		}
+
+		constants.instanceCount = mInstanceCount;
+		constants.templateCount = (uint32_t)mTemplates.size();
+
+		VkCommandBuffer cmdBuffer = data.commandBuffer;
+		vkResetCommandBuffer(cmdBuffer, 0);
+		mDevice->BeginCommandBuffer(cmdBuffer);
+
+		vkCmdFillBuffer(cmdBuffer, data.visibleCounts.buffer, 0, mBatches.size() * sizeof(uint32_t), 0);
+
+		VkMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		vkCmdPipelineBarrier(cmdBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+		// one invocation per instance, visible ones are appended to their batch
+		vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, mPipelineLayout, 0, 1, &data.descriptorSet, 0, nullptr);
+		vkCmdPushConstants(cmdBuffer, mPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullPushConstant), &constants);
+		vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, mCullPipeline);
+		vkCmdDispatch(cmdBuffer, (mInstanceCount + 63) / 64, 1, 1);
+
+		barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		vkCmdPipelineBarrier(cmdBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+		// one invocation per command, writing the visible instance count of it's batch
+		if (mTemplates.size() > 0)
+		{
+			vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, mCommandsPipeline);
+			vkCmdDispatch(cmdBuffer, ((uint32_t)mTemplates.size() + 63) / 64, 1, 1);
+		}
+
+		COSMOS_ASSERT(vkEndCommandBuffer(cmdBuffer) == VK_SUCCESS, "Failed to end the recording of the culling command buffer");
+
+		// the semaphore makes the writes visible to the draws waiting on it
+		VkSubmitInfo submitInfo = {};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &cmdBuffer;
+		submitInfo.signalSemaphoreCount = 1;
+		submitInfo.pSignalSemaphores = &data.semaphore;
+		COSMOS_ASSERT(vkQueueSubmit(mDevice->GetComputeQueue(), 1, &submitInfo, VK_NULL_HANDLE) == VK_SUCCESS, "Failed to submit the culling pass");
+
+		mBatches.clear();
+		mTemplates.clear();
+
+		return data.semaphore;
+	}
+
+	void CullingPass::CreatePipelines()
+	{
+		VkDevice device = mDevice->GetLogicalDevice();
+
+		// instances, instance batches, batches, templates, visible, visible counts, commands, draw counts
+		std::array<VkDescriptorSetLayoutBinding, 8> bindings = {};
+
+		for (uint32_t i = 0; i < (uint32_t)bindings.size(); i++)
+		{
+			bindings[i].binding = i;
+			bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			bindings[i].descriptorCount = 1;
+			bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+			bindings[i].pImmutableSamplers = nullptr;
+		}
+
+		VkDescriptorSetLayoutCreateInfo descSetLayoutCI = {};
+		descSetLayoutCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		descSetLayoutCI.bindingCount = (uint32_t)bindings.size();
+		descSetLayoutCI.pBindings = bindings.data();
+		COSMOS_ASSERT(vkCreateDescriptorSetLayout(device, &descSetLayoutCI, nullptr, &mDescriptorSetLayout) == VK_SUCCESS, "Failed to create culling descriptor set layout");
+
+		VkPushConstantRange pushConstant = {};
+		pushConstant.offset = 0;
+		pushConstant.size = sizeof(CullPushConstant);
+		pushConstant.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+		VkPipelineLayoutCreateInfo pipelineLayoutCI = {};
+		pipelineLayoutCI.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutCI.setLayoutCount = 1;
+		pipelineLayoutCI.pSetLayouts = &mDescriptorSetLayout;
+		pipelineLayoutCI.pushConstantRangeCount = 1;
+		pipelineLayoutCI.pPushConstantRanges = &pushConstant;
+		COSMOS_ASSERT(vkCreatePipelineLayout(device, &pipelineLayoutCI, nullptr, &mPipelineLayout) == VK_SUCCESS, "Failed to create culling pipeline layout");
+
+		Shared<Shader> cullShader = CreateShared<Shader>(mDevice, Shader::Type::Compute, "Cull.comp", GetAssetSubDir("Shader/cull.comp"));
+		Shared<Shader> commandsShader = CreateShared<Shader>(mDevice, Shader::Type::Compute, "CullCommands.comp", GetAssetSubDir("Shader/cull_commands.comp"));
+
+		VkComputePipelineCreateInfo pipelineCI = {};
+		pipelineCI.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+		pipelineCI.layout = mPipelineLayout;
+		pipelineCI.stage = cullShader->GetShaderStageCreateInfoRef();
+		COSMOS_ASSERT(vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipelineCI, nullptr, &mCullPipeline) == VK_SUCCESS, "Failed to create culling pipeline");
+
+		pipelineCI.stage = commandsShader->GetShaderStageCreateInfoRef();
+		COSMOS_ASSERT(vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipelineCI, nullptr, &mCommandsPipeline) == VK_SUCCESS, "Failed to create culling commands pipeline");
+
+		VkDescriptorPoolSize poolSize = {};
+		poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		poolSize.descriptorCount = (uint32_t)bindings.size() * (uint32_t)mFrames.size();
+
+		VkDescriptorPoolCreateInfo descPoolCI = {};
+		descPoolCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		descPoolCI.poolSizeCount = 1;
+		descPoolCI.pPoolSizes = &poolSize;
+		descPoolCI.maxSets = (uint32_t)mFrames.size();
+		COSMOS_ASSERT(vkCreateDescriptorPool(device, &descPoolCI, nullptr, &mDescriptorPool) == VK_SUCCESS, "Failed to create culling descriptor pool");
+	}
+
+	bool CullingPass::Reserve(GPUBuffer& buffer, VkDeviceSize size, VkBufferUsageFlags usage, bool hostVisible)
+	{
+		if (buffer.buffer != VK_NULL_HANDLE && size <= buffer.size)
+			return false;
+
+		// doubling keeps a steadily growing scene from recreating it every frame
+		size = std::max(size, buffer.size * 2);
+		Destroy(buffer);
+
+		VkBufferCreateInfo bufferCI = {};
+		bufferCI.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferCI.size = size;
+		bufferCI.usage = usage;
+		bufferCI.sharingMode = mQueueFamilies.empty() ? VK_SHARING_MODE_EXCLUSIVE : VK_SHARING_MODE_CONCURRENT;
+		bufferCI.queueFamilyIndexCount = (uint32_t)mQueueFamilies.size();
+		bufferCI.pQueueFamilyIndices = mQueueFamilies.data();
+
+		VmaAllocationCreateInfo allocCI = {};
+		allocCI.usage = hostVisible ? VMA_MEMORY_USAGE_AUTO : VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
+		allocCI.flags = hostVisible ? VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT : 0;
+
+		VmaAllocationInfo allocInfo = {};
+		COSMOS_ASSERT(vmaCreateBuffer(mDevice->GetAllocator(), &bufferCI, &allocCI, &buffer.buffer, &buffer.memory, &allocInfo) == VK_SUCCESS, "Failed to create culling buffer");
+
+		buffer.mapped = allocInfo.pMappedData;
+		buffer.size = size;
+
+		return true;
+	}
+
+	void CullingPass::Destroy(GPUBuffer& buffer)
+	{
+		if (buffer.buffer != VK_NULL_HANDLE)
+		{
+			vmaDestroyBuffer(mDevice->GetAllocator(), buffer.buffer, buffer.memory);
+		}
+
+		buffer = {};
+	}
+
+	void CullingPass::UpdateDescriptorSet(FrameData& frame)
+	{
+		std::array<GPUBuffer*, 8> buffers =
+		{
+			&frame.instances, &frame.instanceBatches, &frame.batches, &frame.templates,
+			&frame.visible, &frame.visibleCounts, &frame.commands, &frame.drawCounts
+		};
+
+		std::array<VkDescriptorBufferInfo, 8> infos = {};
+		std::array<VkWriteDescriptorSet, 8> writes = {};
+
+		for (uint32_t i = 0; i < (uint32_t)buffers.size(); i++)
+		{
+			infos[i].buffer = buffers[i]->buffer;
+			infos[i].offset = 0;
+			infos[i].range = VK_WHOLE_SIZE;
+
+			writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			writes[i].dstSet = frame.descriptorSet;
+			writes[i].dstBinding = i;
+			writes[i].dstArrayElement = 0;
+			writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			writes[i].descriptorCount = 1;
+			writes[i].pBufferInfo = &infos[i];
+		}
+
+		vkUpdateDescriptorSets(mDevice->GetLogicalDevice(), (uint32_t)writes.size(), writes.data(), 0, nullptr);
+	}
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,148 @@
+#pragma once
+#if defined COSMOS_RENDERER_VULKAN
+
+#include "Renderer/Buffer.h"
+#include "Util/Math.h"
+#include "Util/Memory.h"
+#include <volk.h>
+#include "Wrapper/vma.h" // including vma after volk
+
+#include <vector>
+
+namespace Cosmos::Vulkan
+{
+	// forward declarations
+	class Device;
+	class Shader;
+
+	// gpu-driven drawing, the instances of every batch are frustum culled by a compute pass on the compute queue
+	// the pass writes the visible instances and the indirect commands, the batches are drawn with vkCmdDrawIndexedIndirectCount
+	// it owns the per-frame instance data, so the draws only cost a batch each regardless of how many instances it has
+	class CullingPass
+	{
+	public:
+
+		// constructor
+		CullingPass(Shared<Device> device, uint32_t framesInFlight);
+
+		// destructor
+		~CullingPass();
+
+		// returns the instance buffer of a frame
+		inline VkBuffer GetInstanceBuffer(uint32_t frame) const { return mFrames[frame].instances.buffer; }
+
+		// returns the buffer mapping a frame's instance index to the instance it draws
+		inline VkBuffer GetVisibleBuffer(uint32_t frame) const { return mFrames[frame].visible.buffer; }
+
+		// returns how many times a frame's instance buffers were created, descriptors written with an older version must be written again
+		inline uint32_t GetVersion(uint32_t frame) const { return mFrames[frame].version; }
+
+	public:
+
+		// starts recording a frame, returning it's instance data with room for count instances
+		InstanceData* BeginFrame(uint32_t frame, uint32_t count);
+
+		// records the draws of a batch, the instances are culled against it's local bounds before being drawn
+		void DrawBatch(VkCommandBuffer commandBuffer, const glm::vec3& boundsMin, const glm::vec3& boundsMax, uint32_t firstInstance, uint32_t instanceCount, const VkDrawIndexedIndirectCommand* commands, uint32_t commandCount);
+
+		// submits the culling of the recorded batches, returns the semaphore the draws must wait for or null if nothing was recorded
+		VkSemaphore Submit(const glm::mat4& viewProjection);
+
+	private:
+
+		struct GPUBuffer
+		{
+			VkBuffer buffer = VK_NULL_HANDLE;
+			VmaAllocation memory = VK_NULL_HANDLE;
+			void* mapped = nullptr;		// only host visible buffers are mapped
+			VkDeviceSize size = 0;
+		};
+
+		// instances sharing a mesh and state, matches the culling shaders
+		struct Batch
+		{
+			glm::vec4 boundsMin = glm::vec4(0.0f);
+			glm::vec4 boundsMax = glm::vec4(0.0f);
+			uint32_t firstInstance = 0;
+			uint32_t instanceCount = 0;
+			uint32_t firstCommand = 0;
+			uint32_t commandCount = 0;
+			uint32_t culled = 1;		// batches drawn directly keep every instance
+			uint32_t padding[3] = {};
+		};
+
+		// indirect command of a batch's primitive, the instance count is written by the gpu
+		struct DrawTemplate
+		{
+			VkDrawIndexedIndirectCommand command = {};
+			uint32_t batch = 0;
+		};
+
+		struct CullPushConstant
+		{
+			glm::vec4 planes[6] = {};	// frustum planes, pointing inwards
+			uint32_t instanceCount = 0;
+			uint32_t templateCount = 0;
+		};
+
+		struct FrameData
+		{
+			// written by the host
+			GPUBuffer instances;
+			GPUBuffer instanceBatches;	// batch of every instance
+			GPUBuffer batches;
+			GPUBuffer templates;
+
+			// written by the culling pass
+			GPUBuffer visible;			// instances of every batch, starting at it's first instance
+			GPUBuffer visibleCounts;	// visible instances of every batch
+			GPUBuffer commands;
+			GPUBuffer drawCounts;		// commands drawn of every batch, all or none
+
+			uint32_t version = 0;
+			VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+			VkSemaphore semaphore = VK_NULL_HANDLE;
+			VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+		};
+
+	private:
+
+		// creates the compute pipelines and their descriptor sets
+		void CreatePipelines();
+
+		// makes sure a buffer holds size bytes, it's recreated without keeping it's contents
+		bool Reserve(GPUBuffer& buffer, VkDeviceSize size, VkBufferUsageFlags usage, bool hostVisible);
+
+		// destroys a buffer
+		void Destroy(GPUBuffer& buffer);
+
+		// writes the buffers of a frame into it's descriptor set
+		void UpdateDescriptorSet(FrameData& frame);
+
+	private:
+
+		Shared<Device> mDevice;
+		std::vector<FrameData> mFrames = {};
+		uint32_t mCurrentFrame = 0;
+		std::vector<uint32_t> mQueueFamilies = {};	// families sharing the buffers, empty if the queues have the same family
+
+		// recorded this frame, uploaded on submission
+		std::vector<Batch> mBatches = {};
+		std::vector<DrawTemplate> mTemplates = {};
+		std::vector<uint32_t> mInstanceBatches = {};
+		uint32_t mInstanceCount = 0;
+
+		// sizes the buffers drawn from must have, they can't grow while a frame is recorded so they grow on the next one
+		uint32_t mRequiredBatches = 0;
+		uint32_t mRequiredCommands = 0;
+
+		VkCommandPool mCommandPool = VK_NULL_HANDLE;
+		VkDescriptorPool mDescriptorPool = VK_NULL_HANDLE;
+		VkDescriptorSetLayout mDescriptorSetLayout = VK_NULL_HANDLE;
+		VkPipelineLayout mPipelineLayout = VK_NULL_HANDLE;
+		VkPipeline mCullPipeline = VK_NULL_HANDLE;
+		VkPipeline mCommandsPipeline = VK_NULL_HANDLE;
+	};
+}
+
+#endif
\ No newline at end of file
@@ -440,6 +440,7 @@ namespace Cosmos::Vulkan
 	void Device::CreateLogicalDevice()
 	{
 		QueueFamilyIndices indices = FindQueueFamilies(mPhysicalDevice, mSurface);
+		mQueueFamilies = indices;
 
 		float queuePriority = 1.0f;
 		std::vector<VkDeviceQueueCreateInfo> deviceQueueCIs;
@@ -463,9 +464,27 @@ namespace Cosmos::Vulkan
 		extensions.push_back(VK_KHR_PORTABILITY_ENUMERATION_EXTENSION_NAME);
 #endif
 
+		// indirect draws with a gpu written count, used by the culling pass when available
+		VkPhysicalDeviceVulkan12Features features12 = {};
+		features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+
+		if (mProperties.apiVersion >= VK_API_VERSION_1_2)
+		{
+			VkPhysicalDeviceVulkan12Features supported12 = {};
+			supported12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+
+			VkPhysicalDeviceFeatures2 features2 = {};
+			features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+			features2.pNext = &supported12;
+			vkGetPhysicalDeviceFeatures2(mPhysicalDevice, &features2);
+
+			features12.drawIndirectCount = supported12.drawIndirectCount;
+			mDrawIndirectCount = supported12.drawIndirectCount == VK_TRUE;
+		}
+
 		VkDeviceCreateInfo deviceCI = {};
 		deviceCI.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
-		deviceCI.pNext = nullptr;
+		deviceCI.pNext = mProperties.apiVersion >= VK_API_VERSION_1_2 ? &features12 : nullptr;
 		deviceCI.flags = 0;
 		deviceCI.queueCreateInfoCount = (uint32_t)deviceQueueCIs.size();
 		deviceCI.pQueueCreateInfos = deviceQueueCIs.data();
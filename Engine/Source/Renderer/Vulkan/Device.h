@@ -60,6 +60,12 @@ namespace Cosmos::Vulkan
 		// returns the compute queue
 		inline VkQueue GetComputeQueue() const { return mComputeQueue; }
 
+		// returns the queue families the queues were created from
+		inline const QueueFamilyIndices& GetQueueFamilies() const { return mQueueFamilies; }
+
+		// returns if vkCmdDrawIndexedIndirectCount can be used, it's core on vulkan 1.2 but optional
+		inline bool IsDrawIndirectCountSupported() const { return mDrawIndirectCount; }
+
 		// returns the sampling in use
 		inline VkSampleCountFlagBits GetMSAA() const { return mMSAACount; }
 
@@ -154,6 +160,8 @@ namespace Cosmos::Vulkan
 		VkQueue mGraphicsQueue = VK_NULL_HANDLE;
 		VkQueue mPresentQueue = VK_NULL_HANDLE;
 		VkQueue mComputeQueue = VK_NULL_HANDLE;
+		QueueFamilyIndices mQueueFamilies = {};
+		bool mDrawIndirectCount = false;
 		VkSampleCountFlagBits mMSAACount = VK_SAMPLE_COUNT_1_BIT;
 		VmaAllocator mAllocator = VK_NULL_HANDLE;
 	};
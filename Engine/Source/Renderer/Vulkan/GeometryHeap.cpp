@@ -0,0 +1,382 @@
+#include "epch.h"
+#if defined COSMOS_RENDERER_VULKAN
+
+#include "GeometryHeap.h"
+
+#include "Device.h"
+#include "Renderpass.h"
+#include "Util/Logger.h"
+
+#include <algorithm>
+
+namespace Cosmos::Vulkan
+{
+	// rounds a size up to a multiple of the granularity
+	static VkDeviceSize AlignUp(VkDeviceSize size, VkDeviceSize granularity)
+	{
+		return ((size + granularity - 1) / granularity) * granularity;
+	}
+
+	GeometryHeap::GeometryHeap(Shared<Device> device, Shared<RenderpassManager> renderpassManager, Specification specification)
+		: mDevice(device), mRenderpassManager(renderpassManager), mSpecification(specification)
+	{
+		// buffers are only created once something is allocated from them
+		for (uint32_t i = 0; i < Pool::Indices; i++)
+		{
+			mPools[i].usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+			mPools[i].granularity = GetVertexStride((VertexLayout)i);
+		}
+
+		// the skinning pre-pass reads the skinned vertices
+		mPools[Pool::SkinnedVertices].usage |= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+
+		// 4 bytes keeps ranges aligned for both index types
+		mPools[Pool::Indices].usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+		mPools[Pool::Indices].granularity = sizeof(uint32_t);
+	}
+
+	GeometryHeap::~GeometryHeap()
+	{
+		VkDevice device = mDevice->GetLogicalDevice();
+		vkDeviceWaitIdle(device);
+
+		for (RetiredBuffer& retired : mRetiredBuffers)
+		{
+			vkDestroyFence(device, retired.fence, nullptr);
+			vkFreeCommandBuffers(device, mRenderpassManager->GetMainRenderpass()->GetSpecificationRef().commandPool, 1, &retired.commandBuffer);
+			vmaDestroyBuffer(mDevice->GetAllocator(), retired.buffer, retired.memory);
+		}
+
+		for (PoolData& data : mPools)
+		{
+			if (data.buffer != VK_NULL_HANDLE)
+			{
+				vmaDestroyBuffer(mDevice->GetAllocator(), data.buffer, data.memory);
+			}
+		}
+	}
+
+	void GeometryHeap::OnUpdate()
+	{
+		VkDevice device = mDevice->GetLogicalDevice();
+
+		// the relocation fence also covers every frame submitted before it, nothing reads the previous buffer anymore
+		for (size_t i = 0; i < mRetiredBuffers.size();)
+		{
+			RetiredBuffer& retired = mRetiredBuffers[i];
+
+			if (vkGetFenceStatus(device, retired.fence) != VK_SUCCESS)
+			{
+				i++;
+				continue;
+			}
+
+			vkDestroyFence(device, retired.fence, nullptr);
+			vkFreeCommandBuffers(device, mRenderpassManager->GetMainRenderpass()->GetSpecificationRef().commandPool, 1, &retired.commandBuffer);
+			vmaDestroyBuffer(mDevice->GetAllocator(), retired.buffer, retired.memory);
+			mPools[retired.pool].relocations--;
+
+			mRetiredBuffers[i] = mRetiredBuffers.back();
+			mRetiredBuffers.pop_back();
+		}
+
+		// compaction happens on the gpu while frames keep being drawn, a pool is only compacted again once the previous one is done
+		for (uint32_t i = 0; i < Pool::PoolCount; i++)
+		{
+			PoolData& data = mPools[i];
+
+			if (data.buffer == VK_NULL_HANDLE || data.relocations > 0)
+				continue;
+
+			VkDeviceSize holes = GetHoles(data);
+
+			if (holes > 0 && (float)holes >= (float)data.used * mSpecification.defragmentThreshold)
+			{
+				COSMOS_LOG(Logger::Trace, "Compacting geometry pool %d: %llu bytes used, %llu bytes in holes", i, (unsigned long long)data.used, (unsigned long long)holes);
+				Relocate((Pool)i, data.capacity);
+			}
+		}
+
+		ResetBindings();
+	}
+
+	GeometryHeap::Handle GeometryHeap::Allocate(Pool pool, VkDeviceSize size)
+	{
+		PoolData& data = mPools[pool];
+		size = AlignUp(size, data.granularity);
+
+		VkDeviceSize offset = 0;
+
+		if (!TakeFreeBlock(data, size, offset))
+		{
+			// relocating also packs the ranges, leaving all the free space at the end of the new buffer
+			VkDeviceSize capacity = data.capacity > 0 ? data.capacity : (pool == Pool::Indices ? mSpecification.indexCapacity : mSpecification.vertexCapacity);
+
+			while (capacity < data.used + size)
+			{
+				capacity *= 2;
+			}
+
+			if (data.buffer != VK_NULL_HANDLE)
+			{
+				capacity = std::max(capacity, data.capacity * 2);
+				COSMOS_LOG(Logger::Trace, "Growing geometry pool %d from %llu to %llu bytes", (uint32_t)pool, (unsigned long long)data.capacity, (unsigned long long)AlignUp(capacity, data.granularity));
+			}
+
+			Relocate(pool, AlignUp(capacity, data.granularity));
+			COSMOS_ASSERT(TakeFreeBlock(data, size, offset), "Geometry pool has no space after growing");
+		}
+
+		data.used += size;
+
+		Handle handle = InvalidHandle;
+
+		if (mFreeHandles.size() > 0)
+		{
+			handle = mFreeHandles.back();
+			mFreeHandles.pop_back();
+		}
+
+		else
+		{
+			handle = (Handle)mRanges.size();
+			mRanges.emplace_back();
+		}
+
+		mRanges[handle].pool = pool;
+		mRanges[handle].offset = offset;
+		mRanges[handle].size = size;
+
+		return handle;
+	}
+
+	void GeometryHeap::Free(Handle handle)
+	{
+		if (handle == InvalidHandle || mRanges[handle].size == 0)
+			return;
+
+		Range& range = mRanges[handle];
+		PoolData& data = mPools[range.pool];
+
+		ReturnFreeBlock(data, range.offset, range.size);
+		data.used -= range.size;
+
+		range = {};
+		mFreeHandles.push_back(handle);
+	}
+
+	void GeometryHeap::RecordUpload(VkCommandBuffer commandBuffer, VkBuffer staging, Handle handle, VkDeviceSize size)
+	{
+		const Range& range = mRanges[handle];
+
+		VkBufferCopy copyRegion = {};
+		copyRegion.srcOffset = 0;
+		copyRegion.dstOffset = range.offset;
+		copyRegion.size = size;
+		vkCmdCopyBuffer(commandBuffer, staging, mPools[range.pool].buffer, 1, &copyRegion);
+	}
+
+	void GeometryHeap::Bind(VkCommandBuffer commandBuffer, Pool vertexPool, VkIndexType indexType)
+	{
+		Bind(commandBuffer, mPools[vertexPool].buffer, indexType);
+	}
+
+	void GeometryHeap::Bind(VkCommandBuffer commandBuffer, VkBuffer vertexBuffer, VkIndexType indexType)
+	{
+		if (mBindings.commandBuffer != commandBuffer)
+		{
+			mBindings = {};
+			mBindings.commandBuffer = commandBuffer;
+		}
+
+		if (mBindings.vertexBuffer != vertexBuffer)
+		{
+			VkDeviceSize offsets[] = { 0 };
+			vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertexBuffer, offsets);
+			mBindings.vertexBuffer = vertexBuffer;
+		}
+
+		// meshes without indices never create the index buffer
+		VkBuffer indexBuffer = mPools[Pool::Indices].buffer;
+
+		if (indexBuffer != VK_NULL_HANDLE && (mBindings.indexBuffer != indexBuffer || mBindings.indexType != indexType))
+		{
+			vkCmdBindIndexBuffer(commandBuffer, indexBuffer, 0, indexType);
+			mBindings.indexBuffer = indexBuffer;
+			mBindings.indexType = indexType;
+		}
+	}
+
+	void GeometryHeap::ResetBindings()
+	{
+		mBindings = {};
+	}
+
+	bool GeometryHeap::TakeFreeBlock(PoolData& data, VkDeviceSize size, VkDeviceSize& offset)
+	{
+		for (auto it = data.freeBlocks.begin(); it != data.freeBlocks.end(); it++)
+		{
+			if (it->second < size)
+				continue;
+
+			offset = it->first;
+			VkDeviceSize remaining = it->second - size;
+			data.freeBlocks.erase(it);
+
+			if (remaining > 0)
+			{
+				data.freeBlocks[offset + size] = remaining;
+			}
+
+			return true;
+		}
+
+		return false;
+	}
+
+	void GeometryHeap::ReturnFreeBlock(PoolData& data, VkDeviceSize offset, VkDeviceSize size)
+	{
+		auto next = data.freeBlocks.lower_bound(offset);
+
+		// merge with the block right after
+		if (next != data.freeBlocks.end() && next->first == offset + size)
+		{
+			size += next->second;
+			next = data.freeBlocks.erase(next);
+		}
+
+		// merge with the block right before
+		if (next != data.freeBlocks.begin())
+		{
+			auto previous = std::prev(next);
+
+			if (previous->first + previous->second == offset)
+			{
+				previous->second += size;
+				return;
+			}
+		}
+
+		data.freeBlocks[offset] = size;
+	}
+
+	VkDeviceSize GeometryHeap::GetHoles(const PoolData& data) const
+	{
+		VkDeviceSize free = data.capacity - data.used;
+
+		if (data.freeBlocks.size() > 0)
+		{
+			auto last = std::prev(data.freeBlocks.end());
+
+			if (last->first + last->second == data.capacity)
+			{
+				free -= last->second;
+			}
+		}
+
+		return free;
+	}
+
+	void GeometryHeap::Relocate(Pool pool, VkDeviceSize capacity)
+	{
+		PoolData& data = mPools[pool];
+		VkDevice device = mDevice->GetLogicalDevice();
+
+		RetiredBuffer retired = {};
+		retired.pool = pool;
+		retired.buffer = data.buffer;
+		retired.memory = data.memory;
+
+		COSMOS_ASSERT(mDevice->CreateBuffer
+		(
+			data.usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			capacity,
+			&data.buffer,
+			&data.memory) == VK_SUCCESS, "Failed to create geometry heap buffer"
+		);
+
+		data.capacity = capacity;
+
+		// ranges keep their order, packed one after the other
+		std::vector<Handle> handles = {};
+
+		for (Handle handle = 0; handle < (Handle)mRanges.size(); handle++)
+		{
+			if (mRanges[handle].size > 0 && mRanges[handle].pool == pool)
+			{
+				handles.push_back(handle);
+			}
+		}
+
+		std::sort(handles.begin(), handles.end(), [this](Handle a, Handle b) { return mRanges[a].offset < mRanges[b].offset; });
+
+		std::vector<VkBufferCopy> copyRegions = {};
+		copyRegions.reserve(handles.size());
+		VkDeviceSize offset = 0;
+
+		for (Handle handle : handles)
+		{
+			Range& range = mRanges[handle];
+
+			VkBufferCopy copyRegion = {};
+			copyRegion.srcOffset = range.offset;
+			copyRegion.dstOffset = offset;
+			copyRegion.size = range.size;
+			copyRegions.push_back(copyRegion);
+
+			range.offset = offset;
+			offset += range.size;
+		}
+
+		data.freeBlocks.clear();
+
+		if (offset < capacity)
+		{
+			data.freeBlocks[offset] = capacity - offset;
+		}
+
+		// the first buffer of a pool has nothing to move
+		if (retired.buffer == VK_NULL_HANDLE)
+			return;
+
+		// draws recorded from now on use the new buffer, the queue order makes the copy land before them
+		retired.commandBuffer = mDevice->CreateCommandBuffer(mRenderpassManager->GetMainRenderpass()->GetSpecificationRef().commandPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
+
+		// uploads into the previous buffer submitted before must land before it's copied
+		VkMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		vkCmdPipelineBarrier(retired.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+		if (copyRegions.size() > 0)
+		{
+			vkCmdCopyBuffer(retired.commandBuffer, retired.buffer, data.buffer, (uint32_t)copyRegions.size(), copyRegions.data());
+		}
+
+		// makes the copy visible to the draws, the compute skinning reading the skinned pool as a storage buffer and the transfers submitted after it
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+		vkCmdPipelineBarrier(retired.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+		COSMOS_ASSERT(vkEndCommandBuffer(retired.commandBuffer) == VK_SUCCESS, "Failed to end the recording of the command buffer");
+
+		VkFenceCreateInfo fenceCI = {};
+		fenceCI.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		COSMOS_ASSERT(vkCreateFence(device, &fenceCI, nullptr, &retired.fence) == VK_SUCCESS, "Failed to create fence for the geometry relocation");
+
+		VkSubmitInfo submitInfo = {};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &retired.commandBuffer;
+
+		// not waited for, the previous buffer is released by a later update
+		COSMOS_ASSERT(vkQueueSubmit(mDevice->GetGraphicsQueue(), 1, &submitInfo, retired.fence) == VK_SUCCESS, "Failed to submit the geometry relocation");
+
+		data.relocations++;
+		mRetiredBuffers.push_back(retired);
+	}
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,158 @@
+#pragma once
+#if defined COSMOS_RENDERER_VULKAN
+
+#include "Renderer/Vertex.h"
+#include "Util/Memory.h"
+#include <volk.h>
+#include "Wrapper/vma.h" // including vma after volk
+
+#include <array>
+#include <map>
+#include <vector>
+
+namespace Cosmos::Vulkan
+{
+	// forward declarations
+	class Device;
+	class RenderpassManager;
+
+	// renderer-owned vertex and index buffers every mesh is suballocated from, so draws only differ by their offsets
+	// there's one vertex buffer per vertex layout, keeping every range a whole number of vertices, and one index buffer
+	// it's only used by the main thread, ranges are written and moved by transfers submitted on the graphics queue
+	class GeometryHeap
+	{
+	public:
+
+		enum Pool : uint32_t
+		{
+			FullVertices = 0,
+			StaticVertices,
+			SkinnedVertices,
+			Indices,
+			PoolCount
+		};
+
+		// identifies an allocated range, it stays valid while the range is moved by defragmentation
+		typedef uint32_t Handle;
+		static constexpr Handle InvalidHandle = UINT32_MAX;
+
+		struct Specification
+		{
+			VkDeviceSize vertexCapacity = 8ull * 1024 * 1024;	// initial size of each vertex buffer, buffers double when full
+			VkDeviceSize indexCapacity = 8ull * 1024 * 1024;	// initial size of the index buffer
+			float defragmentThreshold = 0.25f;					// a pool is compacted once the holes between it's ranges reach this fraction of the used bytes
+		};
+
+	public:
+
+		// constructor
+		GeometryHeap(Shared<Device> device, Shared<RenderpassManager> renderpassManager, Specification specification = {});
+
+		// destructor
+		~GeometryHeap();
+
+		// returns the pool the vertices of a layout are allocated from
+		static inline Pool GetVertexPool(VertexLayout layout) { return (Pool)layout; }
+
+		// returns the buffer of a pool, it changes when the pool grows or is compacted
+		inline VkBuffer GetBuffer(Pool pool) const { return mPools[pool].buffer; }
+
+		// returns the byte offset of a range on it's pool's buffer, it changes when the range is moved
+		inline VkDeviceSize GetOffset(Handle handle) const { return mRanges[handle].offset; }
+
+		// returns how many bytes of a pool are allocated
+		inline VkDeviceSize GetUsed(Pool pool) const { return mPools[pool].used; }
+
+		// returns the size of a pool's buffer
+		inline VkDeviceSize GetCapacity(Pool pool) const { return mPools[pool].capacity; }
+
+	public:
+
+		// releases the buffers whose relocation finished and compacts fragmented pools, called once per frame before recording it
+		void OnUpdate();
+
+		// allocates a range of a pool, growing it if the range doesn't fit
+		Handle Allocate(Pool pool, VkDeviceSize size);
+
+		// returns a range to it's pool, transfers into it must be preceded by a barrier against the draws still reading it
+		void Free(Handle handle);
+
+		// records the copy of a staging buffer into a range
+		void RecordUpload(VkCommandBuffer commandBuffer, VkBuffer staging, Handle handle, VkDeviceSize size);
+
+		// binds a vertex pool and the index buffer, skipped if the command buffer has them bound already
+		void Bind(VkCommandBuffer commandBuffer, Pool vertexPool, VkIndexType indexType);
+
+		// binds a vertex buffer outside of the heap with the heap's index buffer, like the skinned vertices
+		void Bind(VkCommandBuffer commandBuffer, VkBuffer vertexBuffer, VkIndexType indexType);
+
+		// forgets what was bound, command buffers are recorded again every frame
+		void ResetBindings();
+
+	private:
+
+		struct PoolData
+		{
+			VkBufferUsageFlags usage = 0;
+			VkDeviceSize granularity = 1;							// every range and offset is a multiple of it
+			VkDeviceSize capacity = 0;
+			VkDeviceSize used = 0;
+			VkBuffer buffer = VK_NULL_HANDLE;
+			VmaAllocation memory = VK_NULL_HANDLE;
+			std::map<VkDeviceSize, VkDeviceSize> freeBlocks = {};	// offset and size of the free blocks, adjacent blocks are merged
+			uint32_t relocations = 0;								// previous buffers not yet released
+		};
+
+		struct Range
+		{
+			Pool pool = Pool::PoolCount;
+			VkDeviceSize offset = 0;
+			VkDeviceSize size = 0;									// zero for unused handles
+		};
+
+		// a previous buffer of a pool, released once the relocation out of it is done
+		struct RetiredBuffer
+		{
+			Pool pool = Pool::PoolCount;
+			VkBuffer buffer = VK_NULL_HANDLE;
+			VmaAllocation memory = VK_NULL_HANDLE;
+			VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+			VkFence fence = VK_NULL_HANDLE;
+		};
+
+		struct Bindings
+		{
+			VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+			VkBuffer vertexBuffer = VK_NULL_HANDLE;
+			VkBuffer indexBuffer = VK_NULL_HANDLE;
+			VkIndexType indexType = VK_INDEX_TYPE_MAX_ENUM;
+		};
+
+	private:
+
+		// returns the offset of the first free block fitting size, taking it from the pool
+		bool TakeFreeBlock(PoolData& data, VkDeviceSize size, VkDeviceSize& offset);
+
+		// returns a region to the free blocks, merging it with it's neighbours
+		void ReturnFreeBlock(PoolData& data, VkDeviceSize offset, VkDeviceSize size);
+
+		// returns how many free bytes lie between the ranges of a pool, the free space at it's end is not counted
+		VkDeviceSize GetHoles(const PoolData& data) const;
+
+		// moves every range of a pool into a new buffer, packed from it's start, without waiting for the copy
+		void Relocate(Pool pool, VkDeviceSize capacity);
+
+	private:
+
+		Shared<Device> mDevice;
+		Shared<RenderpassManager> mRenderpassManager;
+		Specification mSpecification;
+		std::array<PoolData, Pool::PoolCount> mPools = {};
+		std::vector<Range> mRanges = {};
+		std::vector<Handle> mFreeHandles = {};
+		std::vector<RetiredBuffer> mRetiredBuffers = {};
+		Bindings mBindings = {};
+	};
+}
+
+#endif
\ No newline at end of file
@@ -159,7 +159,7 @@ namespace Cosmos::Vulkan
         mBindingDescriptions.resize(1);
 
         mBindingDescriptions[0].binding = 0;
-        mBindingDescriptions[0].stride = sizeof(Vertex);
+        mBindingDescriptions[0].stride = GetVertexStride(mSpecification.vertexLayout);
         mBindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
 
         return mBindingDescriptions;
@@ -167,6 +167,37 @@ namespace Cosmos::Vulkan
 
     VkVertexInputAttributeDescription Pipeline::GetInputAttributeDescription(uint32_t binding, uint32_t location, Vertex::Component component)
     {
+        // packed layouts are expanded to floats by the input assembler, except the octahedral normal that's decoded by the shader
+        if (mSpecification.vertexLayout == VertexLayout::Static)
+        {
+            switch (component)
+            {
+                case Vertex::Component::POSITION: return VkVertexInputAttributeDescription({ location, binding, VK_FORMAT_R32G32B32_SFLOAT, offsetof(StaticVertex, position) });
+                case Vertex::Component::NORMAL: return VkVertexInputAttributeDescription({ location, binding, VK_FORMAT_R16G16_SNORM, offsetof(StaticVertex, normal) });
+                case Vertex::Component::UV: return VkVertexInputAttributeDescription({ location, binding, VK_FORMAT_R16G16_SFLOAT, offsetof(StaticVertex, uv) });
+                default: break;
+            }
+
+            COSMOS_LOG(Logger::Error, "Vertex component %d is not part of the static vertex layout", component);
+            return VkVertexInputAttributeDescription({});
+        }
+
+        if (mSpecification.vertexLayout == VertexLayout::Skinned)
+        {
+            switch (component)
+            {
+                case Vertex::Component::POSITION: return VkVertexInputAttributeDescription({ location, binding, VK_FORMAT_R32G32B32_SFLOAT, offsetof(SkinnedVertex, position) });
+                case Vertex::Component::NORMAL: return VkVertexInputAttributeDescription({ location, binding, VK_FORMAT_R16G16_SNORM, offsetof(SkinnedVertex, normal) });
+                case Vertex::Component::UV: return VkVertexInputAttributeDescription({ location, binding, VK_FORMAT_R16G16_SFLOAT, offsetof(SkinnedVertex, uv) });
+                case Vertex::Component::JOINT: return VkVertexInputAttributeDescription({ location, binding, VK_FORMAT_R8G8B8A8_UINT, offsetof(SkinnedVertex, joint) });
+                case Vertex::Component::WEIGHT: return VkVertexInputAttributeDescription({ location, binding, VK_FORMAT_R8G8B8A8_UNORM, offsetof(SkinnedVertex, weight) });
+                default: break;
+            }
+
+            COSMOS_LOG(Logger::Error, "Vertex component %d is not part of the skinned vertex layout", component);
+            return VkVertexInputAttributeDescription({});
+        }
+
         switch (component)
         {
             case Vertex::Component::POSITION: return VkVertexInputAttributeDescription({ location, binding, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, position) });
@@ -245,6 +276,21 @@ namespace Cosmos::Vulkan
         CreateSkyboxPipeline();
     }
 
+    const char* PipelineLibrary::GetMeshPipelineName(VertexLayout layout, bool wireframed)
+    {
+        switch (layout)
+        {
+            case VertexLayout::Static: return wireframed ? "Mesh.Static.Wireframed" : "Mesh.Static.Common";
+            case VertexLayout::Skinned: return wireframed ? "Mesh.Skinned.Wireframed" : "Mesh.Skinned.Common";
+            default: return wireframed ? "Mesh.Wireframed" : "Mesh.Common";
+        }
+    }
+
+    const char* PipelineLibrary::GetBakedPipelineName(bool wireframed)
+    {
+        return wireframed ? "Mesh.Baked.Wireframed" : "Mesh.Baked.Common";
+    }
+
     void PipelineLibrary::Insert(const char* nameid, Shared<Pipeline> pipeline)
     {
         auto it = mPipelines.find(nameid);
@@ -285,13 +331,7 @@ namespace Cosmos::Vulkan
             Vertex::Component::UV
         };
 
-        VkPushConstantRange pushConstant = {};
-        pushConstant.offset = 0;
-        pushConstant.size = sizeof(CameraBuffer);
-        pushConstant.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
-        meshSpecification.pushConstants.push_back(pushConstant);
-        
-        meshSpecification.bindings.resize(4);
+        meshSpecification.bindings.resize(8);
         
         // camera ubo
         meshSpecification.bindings[0].binding = 0;
@@ -318,32 +358,88 @@ namespace Cosmos::Vulkan
         meshSpecification.bindings[3].descriptorCount = 1;
         meshSpecification.bindings[3].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
         meshSpecification.bindings[3].pImmutableSamplers = nullptr;
+
+        // instance data, transforms and ids of the entities drawn by an instanced call
+        meshSpecification.bindings[4].binding = 4;
+        meshSpecification.bindings[4].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        meshSpecification.bindings[4].descriptorCount = 1;
+        meshSpecification.bindings[4].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+        meshSpecification.bindings[4].pImmutableSamplers = nullptr;
+
+        // visible instances, written by the culling pass
+        meshSpecification.bindings[5].binding = 5;
+        meshSpecification.bindings[5].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        meshSpecification.bindings[5].descriptorCount = 1;
+        meshSpecification.bindings[5].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+        meshSpecification.bindings[5].pImmutableSamplers = nullptr;
+
+        // joint palettes of the skinned entities, indexed by the instance's palette offset
+        meshSpecification.bindings[6].binding = 6;
+        meshSpecification.bindings[6].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        meshSpecification.bindings[6].descriptorCount = 1;
+        meshSpecification.bindings[6].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+        meshSpecification.bindings[6].pImmutableSamplers = nullptr;
+
+        // baked joint palettes of the mesh's clips, a frame per row
+        meshSpecification.bindings[7].binding = 7;
+        meshSpecification.bindings[7].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        meshSpecification.bindings[7].descriptorCount = 1;
+        meshSpecification.bindings[7].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+        meshSpecification.bindings[7].pImmutableSamplers = nullptr;
         
-        // common
+        // one pair of pipelines per vertex layout, the packed layouts decode their normals and the skinned one reads it's joints
+        Shared<Shader> vertexShader = meshSpecification.vertexShader;
+        Shared<Shader> packedVertexShader = CreateShared<Shader>(mDevice, Shader::Type::Vertex, "MeshPacked.vert", GetAssetSubDir("Shader/mesh_packed.vert"));
+        Shared<Shader> skinnedVertexShader = CreateShared<Shader>(mDevice, Shader::Type::Vertex, "MeshSkinned.vert", GetAssetSubDir("Shader/mesh_skinned.vert"));
+        std::vector<Vertex::Component> components = meshSpecification.vertexComponents;
+        std::vector<Vertex::Component> skinnedComponents = components;
+        skinnedComponents.push_back(Vertex::Component::JOINT);
+        skinnedComponents.push_back(Vertex::Component::WEIGHT);
+
+        auto createPair = [&](const char* common, const char* wireframed)
         {
-            // create normal pipeline
-            mPipelines["Mesh.Common"] = CreateShared<Pipeline>(mDevice, meshSpecification);
-        
-            // modify parameters after initial creation
-            mPipelines["Mesh.Common"]->GetSpecificationRef().RSCI.cullMode = VK_CULL_MODE_BACK_BIT;
-        
-            // build the pipeline
-            mPipelines["Mesh.Common"]->Build(mCache);
-        }
-        
-        // wireframed
+            // common
+            {
+                // create normal pipeline
+                mPipelines[common] = CreateShared<Pipeline>(mDevice, meshSpecification);
+
+                // modify parameters after initial creation
+                mPipelines[common]->GetSpecificationRef().RSCI.cullMode = VK_CULL_MODE_BACK_BIT;
+
+                // build the pipeline
+                mPipelines[common]->Build(mCache);
+            }
+
+            // wireframed
+            {
+                // create
+                mPipelines[wireframed] = CreateShared<Pipeline>(mDevice, meshSpecification);
+
+                // modify parameters after initial creation
+                mPipelines[wireframed]->GetSpecificationRef().RSCI.cullMode = VK_CULL_MODE_BACK_BIT;
+                mPipelines[wireframed]->GetSpecificationRef().RSCI.polygonMode = VK_POLYGON_MODE_LINE;
+                mPipelines[wireframed]->GetSpecificationRef().RSCI.lineWidth = 5.0f;
+
+                // build the pipeline
+                mPipelines[wireframed]->Build(mCache);
+            }
+        };
+
+        for (VertexLayout layout : { VertexLayout::Full, VertexLayout::Static, VertexLayout::Skinned })
         {
-            // create
-            mPipelines["Mesh.Wireframed"] = CreateShared<Pipeline>(mDevice, meshSpecification);
-        
-            // modify parameters after initial creation
-            mPipelines["Mesh.Wireframed"]->GetSpecificationRef().RSCI.cullMode = VK_CULL_MODE_BACK_BIT;
-            mPipelines["Mesh.Wireframed"]->GetSpecificationRef().RSCI.polygonMode = VK_POLYGON_MODE_LINE;
-            mPipelines["Mesh.Wireframed"]->GetSpecificationRef().RSCI.lineWidth = 5.0f;
-        
-            // build the pipeline
-            mPipelines["Mesh.Wireframed"]->Build(mCache);
+            meshSpecification.vertexLayout = layout;
+            meshSpecification.vertexShader = layout == VertexLayout::Full ? vertexShader : layout == VertexLayout::Skinned ? skinnedVertexShader : packedVertexShader;
+            meshSpecification.vertexComponents = layout == VertexLayout::Skinned ? skinnedComponents : components;
+
+            createPair(GetMeshPipelineName(layout, false), GetMeshPipelineName(layout, true));
         }
+
+        // skinned meshes with baked animations, the vertex shader reads the joints of the instance's frame from the animation texture
+        meshSpecification.vertexLayout = VertexLayout::Skinned;
+        meshSpecification.vertexShader = CreateShared<Shader>(mDevice, Shader::Type::Vertex, "MeshBaked.vert", GetAssetSubDir("Shader/mesh_baked.vert"));
+        meshSpecification.vertexComponents = skinnedComponents;
+
+        createPair(GetBakedPipelineName(false), GetBakedPipelineName(true));
     }
 
     void PipelineLibrary::CreateSkyboxPipeline()
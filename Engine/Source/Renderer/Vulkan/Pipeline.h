@@ -26,6 +26,7 @@ namespace Cosmos::Vulkan
             Shared<Shader> vertexShader;
             Shared<Shader> fragmentShader;
             std::vector<Vertex::Component> vertexComponents = {};       // components the vertex have
+            VertexLayout vertexLayout = VertexLayout::Full;             // how the components are stored on the vertex buffer
             bool notPassingVertexData = false;                          // enable this when not passing vertex data to the shader
             std::vector<VkDescriptorSetLayoutBinding> bindings = {};    // binding data (buffer, textures, etc)
             std::vector<VkPushConstantRange> pushConstants = {};        // optioanlly push constant when creating pipeline
@@ -71,10 +72,10 @@ namespace Cosmos::Vulkan
 
     private:
 
-        // returns the binding descriptions, currently it is very simple and only has one binding, used internally
+        // returns the binding descriptions, currently it is very simple and only has one binding with the layout's stride, used internally
         std::vector<VkVertexInputBindingDescription> GetBindingDescriptions();
 
-        // returns the attribute description based on configuration, used internally
+        // returns the attribute description based on configuration and the vertex layout, used internally
         VkVertexInputAttributeDescription GetInputAttributeDescription(uint32_t binding, uint32_t location, Vertex::Component component);
 
         // returns the attribute descriptions, it generates the attributes based on a list of desired attributes, used internally
@@ -115,6 +116,12 @@ namespace Cosmos::Vulkan
         // recreate all pipelines, used when renderpass get's modified
         void RecreatePipelines();
 
+        // returns the name of the mesh pipeline that draws a given vertex layout
+        static const char* GetMeshPipelineName(VertexLayout layout, bool wireframed);
+
+        // returns the name of the mesh pipeline that draws skinned vertices posed by a baked animation
+        static const char* GetBakedPipelineName(bool wireframed);
+
     public:
 
         // inserts a new pipeline into the library
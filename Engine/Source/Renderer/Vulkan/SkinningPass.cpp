@@ -0,0 +1,287 @@
+#include "epch.h"
+#if defined COSMOS_RENDERER_VULKAN
+
+#include "SkinningPass.h"
+
+#include "Device.h"
+#include "Shader.h"
+#include "Renderer/Vertex.h"
+#include "Util/Files.h"
+#include "Util/Logger.h"
+
+#include <algorithm>
+#include <array>
+
+namespace Cosmos::Vulkan
+{
+	SkinningPass::SkinningPass(Shared<Device> device, uint32_t framesInFlight)
+		: mDevice(device)
+	{
+		// skinning is recorded on the graphics queue, the heap's buffers are read without ownership transfers
+		VkCommandPoolCreateInfo cmdPoolInfo = {};
+		cmdPoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		cmdPoolInfo.queueFamilyIndex = mDevice->GetQueueFamilies().graphics.value();
+		cmdPoolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+		COSMOS_ASSERT(vkCreateCommandPool(mDevice->GetLogicalDevice(), &cmdPoolInfo, nullptr, &mCommandPool) == VK_SUCCESS, "Failed to create command pool");
+
+		mFrames.resize(framesInFlight);
+		CreatePipeline();
+
+		// descriptors are always written with a valid buffer, room for a few characters
+		for (FrameData& frame : mFrames)
+		{
+			CreateBuffer(frame, 1024);
+			CreateOutput(frame, 64 * 1024);
+			frame.commandBuffer = mDevice->CreateCommandBuffer(mCommandPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+
+			VkDescriptorSetAllocateInfo descSetAllocInfo = {};
+			descSetAllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+			descSetAllocInfo.descriptorPool = mDescriptorPool;
+			descSetAllocInfo.descriptorSetCount = 1;
+			descSetAllocInfo.pSetLayouts = &mDescriptorSetLayout;
+			COSMOS_ASSERT(vkAllocateDescriptorSets(mDevice->GetLogicalDevice(), &descSetAllocInfo, &frame.descriptorSet) == VK_SUCCESS, "Failed to allocate skinning descriptor set");
+		}
+	}
+
+	SkinningPass::~SkinningPass()
+	{
+		vkDeviceWaitIdle(mDevice->GetLogicalDevice());
+
+		VkDevice device = mDevice->GetLogicalDevice();
+
+		for (FrameData& frame : mFrames)
+		{
+			DestroyBuffer(frame);
+			DestroyOutput(frame);
+		}
+
+		vkDestroyPipeline(device, mPipeline, nullptr);
+		vkDestroyPipelineLayout(device, mPipelineLayout, nullptr);
+		vkDestroyDescriptorSetLayout(device, mDescriptorSetLayout, nullptr);
+		vkDestroyDescriptorPool(device, mDescriptorPool, nullptr);
+		vkDestroyCommandPool(device, mCommandPool, nullptr);
+	}
+
+	glm::mat4* SkinningPass::BeginFrame(uint32_t frame, uint32_t count)
+	{
+		mCurrentFrame = frame;
+		FrameData& data = mFrames[frame];
+
+		mJobs.clear();
+		mOutputUsed = 0;
+
+		// instances that didn't fit the last time are skinned by the pre-pass from now on, the frame's draws are done with it
+		if (mRequiredVertices > data.outputCapacity)
+		{
+			DestroyOutput(data);
+			CreateOutput(data, std::max(mRequiredVertices, data.outputCapacity * 2));
+		}
+
+		mRequiredVertices = 0;
+
+		// nothing was drawn with the buffer on this frame yet, meshes write the new one into their descriptors
+		if (count > data.capacity)
+		{
+			uint32_t capacity = data.capacity;
+
+			while (capacity < count)
+			{
+				capacity *= 2;
+			}
+
+			DestroyBuffer(data);
+			CreateBuffer(data, capacity);
+		}
+
+		return (glm::mat4*)data.mapped;
+	}
+
+	uint32_t SkinningPass::Skin(uint32_t firstVertex, uint32_t vertexCount, uint32_t instance)
+	{
+		if (!mComputeSkinning || vertexCount == 0)
+			return UINT32_MAX;
+
+		mRequiredVertices += vertexCount;
+
+		if (mOutputUsed + vertexCount > mFrames[mCurrentFrame].outputCapacity)
+			return UINT32_MAX;
+
+		SkinJob job = {};
+		job.firstVertex = firstVertex;
+		job.vertexCount = vertexCount;
+		job.outputVertex = mOutputUsed;
+		job.instance = instance;
+		mJobs.push_back(job);
+
+		mOutputUsed += vertexCount;
+		return job.outputVertex;
+	}
+
+	VkCommandBuffer SkinningPass::Record(VkBuffer vertices, VkBuffer instances)
+	{
+		if (mJobs.empty())
+			return VK_NULL_HANDLE;
+
+		FrameData& data = mFrames[mCurrentFrame];
+
+		// the heap may have moved the vertices since the last frame, the set is written every time
+		std::array<VkBuffer, 4> buffers = { vertices, instances, data.buffer, data.output };
+		std::array<VkDescriptorBufferInfo, 4> infos = {};
+		std::array<VkWriteDescriptorSet, 4> writes = {};
+
+		for (uint32_t i = 0; i < (uint32_t)buffers.size(); i++)
+		{
+			infos[i].buffer = buffers[i];
+			infos[i].offset = 0;
+			infos[i].range = VK_WHOLE_SIZE;
+
+			writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			writes[i].dstSet = data.descriptorSet;
+			writes[i].dstBinding = i;
+			writes[i].dstArrayElement = 0;
+			writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			writes[i].descriptorCount = 1;
+			writes[i].pBufferInfo = &infos[i];
+		}
+
+		vkUpdateDescriptorSets(mDevice->GetLogicalDevice(), (uint32_t)writes.size(), writes.data(), 0, nullptr);
+
+		VkCommandBuffer cmdBuffer = data.commandBuffer;
+		vkResetCommandBuffer(cmdBuffer, 0);
+		mDevice->BeginCommandBuffer(cmdBuffer);
+
+		// one dispatch per instance, one invocation per vertex
+		vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, mPipelineLayout, 0, 1, &data.descriptorSet, 0, nullptr);
+		vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, mPipeline);
+
+		for (const SkinJob& job : mJobs)
+		{
+			vkCmdPushConstants(cmdBuffer, mPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(SkinJob), &job);
+			vkCmdDispatch(cmdBuffer, (job.vertexCount + 63) / 64, 1, 1);
+		}
+
+		// submitted before the draws on the same queue, the barrier covers the command buffers after it
+		VkMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+		vkCmdPipelineBarrier(cmdBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+		COSMOS_ASSERT(vkEndCommandBuffer(cmdBuffer) == VK_SUCCESS, "Failed to end the recording of the skinning command buffer");
+
+		mJobs.clear();
+		mOutputUsed = 0;
+
+		return cmdBuffer;
+	}
+
+	void SkinningPass::CreateBuffer(FrameData& frame, uint32_t capacity)
+	{
+		mDevice->CreateBuffer
+		(
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			sizeof(glm::mat4) * capacity,
+			&frame.buffer,
+			&frame.memory
+		);
+
+		vmaMapMemory(mDevice->GetAllocator(), frame.memory, &frame.mapped);
+		frame.capacity = capacity;
+		frame.version++;
+	}
+
+	void SkinningPass::DestroyBuffer(FrameData& frame)
+	{
+		if (frame.buffer == VK_NULL_HANDLE)
+			return;
+
+		vmaUnmapMemory(mDevice->GetAllocator(), frame.memory);
+		vmaDestroyBuffer(mDevice->GetAllocator(), frame.buffer, frame.memory);
+		frame.buffer = VK_NULL_HANDLE;
+		frame.memory = VK_NULL_HANDLE;
+		frame.mapped = nullptr;
+	}
+
+	void SkinningPass::CreateOutput(FrameData& frame, uint32_t capacity)
+	{
+		mDevice->CreateBuffer
+		(
+			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			sizeof(StaticVertex) * capacity,
+			&frame.output,
+			&frame.outputMemory
+		);
+
+		frame.outputCapacity = capacity;
+	}
+
+	void SkinningPass::DestroyOutput(FrameData& frame)
+	{
+		if (frame.output == VK_NULL_HANDLE)
+			return;
+
+		vmaDestroyBuffer(mDevice->GetAllocator(), frame.output, frame.outputMemory);
+		frame.output = VK_NULL_HANDLE;
+		frame.outputMemory = VK_NULL_HANDLE;
+		frame.outputCapacity = 0;
+	}
+
+	void SkinningPass::CreatePipeline()
+	{
+		VkDevice device = mDevice->GetLogicalDevice();
+
+		// skinned vertices, instances, palettes, output vertices
+		std::array<VkDescriptorSetLayoutBinding, 4> bindings = {};
+
+		for (uint32_t i = 0; i < (uint32_t)bindings.size(); i++)
+		{
+			bindings[i].binding = i;
+			bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			bindings[i].descriptorCount = 1;
+			bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+			bindings[i].pImmutableSamplers = nullptr;
+		}
+
+		VkDescriptorSetLayoutCreateInfo descSetLayoutCI = {};
+		descSetLayoutCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		descSetLayoutCI.bindingCount = (uint32_t)bindings.size();
+		descSetLayoutCI.pBindings = bindings.data();
+		COSMOS_ASSERT(vkCreateDescriptorSetLayout(device, &descSetLayoutCI, nullptr, &mDescriptorSetLayout) == VK_SUCCESS, "Failed to create skinning descriptor set layout");
+
+		VkPushConstantRange pushConstant = {};
+		pushConstant.offset = 0;
+		pushConstant.size = sizeof(SkinJob);
+		pushConstant.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+		VkPipelineLayoutCreateInfo pipelineLayoutCI = {};
+		pipelineLayoutCI.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutCI.setLayoutCount = 1;
+		pipelineLayoutCI.pSetLayouts = &mDescriptorSetLayout;
+		pipelineLayoutCI.pushConstantRangeCount = 1;
+		pipelineLayoutCI.pPushConstantRanges = &pushConstant;
+		COSMOS_ASSERT(vkCreatePipelineLayout(device, &pipelineLayoutCI, nullptr, &mPipelineLayout) == VK_SUCCESS, "Failed to create skinning pipeline layout");
+
+		Shared<Shader> skinShader = CreateShared<Shader>(mDevice, Shader::Type::Compute, "Skin.comp", GetAssetSubDir("Shader/skin.comp"));
+
+		VkComputePipelineCreateInfo pipelineCI = {};
+		pipelineCI.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+		pipelineCI.layout = mPipelineLayout;
+		pipelineCI.stage = skinShader->GetShaderStageCreateInfoRef();
+		COSMOS_ASSERT(vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipelineCI, nullptr, &mPipeline) == VK_SUCCESS, "Failed to create skinning pipeline");
+
+		VkDescriptorPoolSize poolSize = {};
+		poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		poolSize.descriptorCount = (uint32_t)bindings.size() * (uint32_t)mFrames.size();
+
+		VkDescriptorPoolCreateInfo descPoolCI = {};
+		descPoolCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		descPoolCI.poolSizeCount = 1;
+		descPoolCI.pPoolSizes = &poolSize;
+		descPoolCI.maxSets = (uint32_t)mFrames.size();
+		COSMOS_ASSERT(vkCreateDescriptorPool(device, &descPoolCI, nullptr, &mDescriptorPool) == VK_SUCCESS, "Failed to create skinning descriptor pool");
+	}
+}
+
+#endif
\ No newline at end of file
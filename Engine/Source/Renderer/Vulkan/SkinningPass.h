@@ -0,0 +1,123 @@
+#pragma once
+#if defined COSMOS_RENDERER_VULKAN
+
+#include "Util/Math.h"
+#include "Util/Memory.h"
+#include <volk.h>
+#include "Wrapper/vma.h" // including vma after volk
+
+#include <vector>
+
+namespace Cosmos::Vulkan
+{
+	// forward declarations
+	class Device;
+	class Shader;
+
+	// joint palettes of every skinned entity drawn on a frame, all of them on a single storage buffer per frame
+	// entities get a range of it every frame and their instances index it by offset, the buffer only grows
+	// optionally the skinned instances are skinned once by a compute pre-pass into an output vertex buffer,
+	// every pass then draws them as static vertices, instead of skinning them again in each vertex shader
+	class SkinningPass
+	{
+	public:
+
+		// constructor
+		SkinningPass(Shared<Device> device, uint32_t framesInFlight);
+
+		// destructor
+		~SkinningPass();
+
+		// returns the palette buffer of a frame
+		inline VkBuffer GetPaletteBuffer(uint32_t frame) const { return mFrames[frame].buffer; }
+
+		// returns how many times a frame's palette buffer was created, descriptors written with an older version must be written again
+		inline uint32_t GetVersion(uint32_t frame) const { return mFrames[frame].version; }
+
+		// returns the skinned vertices of a frame, in the static vertex layout
+		inline VkBuffer GetOutputBuffer(uint32_t frame) const { return mFrames[frame].output; }
+
+		// returns if skinned instances are skinned by the compute pre-pass
+		inline bool IsComputeSkinning() const { return mComputeSkinning; }
+
+		// enables the compute pre-pass, otherwise the vertex shader skins every vertex it draws
+		inline void SetComputeSkinning(bool value) { mComputeSkinning = value; }
+
+	public:
+
+		// returns a frame's palettes with room for count matrices, the frame's previous submission must be done
+		glm::mat4* BeginFrame(uint32_t frame, uint32_t count);
+
+		// requests the skinning of an instance's vertices, returning the first one on the output buffer
+		// returns UINT32_MAX if the pre-pass is disabled or the output is full this frame, the instance must then be skinned by the vertex shader
+		uint32_t Skin(uint32_t firstVertex, uint32_t vertexCount, uint32_t instance);
+
+		// records the requested skinning of the current frame, returns null if nothing was requested
+		// it's submitted on the graphics queue before the draws, the source and instance buffers are the ones of this frame
+		VkCommandBuffer Record(VkBuffer vertices, VkBuffer instances);
+
+	private:
+
+		struct FrameData
+		{
+			VkBuffer buffer = VK_NULL_HANDLE;
+			VmaAllocation memory = VK_NULL_HANDLE;
+			void* mapped = nullptr;
+			uint32_t capacity = 0;		// in matrices
+			uint32_t version = 0;
+
+			// compute skinning
+			VkBuffer output = VK_NULL_HANDLE;
+			VmaAllocation outputMemory = VK_NULL_HANDLE;
+			uint32_t outputCapacity = 0;	// in vertices
+			VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+			VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+		};
+
+		// a skinned instance, matches the skinning shader's push constants
+		struct SkinJob
+		{
+			uint32_t firstVertex = 0;
+			uint32_t vertexCount = 0;
+			uint32_t outputVertex = 0;
+			uint32_t instance = 0;
+		};
+
+	private:
+
+		// creates the palette buffer of a frame with room for capacity matrices
+		void CreateBuffer(FrameData& frame, uint32_t capacity);
+
+		// destroys the palette buffer of a frame
+		void DestroyBuffer(FrameData& frame);
+
+		// creates the output vertex buffer of a frame with room for capacity vertices
+		void CreateOutput(FrameData& frame, uint32_t capacity);
+
+		// destroys the output vertex buffer of a frame
+		void DestroyOutput(FrameData& frame);
+
+		// creates the skinning compute pipeline and it's descriptor sets
+		void CreatePipeline();
+
+	private:
+
+		Shared<Device> mDevice;
+		std::vector<FrameData> mFrames = {};
+		uint32_t mCurrentFrame = 0;
+		bool mComputeSkinning = false;
+
+		// requested this frame, the output can't grow while the draws reading it are recorded so it grows on the next one
+		std::vector<SkinJob> mJobs = {};
+		uint32_t mOutputUsed = 0;
+		uint32_t mRequiredVertices = 0;
+
+		VkCommandPool mCommandPool = VK_NULL_HANDLE;
+		VkDescriptorPool mDescriptorPool = VK_NULL_HANDLE;
+		VkDescriptorSetLayout mDescriptorSetLayout = VK_NULL_HANDLE;
+		VkPipelineLayout mPipelineLayout = VK_NULL_HANDLE;
+		VkPipeline mPipeline = VK_NULL_HANDLE;
+	};
+}
+
+#endif
\ No newline at end of file
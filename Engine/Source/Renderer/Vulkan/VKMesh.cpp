@@ -1,9 +1,11 @@
 #include "epch.h"
 #if defined COSMOS_RENDERER_VULKAN
 
+#include "CullingPass.h"
 #include "Device.h"
 #include "Pipeline.h"
 #include "Renderpass.h"
+#include "SkinningPass.h"
 #include "VKMesh.h"
 #include "VKTexture.h"
 #include "VKRenderer.h"
@@ -11,13 +13,24 @@
 #include "Entity/Unique/Camera.h"
 #include "Platform/Window.h"
 #include "Renderer/Buffer.h"
+#include "Util/Arena.h"
 #include "Util/Files.h"
 #include "Util/Logger.h"
+#include "Util/ThreadPool.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <new>
+#include <unordered_set>
 
 namespace Cosmos::Vulkan::GLTF
 {
-	Primitive::Primitive(uint32_t firstIndex, uint32_t indexCount, uint32_t vertexCount, Cosmos::Mesh::Material& material)
-		: firstIndex(firstIndex), indexCount(indexCount), vertexCount(vertexCount), material(material)
+	Primitive::Primitive(uint32_t firstIndex, uint32_t indexCount, uint32_t vertexStart, uint32_t vertexCount, Cosmos::Mesh::Material& material)
+		: firstIndex(firstIndex), indexCount(indexCount), vertexStart(vertexStart), vertexCount(vertexCount), material(material)
 	{
 		hasIndices = indexCount > 0;
 	}
@@ -29,36 +42,6 @@ namespace Cosmos::Vulkan::GLTF
 		bb.SetValid(true);
 	}
 
-	Mesh::Mesh(Shared<Cosmos::Vulkan::Device> device, glm::mat4 matrix)
-		: device(device)
-	{
-		uniformBlock.matrix = matrix;
-
-		COSMOS_ASSERT
-		(
-			device->CreateBuffer
-			(
-				VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-				sizeof(uniformBlock),
-				&uniformBuffer.buffer,
-				&uniformBuffer.memory,
-				&uniformBlock
-			) == VK_SUCCESS, "Failed to create Unfiform Buffer"
-		);
-
-		COSMOS_ASSERT(vmaMapMemory(device->GetAllocator(), uniformBuffer.memory, &uniformBuffer.mapped) == VK_SUCCESS, "Failed to map memory");
-		uniformBuffer.descriptor = { uniformBuffer.buffer, 0, sizeof(uniformBlock) };
-	}
-
-	Mesh::~Mesh()
-	{
-		vkDeviceWaitIdle(device->GetLogicalDevice());
-		vmaUnmapMemory(device->GetAllocator(), uniformBuffer.memory);
-		vmaDestroyBuffer(device->GetAllocator(), uniformBuffer.buffer, uniformBuffer.memory);
-		for (Primitive* p : primitives) delete p;
-	}
-
 	void Mesh::SetBoundingBox(glm::vec3 min, glm::vec3 max)
 	{
 		bb.SetMin(min);
@@ -66,71 +49,79 @@ namespace Cosmos::Vulkan::GLTF
 		bb.SetValid(true);
 	}
 
-	Node::~Node()
+	void Mesh::CalculateBoundingBox()
 	{
-		if (mesh) 
-			delete mesh;
+		for (const Primitive& p : primitives)
+		{
+			if (p.bb.IsValid() && !bb.IsValid())
+			{
+				bb = p.bb;
+				bb.SetValid(true);
+			}
 
-		for (auto& child : children) 
-			delete child;
+			bb.SetMin(glm::min(bb.GetMin(), p.bb.GetMin()));
+			bb.SetMax(glm::max(bb.GetMax(), p.bb.GetMax()));
+		}
 	}
 
-	glm::mat4 Node::GetLocalMatrix()
+	void Hierarchy::Build(const std::vector<Node*>& roots, std::vector<Node*>& linearNodes)
 	{
-		return glm::translate(glm::mat4(1.0f), translation) * glm::mat4(rotation) * glm::scale(glm::mat4(1.0f), scale) * matrix;
-	}
+		Clear();
+		linearNodes.clear();
 
-	glm::mat4 Node::GetMatrix()
-	{
-		glm::mat4 m = GetLocalMatrix();
-		Node* p = parent;
-		while (p)
-		{
-			m = p->GetLocalMatrix() * m;
-			p = p->parent;
-		}
-		
-		return m;
-	}
+		// children are pushed in reverse so they're listed in their order
+		std::vector<Node*> stack(roots.rbegin(), roots.rend());
 
-	void Node::OnUpdate()
-	{
-		if (mesh)
+		while (!stack.empty())
 		{
-			glm::mat4 m = GetMatrix();
-			if (skin)
+			Node* node = stack.back();
+			stack.pop_back();
+
+			node->linearIndex = (uint32_t)linearNodes.size();
+			linearNodes.push_back(node);
+			parents.push_back(node->parent ? (int32_t)node->parent->linearIndex : -1);
+			subtreeEnds.push_back(node->linearIndex + 1);
+			rest.translations.push_back(node->translation);
+			rest.rotations.push_back(node->rotation);
+			rest.scales.push_back(node->scale);
+			matrices.push_back(node->matrix);
+
+			for (uint32_t c = node->children.count; c-- > 0;)
 			{
-				mesh->uniformBlock.matrix = m;
-
-				// update join matrices
-				glm::mat4 inverseTransform = glm::inverse(m);
-				size_t numJoints = std::min((uint32_t)skin->joints.size(), MAX_NUM_JOINTS);
-
-				for (size_t i = 0; i < numJoints; i++)
-				{
-					Node* jointNode = skin->joints[i];
-					glm::mat4 jointMat = jointNode->GetMatrix() * skin->inverseBindMatrices[i];
-					jointMat = inverseTransform * jointMat;
-					mesh->uniformBlock.jointMatrix[i] = jointMat;
-				}
-
-				mesh->uniformBlock.jointcount = static_cast<uint32_t>(numJoints);
-				memcpy(mesh->uniformBuffer.mapped, &mesh->uniformBlock, sizeof(mesh->uniformBlock));
+				stack.push_back(node->children[c]);
 			}
+		}
 
-			else
+		rest.globals.assign(linearNodes.size(), glm::mat4(1.0f));
+
+		// walking backwards every subtree is finished before it's parent
+		for (size_t i = linearNodes.size(); i-- > 0;)
+		{
+			if (parents[i] > -1)
 			{
-				memcpy(mesh->uniformBuffer.mapped, &m, sizeof(glm::mat4));
+				subtreeEnds[parents[i]] = std::max(subtreeEnds[parents[i]], subtreeEnds[i]);
 			}
 		}
+	}
 
-		for (auto& child : children)
+	void Hierarchy::UpdateGlobals(Cosmos::Mesh::Pose& pose, uint32_t first, uint32_t end) const
+	{
+		for (uint32_t i = first; i < end; i++)
 		{
-			child->OnUpdate();
+			glm::mat4 local = glm::translate(glm::mat4(1.0f), pose.translations[i]) * glm::mat4(pose.rotations[i]) * glm::scale(glm::mat4(1.0f), pose.scales[i]) * matrices[i];
+			pose.globals[i] = parents[i] > -1 ? MultiplySIMD(pose.globals[parents[i]], local) : local;
 		}
 	}
 
-	glm::vec4 Animation::Sampler::CubicSplineInterpolation(size_t index, float time, uint32_t stride)
+	void Hierarchy::Clear()
+	{
+		parents.clear();
+		subtreeEnds.clear();
+		matrices.clear();
+		rest = {};
+	}
+
+	glm::vec4 Animation::Sampler::CubicSplineInterpolation(size_t index, float time, uint32_t stride) const
 	{
 		float delta = inputs[index + 1] - inputs[index];
 		float t = (time - inputs[index]) / delta;
@@ -154,84 +145,112 @@ namespace Cosmos::Vulkan::GLTF
 		return pt;
 	}
 
-	void Animation::Sampler::Translate(size_t index, float time, Node* node)
+	size_t Animation::Sampler::FindKeyframe(float time, uint32_t& cursor) const
+	{
+		const size_t last = inputs.size() - 2;
+		size_t index = std::min<size_t>(cursor, last);
+
+		// sequential playback stays on the same interval or moves into the next one
+		if (time < inputs[index] || time > inputs[index + 1])
+		{
+			if (index < last && time > inputs[index + 1] && time <= inputs[index + 2])
+			{
+				index++;
+			}
+
+			// seeks, wraps and large steps
+			else
+			{
+				size_t upper = (size_t)(std::upper_bound(inputs.begin(), inputs.end(), time) - inputs.begin());
+				index = std::min(upper > 0 ? upper - 1 : 0, last);
+			}
+		}
+
+		cursor = (uint32_t)index;
+		return index;
+	}
+
+	void Animation::Sampler::Translate(size_t index, float time, glm::vec3& translation) const
 	{
 		switch (interpolation)
 		{
 			case Sampler::InterpolationType::LINEAR:
 			{
 				float u = std::max(0.0f, time - inputs[index]) / (inputs[index + 1] - inputs[index]);
-				node->translation = glm::mix(outputsVec4[index], outputsVec4[index + 1], u);
+				translation = glm::mix(track.Decode(index), track.Decode(index + 1), u);
 				break;
 			}
 
 			case Sampler::InterpolationType::STEP:
 			{
-				node->translation = outputsVec4[index];
+				translation = track.Decode(index);
 				break;
 			}
 
 			case Sampler::InterpolationType::CUBICSPLINE:
 			{
-				node->translation = CubicSplineInterpolation(index, time, 3);
+				translation = CubicSplineInterpolation(index, time, 3);
 				break;
 			}
 		}
 	}
 
-	void Animation::Sampler::Scale(size_t index, float time, Node* node)
+	void Animation::Sampler::Scale(size_t index, float time, glm::vec3& scale) const
 	{
 		switch (interpolation)
 		{
 			case Sampler::InterpolationType::LINEAR:
 			{
 				float u = std::max(0.0f, time - inputs[index]) / (inputs[index + 1] - inputs[index]);
-				node->scale = glm::mix(outputsVec4[index], outputsVec4[index + 1], u);
+				scale = glm::mix(track.Decode(index), track.Decode(index + 1), u);
 				break;
 			}
 		
 			case Sampler::InterpolationType::STEP:
 			{
-				node->scale = outputsVec4[index];
+				scale = track.Decode(index);
 				break;
 			}
 		
 			case Sampler::InterpolationType::CUBICSPLINE:
 			{
-				node->scale = CubicSplineInterpolation(index, time, 3);
+				scale = CubicSplineInterpolation(index, time, 3);
 				break;
 			}
 		}
 	}
 
-	void Animation::Sampler::Rotate(size_t index, float time, Node* node)
+	void Animation::Sampler::Rotate(size_t index, float time, glm::quat& rotation) const
 	{
 		switch (interpolation)
 		{
 			case Sampler::InterpolationType::LINEAR:
 			{
 				float u = std::max(0.0f, time - inputs[index]) / (inputs[index + 1] - inputs[index]);
+				glm::vec4 k1 = track.Decode(index);
+				glm::vec4 k2 = track.Decode(index + 1);
 				glm::quat q1;
-				q1.x = outputsVec4[index].x;
-				q1.y = outputsVec4[index].y;
-				q1.z = outputsVec4[index].z;
-				q1.w = outputsVec4[index].w;
+				q1.x = k1.x;
+				q1.y = k1.y;
+				q1.z = k1.z;
+				q1.w = k1.w;
 				glm::quat q2;
-				q2.x = outputsVec4[index + 1].x;
-				q2.y = outputsVec4[index + 1].y;
-				q2.z = outputsVec4[index + 1].z;
-				q2.w = outputsVec4[index + 1].w;
-				node->rotation = glm::normalize(glm::slerp(q1, q2, u));
+				q2.x = k2.x;
+				q2.y = k2.y;
+				q2.z = k2.z;
+				q2.w = k2.w;
+				rotation = glm::normalize(glm::slerp(q1, q2, u));
 				break;
 			}
 			case Sampler::InterpolationType::STEP:
 			{
+				glm::vec4 k1 = track.Decode(index);
 				glm::quat q1;
-				q1.x = outputsVec4[index].x;
-				q1.y = outputsVec4[index].y;
-				q1.z = outputsVec4[index].z;
-				q1.w = outputsVec4[index].w;
-				node->rotation = q1;
+				q1.x = k1.x;
+				q1.y = k1.y;
+				q1.z = k1.z;
+				q1.w = k1.w;
+				rotation = glm::normalize(q1);
 				break;
 			}
 			case Sampler::InterpolationType::CUBICSPLINE:
@@ -242,7 +261,7 @@ namespace Cosmos::Vulkan::GLTF
 				q.y = rot.y;
 				q.z = rot.z;
 				q.w = rot.w;
-				node->rotation = glm::normalize(q);
+				rotation = glm::normalize(q);
 				break;
 			}
 		}
@@ -251,6 +270,15 @@ namespace Cosmos::Vulkan::GLTF
 
 namespace Cosmos::Vulkan
 {
+	// returns the extension of a file in lower case
+	static std::string GetExtension(const std::string& filepath)
+	{
+		std::string extension = std::filesystem::path(filepath).extension().string();
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+
+		return extension;
+	}
+
 	VKMesh::VKMesh(Shared<VKRenderer> renderer)
 		: mRenderer(renderer)
 	{
@@ -258,269 +286,1544 @@ namespace Cosmos::Vulkan
 
 	VKMesh::~VKMesh()
 	{
-		vkDeviceWaitIdle(mRenderer->GetDevice()->GetLogicalDevice());
+		ReleaseLoader();
+		ReleaseModel();
+	}
 
-		vkDestroyDescriptorPool(mRenderer->GetDevice()->GetLogicalDevice(), mDescriptorPool, nullptr);
+	void VKMesh::OnUpdate(float timestep)
+	{
+		PruneColormapOverrides(false);
 
-		if (mVertexBuffer != VK_NULL_HANDLE)
-		{
-			vmaDestroyBuffer(mRenderer->GetDevice()->GetAllocator(), mVertexBuffer, mVertexMemory);
-			mVertexBuffer = VK_NULL_HANDLE;
-		}
+		if (mLoader == nullptr)
+			return;
 
-		if (mIndexBuffer != VK_NULL_HANDLE)
+		// loading progresses here, the mesh is only rendered once it's done
+		switch (mLoader->state)
 		{
-			vmaDestroyBuffer(mRenderer->GetDevice()->GetAllocator(), mIndexBuffer, mIndexMemory);
-			mIndexBuffer = VK_NULL_HANDLE;
-		}
-
-		mAnimations.resize(0);
+			case LoaderInfo::State::Decoded:
+			{
+				FinishDecoding();
+				break;
+			}
 
-		for (auto node : mNodes) delete node;
-		mNodes.resize(0);
-		mLinearNodes.resize(0);
+			case LoaderInfo::State::Uploading:
+			{
+				FinishUploading();
+				break;
+			}
 
-		for (auto skin : mSkins) delete skin;
-		mSkins.resize(0);
-	}
+			case LoaderInfo::State::Failed:
+			{
+				COSMOS_LOG(Logger::Error, "Failed to load mesh %s, error: %s", mLoader->filepath.c_str(), mLoader->error.c_str());
+				ReleaseLoader();
+				break;
+			}
 
-	void VKMesh::OnUpdate(float timestep)
-	{
+			default: break;
+		}
 	}
 
-	void VKMesh::OnRender(void* commandBuffer, glm::mat4& transform, uint32_t id)
+	void VKMesh::OnRender(void* commandBuffer, uint32_t firstInstance, uint32_t instanceCount, const Instance& instance)
 	{
 		uint32_t currentFrame = mRenderer->GetCurrentFrame();
-		VkDeviceSize offsets[] = { 0 };
+		Shared<GeometryHeap> heap = mRenderer->GetGeometryHeap();
 
 		//mRenderer->GetRenderpassManager()->GetMainRenderpass()->GetSpecificationRef().commandBuffers[currentFrame];
 		VkCommandBuffer cmdBuffer = (VkCommandBuffer)commandBuffer; 
-		VkPipelineLayout pipelineLayout = mRenderer->GetPipelineLibrary()->GetPipelinesRef()["Mesh.Common"]->GetPipelineLayout();
-		VkPipeline pipeline = mRenderer->GetPipelineLibrary()->GetPipelinesRef()["Mesh.Common"]->GetPipeline();
+		// every vertex layout has it's own pipelines, their descriptor set layouts are the same
+		// meshes with baked animations are posed by the animation texture instead of the joint palettes
+		const char* pipelineName = mBakedAnimation ? PipelineLibrary::GetBakedPipelineName(instance.wiredframe) : PipelineLibrary::GetMeshPipelineName(mVertexLayout, instance.wiredframe);
+		VkPipelineLayout pipelineLayout = mRenderer->GetPipelineLibrary()->GetPipelinesRef()[pipelineName]->GetPipelineLayout();
+		VkPipeline pipeline = mRenderer->GetPipelineLibrary()->GetPipelinesRef()[pipelineName]->GetPipeline();
+
+		// the heap buffers are only bound when the previous mesh used another layout or index type
+		heap->Bind(cmdBuffer, GeometryHeap::GetVertexPool(mVertexLayout), mIndexType);
+		VkDescriptorSet descriptorSet = GetDescriptorSet(instance, currentFrame);
+		vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSet, 0, NULL);
+		vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+
+		// the ranges may move between frames, their offsets are read every time
+		uint32_t indexBase = 0;
+		int32_t vertexBase = (int32_t)(heap->GetOffset(mVertexRange) / GetVertexStride(mVertexLayout));
 
-		if (mWiredframe)
+		if (mIndexRange != GeometryHeap::InvalidHandle)
 		{
-			pipeline = mRenderer->GetPipelineLibrary()->GetPipelinesRef()["Mesh.Wireframed"]->GetPipeline();
-			pipelineLayout = mRenderer->GetPipelineLibrary()->GetPipelinesRef()["Mesh.Wireframed"]->GetPipelineLayout();
+			indexBase = (uint32_t)(heap->GetOffset(mIndexRange) / (mIndexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t)));
 		}
 
-		vkCmdBindVertexBuffers(cmdBuffer, 0, 1, &mVertexBuffer, offsets);
-		vkCmdBindIndexBuffer(cmdBuffer, mIndexBuffer, 0, VK_INDEX_TYPE_UINT32);
-		vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &mDescriptorSets[mRenderer->GetCurrentFrame()], 0, NULL);
-		vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+		// every primitive becomes a command of the batch, drawn only if an instance is inside the frustum
+		FrameVector<VkDrawIndexedIndirectCommand> commands = {};
+
+		for (auto& node : mLinearNodes)
+		{
+			DrawNode(node, commands, indexBase, vertexBase, firstInstance);
+		}
 
-		ObjectPushConstant constants = {};
-		constants.id = id;
-		constants.model = transform;
-		vkCmdPushConstants(cmdBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(ObjectPushConstant), &constants);
+		if (commands.empty())
+			return;
 
-		// render all nodes at top-level
-		for (auto& node : mNodes)
+		// instances skinned by the pre-pass have their own vertices, each one is a batch drawn by the static pipeline
+		// the ones that didn't fit the output are drawn together by the skinned pipeline
+		if (mVertexLayout == VertexLayout::Skinned && mBakedAnimation == nullptr && mRenderer->GetSkinningPass()->IsComputeSkinning())
 		{
-			DrawNode(node, cmdBuffer, pipelineLayout);
+			Shared<SkinningPass> skinning = mRenderer->GetSkinningPass();
+			const char* staticName = PipelineLibrary::GetMeshPipelineName(VertexLayout::Static, instance.wiredframe);
+			Shared<Pipeline> staticPipeline = mRenderer->GetPipelineLibrary()->GetPipelinesRef()[staticName];
+			FrameVector<VkDrawIndexedIndirectCommand> skinnedCommands = commands;
+			uint32_t remaining = 0;
+
+			for (uint32_t i = 0; i < instanceCount; i++)
+			{
+				uint32_t outputVertex = skinning->Skin((uint32_t)vertexBase, mVertexCount, firstInstance + i);
+
+				// the output is full, the remaining instances stay a contiguous range of the batch
+				if (outputVertex == UINT32_MAX)
+				{
+					remaining = instanceCount - i;
+					break;
+				}
+
+				if (i == 0)
+				{
+					heap->Bind(cmdBuffer, skinning->GetOutputBuffer(currentFrame), mIndexType);
+					vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, staticPipeline->GetPipelineLayout(), 0, 1, &descriptorSet, 0, NULL);
+					vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, staticPipeline->GetPipeline());
+				}
+
+				for (size_t c = 0; c < commands.size(); c++)
+				{
+					skinnedCommands[c].vertexOffset = commands[c].vertexOffset - vertexBase + (int32_t)outputVertex;
+					skinnedCommands[c].firstInstance = firstInstance + i;
+				}
+
+				mRenderer->GetCullingPass()->DrawBatch(cmdBuffer, mCullMin, mCullMax, firstInstance + i, 1, skinnedCommands.data(), (uint32_t)skinnedCommands.size());
+			}
+
+			if (remaining == 0)
+				return;
+
+			// the vertex shader skins the rest
+			uint32_t first = firstInstance + instanceCount - remaining;
+
+			for (VkDrawIndexedIndirectCommand& command : commands)
+			{
+				command.firstInstance = first;
+			}
+
+			heap->Bind(cmdBuffer, GeometryHeap::GetVertexPool(mVertexLayout), mIndexType);
+			vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSet, 0, NULL);
+			vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+			mRenderer->GetCullingPass()->DrawBatch(cmdBuffer, mCullMin, mCullMax, first, remaining, commands.data(), (uint32_t)commands.size());
+			return;
 		}
+
+		mRenderer->GetCullingPass()->DrawBatch(cmdBuffer, mCullMin, mCullMax, firstInstance, instanceCount, commands.data(), (uint32_t)commands.size());
 	}
 
 	void VKMesh::LoadFromFile(std::string filepath, float scale)
 	{
-		tinygltf::Model model;
-		tinygltf::TinyGLTF context;
-		std::string error, warning;
+		// loading another file replaces the current model
+		ReleaseLoader();
+		ReleaseModel();
+
+		mFilepath = filepath;
 
-		bool fileLoaded = context.LoadASCIIFromFile(&model, &error, &warning, filepath);
+		// until the model is uploaded it's represented by an unit box around the origin
+		mDimension.min = glm::vec3(-0.5f);
+		mDimension.max = glm::vec3(0.5f);
+		mDimension.aabb = glm::translate(glm::mat4(1.0f), mDimension.min);
 
-		if (!fileLoaded)
+		mLoader = CreateUnique<LoaderInfo>();
+		mLoader->filepath = filepath;
+		mLoader->scale = scale;
+
+		// the loader outlives the task, it's only released after waiting for it
+		LoaderInfo* loaderInfo = mLoader.get();
+		Shared<Device> device = mRenderer->GetDevice();
+		mLoader->task = ThreadPool::GetInstance().Enqueue([device, loaderInfo]() { DecodeFile(device, *loaderInfo); });
+	}
+
+	void VKMesh::DecodeFile(Shared<Device> device, LoaderInfo& loaderInfo)
+	{
+		// cooked files are uploaded as they are, gltf must be parsed and decoded first
+		bool decoded = GetExtension(loaderInfo.filepath) == ".cmesh" ? MapCookedFile(loaderInfo) : ParseFile(loaderInfo);
+
+		if (!decoded)
 		{
-			COSMOS_LOG(Logger::Error, "Failed to load mesh %s, error: %s", filepath.c_str(), error.c_str());
+			loaderInfo.state = LoaderInfo::State::Failed;
+			return;
+		}
+
+		if (loaderInfo.cancelled)
 			return;
+
+		CreateRendererResources(device, loaderInfo);
+
+		loaderInfo.state = LoaderInfo::State::Decoded;
+	}
+
+	bool VKMesh::ParseFile(LoaderInfo& loaderInfo)
+	{
+		tinygltf::TinyGLTF context;
+		tinygltf::Model& model = loaderInfo.model;
+		bool fileLoaded = false;
+
+		// binary gltf is told apart by it's extension
+		if (GetExtension(loaderInfo.filepath) == ".glb")
+		{
+			fileLoaded = context.LoadBinaryFromFile(&model, &loaderInfo.error, &loaderInfo.warning, loaderInfo.filepath);
 		}
 
-		if (warning.size() > 0)
+		else
+		{
+			fileLoaded = context.LoadASCIIFromFile(&model, &loaderInfo.error, &loaderInfo.warning, loaderInfo.filepath);
+		}
+
+		if (!fileLoaded)
+			return false;
+
+		if (model.scenes.empty())
 		{
-			COSMOS_LOG(Logger::Error, "Loading mesh %s with warning(s): %s", filepath.c_str(), warning.c_str());
+			loaderInfo.error = "file has no scene";
+			return false;
 		}
 
+		if (loaderInfo.cancelled)
+			return false;
+
+		const tinygltf::Scene& scene = model.scenes[model.defaultScene > -1 ? model.defaultScene : 0];
+
+		// get vertex and index buffer sizes up-front, every primitive gets it's own range of them
 		size_t vertexCount = 0;
 		size_t indexCount = 0;
+		size_t primitiveCount = 0;
 
-		LoadMaterials(model);
+		for (const tinygltf::Mesh& mesh : model.meshes)
+		{
+			primitiveCount += mesh.primitives.size();
+		}
 
-		const tinygltf::Scene& scene = model.scenes[model.defaultScene > -1 ? model.defaultScene : 0];
+		loaderInfo.primitives.reserve(primitiveCount);
 
-		// get vertex and index buffer sizes up-front
 		for (size_t i = 0; i < scene.nodes.size(); i++)
 		{
-			GetNodeProperties(model.nodes[scene.nodes[i]], model, vertexCount, indexCount);
+			GetNodeProperties(model.nodes[scene.nodes[i]], model, loaderInfo.primitives, vertexCount, indexCount);
 		}
 
-		LoaderInfo loaderInfo = {};
-		loaderInfo.vertexBuffer = new Vertex[vertexCount];
-		loaderInfo.indexBuffer = new uint32_t[indexCount];
+		if (vertexCount == 0)
+		{
+			loaderInfo.error = "file has no vertices";
+			return false;
+		}
 
-		mVertices.resize(vertexCount);
+		loaderInfo.vertices.resize(vertexCount);
+		loaderInfo.indices.resize(indexCount);
 
-		COSMOS_LOG(Logger::Todo, "Handle scene with no default scene");
+		// the ranges don't overlap, primitives are decoded in parallel
+		ThreadPool::GetInstance().ParallelFor
+		(
+			(uint32_t)loaderInfo.primitives.size(),
+			[&loaderInfo](uint32_t index) { DecodePrimitive(loaderInfo.model, loaderInfo.primitives[index], loaderInfo); }
+		);
 
-		for (size_t i = 0; i < scene.nodes.size(); i++)
+		if (loaderInfo.cancelled)
+			return false;
+
+		ThreadPool::GetInstance().ParallelFor
+		(
+			(uint32_t)loaderInfo.primitives.size(),
+			[&loaderInfo](uint32_t index) { OptimizePrimitive(loaderInfo.primitives[index], loaderInfo); }
+		);
+
+		// welding shrank the vertex ranges, they're moved down so the vertex stream has no gaps
+		uint32_t vertexCursor = 0;
+
+		for (PrimitiveInfo& info : loaderInfo.primitives)
 		{
-			const tinygltf::Node node = model.nodes[scene.nodes[i]];
-			LoadNode(nullptr, node, scene.nodes[i], model, loaderInfo, scale);
+			// indices are relative to the range, they're not affected
+			if (info.vertexStart != vertexCursor)
+			{
+				std::move(loaderInfo.vertices.begin() + info.vertexStart, loaderInfo.vertices.begin() + info.vertexStart + info.vertexCount, loaderInfo.vertices.begin() + vertexCursor);
+				info.vertexStart = vertexCursor;
+			}
+
+			vertexCursor += info.vertexCount;
+			loaderInfo.statistics.Add(info.statistics);
 		}
 
-		if (model.animations.size() > 0)
+		loaderInfo.vertices.resize(vertexCursor);
+
+		// skinned vertices keep a byte per joint, bigger skeletons would have to be split per primitive
+		const bool skinned = !loaderInfo.model.skins.empty();
+
+		if (skinned && !FitsSkinnedLayout(loaderInfo.vertices))
 		{
-			LoadAnimations(model);
+			loaderInfo.error = "skins with more than 256 joints are not supported";
+			return false;
 		}
 
-		LoadSkins(model);
+		// the layout is chosen for the whole mesh, the full vertex is uploaded as it is
+		loaderInfo.layout = ChooseVertexLayout(loaderInfo.vertices, skinned);
+		loaderInfo.vertexData = loaderInfo.vertices.data();
+		loaderInfo.vertexBytes = loaderInfo.vertices.size() * sizeof(Vertex);
 
-		for (auto node : mLinearNodes)
+		if (loaderInfo.layout != VertexLayout::Full)
 		{
-			// assign skins
-			if (node->skinIndex > -1)
-			{
-				node->skin = mSkins[node->skinIndex];
-			}
+			const uint32_t stride = GetVertexStride(loaderInfo.layout);
+			loaderInfo.packedVertices.resize(loaderInfo.vertices.size() * stride);
 
-			// initial pose
-			if (node->mesh)
-			{
-				node->OnUpdate();
-			}
+			ThreadPool::GetInstance().ParallelFor
+			(
+				(uint32_t)loaderInfo.primitives.size(),
+				[&loaderInfo, stride](uint32_t index)
+				{
+					const PrimitiveInfo& info = loaderInfo.primitives[index];
+					PackVertices(loaderInfo.layout, &loaderInfo.vertices[info.vertexStart], info.vertexCount, &loaderInfo.packedVertices[(size_t)info.vertexStart * stride]);
+				}
+			);
+
+			loaderInfo.vertexData = loaderInfo.packedVertices.data();
+			loaderInfo.vertexBytes = loaderInfo.packedVertices.size();
 		}
 
-		CreateRendererResources(vertexCount, indexCount, loaderInfo);
-		SetupDescriptors();
-		UpdateDescriptors();
+		loaderInfo.indexData = loaderInfo.indices.data();
+		loaderInfo.indexBytes = loaderInfo.indices.size() * sizeof(uint32_t);
 
-		CalculateMeshDimension();
+		// primitives are drawn with their vertex start as base vertex, so their indices are usually small
+		// it's the indices themselves that must fit, primitives left unoptimized may index past their own range
+		const uint32_t largestIndex = loaderInfo.indices.empty() ? 0 : *std::max_element(loaderInfo.indices.begin(), loaderInfo.indices.end());
 
-		mFilepath = filepath;
-		mLoaded = true;
+		if (largestIndex <= UINT16_MAX)
+		{
+			loaderInfo.indexType = VK_INDEX_TYPE_UINT16;
+			loaderInfo.shortIndices.resize(loaderInfo.indices.size());
+			std::transform(loaderInfo.indices.begin(), loaderInfo.indices.end(), loaderInfo.shortIndices.begin(), [](uint32_t index) { return (uint16_t)index; });
 
-		delete[] loaderInfo.vertexBuffer;
-		delete[] loaderInfo.indexBuffer;
-	}
+			loaderInfo.indexData = loaderInfo.shortIndices.data();
+			loaderInfo.indexBytes = loaderInfo.shortIndices.size() * sizeof(uint16_t);
+		}
 
-	Mesh::Dimension VKMesh::GetDimension() const
-	{
-		return mDimension;
+		return true;
 	}
 
-	void VKMesh::SetColormapTexture(std::string filepath)
+	bool VKMesh::MapCookedFile(LoaderInfo& loaderInfo)
 	{
-		vkDeviceWaitIdle(mRenderer->GetDevice()->GetLogicalDevice());
-		
-		if (mMaterial.colormapTex)
+		loaderInfo.file = CreateUnique<MappedFile>();
+
+		if (!loaderInfo.file->Open(loaderInfo.filepath))
 		{
-			mMaterial.colormapTex.reset();
-			mMaterial.colormapPath = filepath;
-			mMaterial.colormapTex = Texture2D::Create(mRenderer, mMaterial.colormapPath.c_str(), true);
+			loaderInfo.error = "file could not be mapped";
+			return false;
 		}
-		
-		UpdateDescriptors();
+
+		const uint8_t* data = loaderInfo.file->GetData();
+		const size_t size = loaderInfo.file->GetSize();
+		const MeshFormat::Header* header = (const MeshFormat::Header*)data;
+
+		if (size < sizeof(MeshFormat::Header) || header->magic != MeshFormat::Magic)
+		{
+			loaderInfo.error = "file is not a cooked mesh";
+			return false;
+		}
+
+		// the streams are uploaded as they are, they must match the runtime layout
+		const bool knownLayout = header->vertexLayout <= (uint32_t)VertexLayout::Skinned;
+
+		const bool knownIndex = header->indexSize == sizeof(uint16_t) || header->indexSize == sizeof(uint32_t);
+
+		if (header->version != MeshFormat::Version || !knownLayout || !knownIndex || header->vertexSize != GetVertexStride((VertexLayout)header->vertexLayout))
+		{
+			loaderInfo.error = "file was cooked by another version of the engine, it must be cooked again";
+			return false;
+		}
+
+		const bool inside = header->nodesOffset + (uint64_t)header->nodeCount * sizeof(MeshFormat::Node) <= size
+			&& header->primitivesOffset + (uint64_t)header->primitiveCount * sizeof(MeshFormat::Primitive) <= size
+			&& header->verticesOffset + (uint64_t)header->vertexCount * header->vertexSize <= size
+			&& header->indicesOffset + (uint64_t)header->indexCount * header->indexSize <= size;
+
+		if (!inside || header->vertexCount == 0)
+		{
+			loaderInfo.error = "file is truncated or has no vertices";
+			return false;
+		}
+
+		loaderInfo.layout = (VertexLayout)header->vertexLayout;
+		loaderInfo.vertexData = data + header->verticesOffset;
+		loaderInfo.vertexBytes = (size_t)header->vertexCount * header->vertexSize;
+		loaderInfo.indexType = header->indexSize == sizeof(uint16_t) ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+		loaderInfo.indexData = data + header->indicesOffset;
+		loaderInfo.indexBytes = (size_t)header->indexCount * header->indexSize;
+
+		return true;
 	}
 
-	Shared<Texture2D> VKMesh::GetColormapTexture()
+	bool VKMesh::Cook(std::string source, std::string destination)
 	{
-		return mMaterial.colormapTex;
+		LoaderInfo loaderInfo = {};
+		loaderInfo.filepath = source;
+
+		if (!ParseFile(loaderInfo))
+		{
+			COSMOS_LOG(Logger::Error, "Failed to cook mesh %s, error: %s", source.c_str(), loaderInfo.error.c_str());
+			return false;
+		}
+
+		const tinygltf::Model& model = loaderInfo.model;
+
+		if (!model.animations.empty() || !model.skins.empty())
+		{
+			COSMOS_LOG(Logger::Warn, "Cooked meshes are static, animations and skins of %s are not cooked", source.c_str());
+		}
+
+		// node table is listed parents first, primitives keep the order they were decoded in
+		std::vector<MeshFormat::Node> nodes = {};
+		std::vector<MeshFormat::Primitive> primitives = {};
+		const tinygltf::Scene& scene = model.scenes[model.defaultScene > -1 ? model.defaultScene : 0];
+		nodes.reserve(model.nodes.size());
+		primitives.reserve(loaderInfo.primitives.size());
+
+		for (size_t i = 0; i < scene.nodes.size(); i++)
+		{
+			CookNode(model, scene.nodes[i], -1, loaderInfo, nodes, primitives);
+		}
+
+		// bounds with the node transforms applied, parents come first so their matrices are ready
+		std::vector<glm::mat4> matrices(nodes.size());
+		glm::vec3 boundsMin = glm::vec3(FLT_MAX);
+		glm::vec3 boundsMax = glm::vec3(-FLT_MAX);
+
+		for (size_t i = 0; i < nodes.size(); i++)
+		{
+			const MeshFormat::Node& node = nodes[i];
+			glm::mat4 local = glm::translate(glm::mat4(1.0f), glm::make_vec3(node.translation)) * glm::mat4(glm::make_quat(node.rotation)) * glm::scale(glm::mat4(1.0f), glm::make_vec3(node.scale)) * glm::make_mat4x4(node.matrix);
+			matrices[i] = node.parent > -1 ? matrices[node.parent] * local : local;
+
+			for (uint32_t p = node.firstPrimitive; p < node.firstPrimitive + node.primitiveCount; p++)
+			{
+				Physics::BoundingBox bb(glm::make_vec3(primitives[p].boundsMin), glm::make_vec3(primitives[p].boundsMax));
+				Physics::BoundingBox aabb = bb.GetAABB(matrices[i]);
+				boundsMin = glm::min(boundsMin, aabb.GetMin());
+				boundsMax = glm::max(boundsMax, aabb.GetMax());
+			}
+		}
+
+		MeshFormat::Header header = {};
+		header.vertexSize = GetVertexStride(loaderInfo.layout);
+		header.vertexLayout = (uint32_t)loaderInfo.layout;
+		header.indexSize = loaderInfo.indexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
+		header.nodeCount = (uint32_t)nodes.size();
+		header.primitiveCount = (uint32_t)primitives.size();
+		header.vertexCount = (uint32_t)loaderInfo.vertices.size();
+		header.indexCount = (uint32_t)loaderInfo.indices.size();
+		header.nodesOffset = MeshFormat::AlignSection(sizeof(MeshFormat::Header));
+		header.primitivesOffset = MeshFormat::AlignSection(header.nodesOffset + nodes.size() * sizeof(MeshFormat::Node));
+		header.verticesOffset = MeshFormat::AlignSection(header.primitivesOffset + primitives.size() * sizeof(MeshFormat::Primitive));
+		header.indicesOffset = MeshFormat::AlignSection(header.verticesOffset + loaderInfo.vertexBytes);
+		memcpy(header.boundsMin, glm::value_ptr(boundsMin), sizeof(header.boundsMin));
+		memcpy(header.boundsMax, glm::value_ptr(boundsMax), sizeof(header.boundsMax));
+
+		std::ofstream file(destination, std::ios::binary | std::ios::trunc);
+
+		if (!file)
+		{
+			COSMOS_LOG(Logger::Error, "Failed to cook mesh %s, could not create %s", source.c_str(), destination.c_str());
+			return false;
+		}
+
+		// sections are zero padded up to their offset
+		auto writeSection = [&file](uint64_t offset, const void* data, size_t size)
+		{
+			static const char padding[MeshFormat::SectionAlignment] = {};
+			file.write(padding, (std::streamsize)(offset - (uint64_t)file.tellp()));
+			file.write((const char*)data, (std::streamsize)size);
+		};
+
+		writeSection(0, &header, sizeof(header));
+		writeSection(header.nodesOffset, nodes.data(), nodes.size() * sizeof(MeshFormat::Node));
+		writeSection(header.primitivesOffset, primitives.data(), primitives.size() * sizeof(MeshFormat::Primitive));
+		writeSection(header.verticesOffset, loaderInfo.vertexData, loaderInfo.vertexBytes);
+		writeSection(header.indicesOffset, loaderInfo.indexData, loaderInfo.indexBytes);
+
+		if (!file)
+		{
+			COSMOS_LOG(Logger::Error, "Failed to cook mesh %s, could not write %s", source.c_str(), destination.c_str());
+			return false;
+		}
+
+		const MeshOptimizer::Statistics& statistics = loaderInfo.statistics;
+		COSMOS_LOG(Logger::Info, "Cooked mesh %s into %s (%d vertices of %d bytes, %d indices)", source.c_str(), destination.c_str(), header.vertexCount, header.vertexSize, header.indexCount);
+		COSMOS_LOG(Logger::Info, "Optimized mesh %s: %d -> %d vertices, ACMR %.3f -> %.3f", source.c_str(), statistics.vertexCountBefore, statistics.vertexCountAfter, statistics.GetACMRBefore(), statistics.GetACMRAfter());
+		return true;
 	}
 
-	void VKMesh::UpdateAnimation(uint32_t index, float time)
+	void VKMesh::CookNode(const tinygltf::Model& model, int32_t nodeIndex, int32_t parent, LoaderInfo& loaderInfo, std::vector<MeshFormat::Node>& nodes, std::vector<MeshFormat::Primitive>& primitives)
 	{
-		if (mAnimations.empty())
+		const tinygltf::Node& node = model.nodes[nodeIndex];
+
+		MeshFormat::Node cooked = {};
+		cooked.parent = parent;
+		cooked.index = (uint32_t)nodeIndex;
+		cooked.mesh = node.mesh;
+		strncpy(cooked.name, node.name.c_str(), MeshFormat::NameMaxChars - 1);
+
+		if (node.translation.size() == 3) for (size_t i = 0; i < 3; i++) cooked.translation[i] = (float)node.translation[i];
+		if (node.rotation.size() == 4) for (size_t i = 0; i < 4; i++) cooked.rotation[i] = (float)node.rotation[i];
+		if (node.scale.size() == 3) for (size_t i = 0; i < 3; i++) cooked.scale[i] = (float)node.scale[i];
+
+		if (node.matrix.size() == 16) for (size_t i = 0; i < 16; i++) cooked.matrix[i] = (float)node.matrix[i];
+		else memcpy(cooked.matrix, glm::value_ptr(glm::mat4(1.0f)), sizeof(cooked.matrix));
+
+		const int32_t self = (int32_t)nodes.size();
+		nodes.push_back(cooked);
+
+		for (size_t i = 0; i < node.children.size(); i++)
 		{
-			COSMOS_LOG(Logger::Error, "Mesh does not contain animation");
-			return;
+			CookNode(model, node.children[i], self, loaderInfo, nodes, primitives);
 		}
 
-		if (index > (uint32_t)(mAnimations.size()) - 1)
+		// primitives were decoded children first, the cursor follows the same order
+		if (node.mesh > -1)
 		{
-			COSMOS_LOG(Logger::Error, "Mesh does not contain animation with index %d", index);
-			return;
+			nodes[self].firstPrimitive = (uint32_t)primitives.size();
+			nodes[self].primitiveCount = (uint32_t)model.meshes[node.mesh].primitives.size();
+
+			for (uint32_t i = 0; i < nodes[self].primitiveCount; i++)
+			{
+				const PrimitiveInfo& info = loaderInfo.primitives[loaderInfo.primitivePos++];
+
+				MeshFormat::Primitive primitive = {};
+				primitive.firstIndex = info.indexStart;
+				primitive.indexCount = info.indexCount;
+				primitive.vertexStart = info.vertexStart;
+				primitive.vertexCount = info.vertexCount;
+				memcpy(primitive.boundsMin, glm::value_ptr(info.min), sizeof(primitive.boundsMin));
+				memcpy(primitive.boundsMax, glm::value_ptr(info.max), sizeof(primitive.boundsMax));
+				primitives.push_back(primitive);
+			}
 		}
+	}
 
-		GLTF::Animation& animation = mAnimations[index];
+	void VKMesh::DecodePrimitive(const tinygltf::Model& model, PrimitiveInfo& info, LoaderInfo& loaderInfo)
+	{
+		if (info.error != nullptr)
+			return;
 
-		bool updated = false;
+		const tinygltf::Primitive& primitive = *info.primitive;
+		bool hasSkin = false;
 
-		for (auto& channel : animation.channels)
+		// vertices
 		{
-			GLTF::Animation::Sampler& sampler = animation.samplers[channel.samplerIndex];
+			const float* bufferPos = nullptr;
+			const float* bufferNormals = nullptr;
+			const float* bufferTexCoordSet0 = nullptr;
+			const float* bufferColorSet0 = nullptr;
+			const void* bufferJoints = nullptr;
+			const float* bufferWeights = nullptr;
+
+			int posByteStride;
+			int normByteStride;
+			int uv0ByteStride;
+			int color0ByteStride;
+			int jointByteStride;
+			int weightByteStride;
+
+			int jointComponentType;
+
+			const tinygltf::Accessor& posAccessor = model.accessors[primitive.attributes.find("POSITION")->second];
+			const tinygltf::BufferView& posView = model.bufferViews[posAccessor.bufferView];
+			bufferPos = reinterpret_cast<const float*>(&(model.buffers[posView.buffer].data[posAccessor.byteOffset + posView.byteOffset]));
+			info.min = glm::vec3(posAccessor.minValues[0], posAccessor.minValues[1], posAccessor.minValues[2]);
+			info.max = glm::vec3(posAccessor.maxValues[0], posAccessor.maxValues[1], posAccessor.maxValues[2]);
+			posByteStride = posAccessor.ByteStride(posView) ? (posAccessor.ByteStride(posView) / sizeof(float)) : tinygltf::GetNumComponentsInType(TINYGLTF_TYPE_VEC3);
+
+			if (primitive.attributes.find("NORMAL") != primitive.attributes.end())
+			{
+				const tinygltf::Accessor& normAccessor = model.accessors[primitive.attributes.find("NORMAL")->second];
+				const tinygltf::BufferView& normView = model.bufferViews[normAccessor.bufferView];
+				bufferNormals = reinterpret_cast<const float*>(&(model.buffers[normView.buffer].data[normAccessor.byteOffset + normView.byteOffset]));
+				normByteStride = normAccessor.ByteStride(normView) ? (normAccessor.ByteStride(normView) / sizeof(float)) : tinygltf::GetNumComponentsInType(TINYGLTF_TYPE_VEC3);
+			}
 
-			if (sampler.inputs.size() > sampler.outputsVec4.size())
+			// uv0
+			if (primitive.attributes.find("TEXCOORD_0") != primitive.attributes.end())
 			{
-				continue;
+				const tinygltf::Accessor& uvAccessor = model.accessors[primitive.attributes.find("TEXCOORD_0")->second];
+				const tinygltf::BufferView& uvView = model.bufferViews[uvAccessor.bufferView];
+				bufferTexCoordSet0 = reinterpret_cast<const float*>(&(model.buffers[uvView.buffer].data[uvAccessor.byteOffset + uvView.byteOffset]));
+				uv0ByteStride = uvAccessor.ByteStride(uvView) ? (uvAccessor.ByteStride(uvView) / sizeof(float)) : tinygltf::GetNumComponentsInType(TINYGLTF_TYPE_VEC2);
 			}
 
-			for (size_t i = 0; i < sampler.inputs.size() - 1; i++)
+			// vertex colors
+			if (primitive.attributes.find("COLOR_0") != primitive.attributes.end())
 			{
-				if ((time >= sampler.inputs[i]) && (time <= sampler.inputs[i + 1]))
-				{
-					float u = std::max(0.0f, time - sampler.inputs[i]) / (sampler.inputs[i + 1] - sampler.inputs[i]);
+				const tinygltf::Accessor& accessor = model.accessors[primitive.attributes.find("COLOR_0")->second];
+				const tinygltf::BufferView& view = model.bufferViews[accessor.bufferView];
+				bufferColorSet0 = reinterpret_cast<const float*>(&(model.buffers[view.buffer].data[accessor.byteOffset + view.byteOffset]));
+				color0ByteStride = accessor.ByteStride(view) ? (accessor.ByteStride(view) / sizeof(float)) : tinygltf::GetNumComponentsInType(TINYGLTF_TYPE_VEC3);
+			}
 
-					if (u <= 1.0f)
-					{
-						switch (channel.path)
-						{
-							case GLTF::Animation::Channel::PathType::TRANSLATION:
-							{
-								sampler.Translate(i, time, channel.node);
-								break;
-							}
-								
-							case GLTF::Animation::Channel::PathType::SCALE:
-							{
-								sampler.Scale(i, time, channel.node);
-								break;
-							}
-								
-							case GLTF::Animation::Channel::PathType::ROTATION:
-							{
-								sampler.Rotate(i, time, channel.node);
-								break;
-							}
+			// skinning joints
+			if (primitive.attributes.find("JOINTS_0") != primitive.attributes.end())
+			{
+				const tinygltf::Accessor& jointAccessor = model.accessors[primitive.attributes.find("JOINTS_0")->second];
+				const tinygltf::BufferView& jointView = model.bufferViews[jointAccessor.bufferView];
+				bufferJoints = &(model.buffers[jointView.buffer].data[jointAccessor.byteOffset + jointView.byteOffset]);
+				jointComponentType = jointAccessor.componentType;
+				jointByteStride = jointAccessor.ByteStride(jointView) ? (jointAccessor.ByteStride(jointView) / tinygltf::GetComponentSizeInBytes(jointComponentType)) : tinygltf::GetNumComponentsInType(TINYGLTF_TYPE_VEC4);
+			}
+
+			// skinning weights
+			if (primitive.attributes.find("WEIGHTS_0") != primitive.attributes.end())
+			{
+				const tinygltf::Accessor& weightAccessor = model.accessors[primitive.attributes.find("WEIGHTS_0")->second];
+				const tinygltf::BufferView& weightView = model.bufferViews[weightAccessor.bufferView];
+				bufferWeights = reinterpret_cast<const float*>(&(model.buffers[weightView.buffer].data[weightAccessor.byteOffset + weightView.byteOffset]));
+				weightByteStride = weightAccessor.ByteStride(weightView) ? (weightAccessor.ByteStride(weightView) / sizeof(float)) : tinygltf::GetNumComponentsInType(TINYGLTF_TYPE_VEC4);
+			}
+
+			hasSkin = (bufferJoints && bufferWeights);
+
+			for (size_t v = 0; v < info.vertexCount; v++)
+			{
+				Vertex& vert = loaderInfo.vertices[info.vertexStart + v];
+				vert.position = glm::vec4(glm::make_vec3(&bufferPos[v * posByteStride]), 1.0f);
+				vert.normal = bufferNormals ? glm::normalize(glm::make_vec3(&bufferNormals[v * normByteStride])) : glm::vec3(0.0f);
+				vert.uv = bufferTexCoordSet0 ? glm::make_vec2(&bufferTexCoordSet0[v * uv0ByteStride]) : glm::vec3(0.0f);
+				vert.color = bufferColorSet0 ? glm::make_vec4(&bufferColorSet0[v * color0ByteStride]) : glm::vec4(1.0f);
+
+				if (hasSkin)
+				{
+					switch (jointComponentType)
+					{
+						case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+						{
+							const uint16_t* buf = static_cast<const uint16_t*>(bufferJoints);
+							vert.joint = glm::uvec4(glm::make_vec4(&buf[v * jointByteStride]));
+							break;
+						}
+
+						case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+						{
+							const uint8_t* buf = static_cast<const uint8_t*>(bufferJoints);
+							vert.joint = glm::vec4(glm::make_vec4(&buf[v * jointByteStride]));
+							break;
+						}
+
+						default:
+						{
+							info.error = "Joint component type is not supported";
+							break;
 						}
-						updated = true;
 					}
 				}
+
+				else
+				{
+					vert.joint = glm::vec4(0.0f);
+				}
+
+				vert.weight = hasSkin ? glm::make_vec4(&bufferWeights[v * weightByteStride]) : glm::vec4(0.0f);
+
+				// fix for all zero weights
+				if (glm::length(vert.weight) == 0.0f)
+				{
+					vert.weight = glm::vec4(1.0f, 0.0f, 0.0f, 0.0f);
+				}
+			}
+		}
+
+		// indices, relative to the primitive's vertex range
+		if (info.indexCount > 0)
+		{
+			const tinygltf::Accessor& accessor = model.accessors[primitive.indices];
+			const tinygltf::BufferView& bufferView = model.bufferViews[accessor.bufferView];
+			const tinygltf::Buffer& buffer = model.buffers[bufferView.buffer];
+
+			const void* dataPtr = &(buffer.data[accessor.byteOffset + bufferView.byteOffset]);
+			uint32_t* indices = &loaderInfo.indices[info.indexStart];
+
+			switch (accessor.componentType)
+			{
+				case TINYGLTF_PARAMETER_TYPE_UNSIGNED_INT:
+				{
+					const uint32_t* buf = static_cast<const uint32_t*>(dataPtr);
+					for (size_t index = 0; index < accessor.count; index++)
+					{
+						indices[index] = buf[index];
+					}
+
+					break;
+				}
+
+				case TINYGLTF_PARAMETER_TYPE_UNSIGNED_SHORT:
+				{
+					const uint16_t* buf = static_cast<const uint16_t*>(dataPtr);
+					for (size_t index = 0; index < accessor.count; index++)
+					{
+						indices[index] = buf[index];
+					}
+
+					break;
+				}
+
+				case TINYGLTF_PARAMETER_TYPE_UNSIGNED_BYTE:
+				{
+					const uint8_t* buf = static_cast<const uint8_t*>(dataPtr);
+					for (size_t index = 0; index < accessor.count; index++)
+					{
+						indices[index] = buf[index];
+					}
+
+					break;
+				}
+
+				default:
+				{
+					// the primitive is not drawn
+					info.error = "Index component type is not supported";
+					info.indexCount = 0;
+					break;
+				}
+			}
+		}
+	}
+
+	void VKMesh::OptimizePrimitive(PrimitiveInfo& info, LoaderInfo& loaderInfo)
+	{
+		// only indexed triangle lists can be reordered
+		const int mode = info.primitive != nullptr ? info.primitive->mode : -1;
+
+		if (info.error != nullptr || info.indexCount == 0 || info.indexCount % 3 != 0 || (mode != -1 && mode != TINYGLTF_MODE_TRIANGLES))
+			return;
+
+		uint32_t* indices = &loaderInfo.indices[info.indexStart];
+
+		// the file references vertices outside the primitive, it's left as it is
+		for (uint32_t i = 0; i < info.indexCount; i++)
+		{
+			if (indices[i] >= info.vertexCount)
+				return;
+		}
+
+		info.statistics = MeshOptimizer::Optimize(&loaderInfo.vertices[info.vertexStart], info.vertexCount, indices, info.indexCount);
+	}
+
+	void VKMesh::FinishDecoding()
+	{
+		LoaderInfo& loaderInfo = *mLoader;
+		tinygltf::Model& model = loaderInfo.model;
+
+		if (loaderInfo.warning.size() > 0)
+		{
+			COSMOS_LOG(Logger::Error, "Loading mesh %s with warning(s): %s", loaderInfo.filepath.c_str(), loaderInfo.warning.c_str());
+		}
+
+		for (const PrimitiveInfo& info : loaderInfo.primitives)
+		{
+			if (info.error != nullptr)
+			{
+				COSMOS_LOG(Logger::Error, "Loading mesh %s: %s", loaderInfo.filepath.c_str(), info.error);
+			}
+		}
+
+		const MeshOptimizer::Statistics& statistics = loaderInfo.statistics;
+
+		if (statistics.triangleCount > 0)
+		{
+			COSMOS_LOG(Logger::Trace, "Optimized mesh %s: %d -> %d vertices, ACMR %.3f -> %.3f", loaderInfo.filepath.c_str(), statistics.vertexCountBefore, statistics.vertexCountAfter, statistics.GetACMRBefore(), statistics.GetACMRAfter());
+		}
+
+		LoadMaterials(model);
+
+		// every node, mesh, primitive and skin is created on the asset's arena from here on
+		CreateStorage(loaderInfo.file ? nullptr : &model, loaderInfo.file ? (const MeshFormat::Header*)loaderInfo.file->GetData() : nullptr);
+
+		if (loaderInfo.file)
+		{
+			LoadCookedNodes();
+		}
+
+		else
+		{
+			const tinygltf::Scene& scene = model.scenes[model.defaultScene > -1 ? model.defaultScene : 0];
+
+			for (size_t i = 0; i < scene.nodes.size(); i++)
+			{
+				const tinygltf::Node& node = model.nodes[scene.nodes[i]];
+				LoadNode(nullptr, node, scene.nodes[i], model, loaderInfo, loaderInfo.scale);
+			}
+
+			if (model.animations.size() > 0)
+			{
+				LoadAnimations(model);
+			}
+
+			LoadSkins(model);
+		}
+
+		// the nodes are listed depth-first from now on, the hierarchy is posed in a single pass
+		mLinearNodes.reserve(mNodeStorage.count);
+		mHierarchy.Build(mNodes, mLinearNodes);
+		mHierarchy.UpdateGlobals(mHierarchy.rest, 0, (uint32_t)mLinearNodes.size());
+
+		for (auto node : mLinearNodes)
+		{
+			// assign skins
+			if (node->skinIndex > -1 && node->skinIndex < (int32_t)mSkins.count)
+			{
+				node->skin = &mSkins[node->skinIndex];
+			}
+
+			// the vertices are skinned by a single palette, the first skinned mesh's one
+			if (node->mesh && node->skin && mPaletteSkin == nullptr)
+			{
+				mPaletteSkin = node->skin;
 			}
 		}
 
-		if (updated)
+		for (GLTF::Animation& animation : mAnimations)
+		{
+			CollectAnimatedNodes(animation);
+		}
+
+		SubmitUpload();
+
+		loaderInfo.state = LoaderInfo::State::Uploading;
+	}
+
+	void VKMesh::FinishUploading()
+	{
+		if (vkGetFenceStatus(mRenderer->GetDevice()->GetLogicalDevice(), mLoader->fence) != VK_SUCCESS)
+			return;
+
+		mVertices = std::move(mLoader->vertices);
+		mMappedFile = std::move(mLoader->file);
+		mVertexLayout = mLoader->layout;
+		mIndexType = mLoader->indexType;
+		ReleaseLoader();
+
+		// animations baked next to the mesh are loaded with it, before the descriptor sets are written
+		std::filesystem::path bakedPath = std::filesystem::path(mFilepath).replace_extension(".cvat");
+
+		if (mPaletteSkin != nullptr && std::filesystem::exists(bakedPath))
+		{
+			if (mVertexLayout == VertexLayout::Skinned)
+			{
+				LoadBakedAnimations(bakedPath.string());
+			}
+
+			else
+			{
+				COSMOS_LOG(Logger::Error, "Ignoring baked animation %s, mesh %s doesn't use the skinned vertex layout", bakedPath.string().c_str(), mFilepath.c_str());
+			}
+		}
+
+		SetupDescriptors(mDescriptorPool, mDescriptorSets);
+		UpdateDescriptors(mDescriptorSets, mMaterial.colormapTex);
+		mInstanceVersions.assign(mDescriptorSets.size(), 0);
+
+		CalculateMeshDimension();
+		CalculateSkinnedDimension();
+
+		mLoaded = true;
+
+		// the gpu has it's own copy, the cpu one is only kept if asked to
+		ReleaseVertices();
+	}
+
+	void VKMesh::ReleaseLoader()
+	{
+		if (mLoader == nullptr)
+			return;
+
+		VkDevice device = mRenderer->GetDevice()->GetLogicalDevice();
+		VmaAllocator allocator = mRenderer->GetDevice()->GetAllocator();
+
+		// the worker may still be decoding
+		mLoader->cancelled = true;
+
+		if (mLoader->task.valid())
+		{
+			mLoader->task.wait();
+		}
+
+		if (mLoader->fence != VK_NULL_HANDLE)
+		{
+			vkWaitForFences(device, 1, &mLoader->fence, VK_TRUE, UINT64_MAX);
+			vkDestroyFence(device, mLoader->fence, nullptr);
+		}
+
+		if (mLoader->commandBuffer != VK_NULL_HANDLE)
+		{
+			auto& renderpass = mRenderer->GetRenderpassManager()->GetMainRenderpass()->GetSpecificationRef();
+			vkFreeCommandBuffers(device, renderpass.commandPool, 1, &mLoader->commandBuffer);
+		}
+
+		if (mLoader->vertexStaging != VK_NULL_HANDLE) vmaDestroyBuffer(allocator, mLoader->vertexStaging, mLoader->vertexStagingMemory);
+		if (mLoader->indexStaging != VK_NULL_HANDLE) vmaDestroyBuffer(allocator, mLoader->indexStaging, mLoader->indexStagingMemory);
+
+		mLoader.reset();
+	}
+
+	void VKMesh::ReleaseModel()
+	{
+		// a new mesh has nothing to release
+		if (mArena == nullptr && mVertexRange == GeometryHeap::InvalidHandle && mDescriptorPool == VK_NULL_HANDLE && mColormapOverrides.empty())
+			return;
+
+		mLoaded = false;
+
+		// the last frames may still draw the model, it's gpu resources are released once they're done instead of waiting for the device
+		VkDevice device = mRenderer->GetDevice()->GetLogicalDevice();
+		Shared<GeometryHeap> heap = mRenderer->GetGeometryHeap();
+		VkDescriptorPool pool = mDescriptorPool;
+		GeometryHeap::Handle vertexRange = mVertexRange;
+		GeometryHeap::Handle indexRange = mIndexRange;
+
+		mRenderer->DeferRelease([device, heap, pool, vertexRange, indexRange]()
+			{
+				if (pool != VK_NULL_HANDLE) vkDestroyDescriptorPool(device, pool, nullptr);
+				heap->Free(vertexRange);
+				heap->Free(indexRange);
+			});
+
+		mDescriptorPool = VK_NULL_HANDLE;
+		mDescriptorSets.clear();
+		mInstanceVersions.clear();
+
+		PruneColormapOverrides(true);
+
+		mVertexRange = GeometryHeap::InvalidHandle;
+		mIndexRange = GeometryHeap::InvalidHandle;
+		mVertexCount = 0;
+
+		// the textures defer their own release when their last reference goes
+		mMaterial.colormapTex.reset();
+		mAnimations.resize(0);
+		mBakedAnimation.reset();
+
+		// the storage is trivially destructible, the arena releases it at once
+		mNodes.resize(0);
+		mLinearNodes.resize(0);
+		mHierarchy.Clear();
+		mNodeStorage = {};
+		mMeshStorage = {};
+		mPrimitiveStorage = {};
+		mNodeLookup = {};
+		mSkins = {};
+		mPaletteSkin = nullptr;
+		mArena.reset();
+
+		mVertices.clear();
+		mMappedFile.reset();
+		mVertexLayout = VertexLayout::Full;
+		mIndexType = VK_INDEX_TYPE_UINT32;
+	}
+
+	void VKMesh::PageInVertices()
+	{
+		// only cooked meshes are paged in, mapping them again is cheap while gltf ones would be parsed again on the caller's thread
+		if (GetExtension(mFilepath) != ".cmesh")
+			return;
+
+		LoaderInfo loaderInfo = {};
+		loaderInfo.filepath = mFilepath;
+
+		if (!MapCookedFile(loaderInfo))
+		{
+			COSMOS_LOG(Logger::Error, "Failed to read the vertices of mesh %s again, error: %s", mFilepath.c_str(), loaderInfo.error.c_str());
+			return;
+		}
+
+		// the file may have been written since it was loaded, the library reloads it then
+		if (((const MeshFormat::Header*)loaderInfo.file->GetData())->vertexCount != mVertexCount)
+		{
+			COSMOS_LOG(Logger::Error, "Failed to read the vertices of mesh %s again, the file changed since it was loaded", mFilepath.c_str());
+			return;
+		}
+
+		mMappedFile = std::move(loaderInfo.file);
+	}
+
+	VertexView VKMesh::GetVertexView()
+	{
+		if (!mLoaded)
+			return {};
+
+		if (mResidency != Residency::Released && mVertices.empty() && mMappedFile == nullptr)
+		{
+			PageInVertices();
+		}
+
+		if (mMappedFile)
+		{
+			const MeshFormat::Header* header = (const MeshFormat::Header*)mMappedFile->GetData();
+			return { mMappedFile->GetData() + header->verticesOffset, header->vertexCount, mVertexLayout };
+		}
+
+		return { (const uint8_t*)mVertices.data(), mVertices.size(), VertexLayout::Full };
+	}
+
+	void VKMesh::SetResidency(Residency residency)
+	{
+		mResidency = residency;
+
+		if (mLoaded)
+		{
+			ReleaseVertices();
+		}
+	}
+
+	void VKMesh::ReleaseVertices()
+	{
+		if (mResidency == Residency::Resident)
+			return;
+
+		// gltf meshes can't be paged in without parsing them again, on-demand ones keep their copy
+		if (mResidency == Residency::OnDemand && GetExtension(mFilepath) != ".cmesh")
+			return;
+
+		// the vector's capacity is released as well
+		std::vector<Vertex>().swap(mVertices);
+		mMappedFile.reset();
+	}
+
+	Mesh::Dimension VKMesh::GetDimension() const
+	{
+		return mDimension;
+	}
+
+	Mesh::Dimension VKMesh::GetCullingDimension() const
+	{
+		if (glm::any(glm::greaterThan(mCullMin, mCullMax)))
+			return mDimension;
+
+		Dimension dimension = {};
+		dimension.min = mCullMin;
+		dimension.max = mCullMax;
+		dimension.aabb = glm::scale(glm::mat4(1.0f), mCullMax - mCullMin);
+		dimension.aabb[3][0] = mCullMin[0];
+		dimension.aabb[3][1] = mCullMin[1];
+		dimension.aabb[3][2] = mCullMin[2];
+
+		return dimension;
+	}
+
+	void VKMesh::SetColormapTexture(std::string filepath)
+	{
+		vkDeviceWaitIdle(mRenderer->GetDevice()->GetLogicalDevice());
+		
+		if (mMaterial.colormapTex)
+		{
+			mMaterial.colormapTex.reset();
+			mMaterial.colormapPath = filepath;
+			mMaterial.colormapTex = Texture2D::Create(mRenderer, mMaterial.colormapPath.c_str(), true);
+		}
+		
+		UpdateDescriptors(mDescriptorSets, mMaterial.colormapTex);
+	}
+
+	Shared<Texture2D> VKMesh::GetColormapTexture()
+	{
+		return mMaterial.colormapTex;
+	}
+
+	float VKMesh::GetAnimationDuration(uint32_t clip) const
+	{
+		if (clip >= (uint32_t)mAnimations.size())
+			return 0.0f;
+
+		return std::max(0.0f, mAnimations[clip].end - mAnimations[clip].start);
+	}
+
+	void VKMesh::Animate(uint32_t clip, float time, Pose& pose) const
+	{
+		if (clip >= (uint32_t)mAnimations.size())
+		{
+			COSMOS_LOG(Logger::Error, "Mesh does not contain animation with index %d", clip);
+			return;
+		}
+
+		const GLTF::Animation& animation = mAnimations[clip];
+
+		// a pose starts from the rest pose, nodes the clip doesn't animate keep it
+		// switching clips starts over, nodes only the previous clip animated would keep it's transforms otherwise
+		if (pose.globals.size() != mHierarchy.rest.globals.size() || pose.clip != clip || pose.cursors.size() != animation.channels.size())
+		{
+			pose = mHierarchy.rest;
+			pose.clip = clip;
+			pose.cursors.assign(animation.channels.size(), 0);
+		}
+
+		time += animation.start;
+
+		for (size_t c = 0; c < animation.channels.size(); c++)
+		{
+			const GLTF::Animation::Channel& channel = animation.channels[c];
+			const GLTF::Animation::Sampler& sampler = animation.samplers[channel.samplerIndex];
+
+			if (sampler.inputs.size() < 2 || sampler.inputs.size() > sampler.GetKeyCount())
+			{
+				continue;
+			}
+
+			// holds the first and last keyframes outside of the channel's range
+			float channelTime = std::clamp(time, sampler.inputs.front(), sampler.inputs.back());
+			size_t index = sampler.FindKeyframe(channelTime, pose.cursors[c]);
+
+			switch (channel.path)
+			{
+				case GLTF::Animation::Channel::PathType::TRANSLATION:
+				{
+					sampler.Translate(index, channelTime, pose.translations[channel.node->linearIndex]);
+					break;
+				}
+
+				case GLTF::Animation::Channel::PathType::SCALE:
+				{
+					sampler.Scale(index, channelTime, pose.scales[channel.node->linearIndex]);
+					break;
+				}
+
+				case GLTF::Animation::Channel::PathType::ROTATION:
+				{
+					sampler.Rotate(index, channelTime, pose.rotations[channel.node->linearIndex]);
+					break;
+				}
+			}
+		}
+
+		// every subtree is contiguous, it's globals are a forward pass over it's range
+		for (GLTF::Node* root : animation.roots)
+		{
+			mHierarchy.UpdateGlobals(pose, root->linearIndex, mHierarchy.subtreeEnds[root->linearIndex]);
+		}
+	}
+
+	void VKMesh::BlendPoses(const Pose& from, const Pose& to, float weight, Pose& result) const
+	{
+		const size_t count = mHierarchy.rest.globals.size();
+
+		if (from.globals.size() != count || to.globals.size() != count)
+			return;
+
+		// the cursors belong to the evaluated poses, only the transforms are blended
+		if (result.globals.size() != count)
+		{
+			result = mHierarchy.rest;
+		}
+
+		for (size_t i = 0; i < count; i++)
+		{
+			result.translations[i] = glm::mix(from.translations[i], to.translations[i], weight);
+			result.rotations[i] = glm::normalize(glm::slerp(from.rotations[i], to.rotations[i], weight));
+			result.scales[i] = glm::mix(from.scales[i], to.scales[i], weight);
+		}
+
+		mHierarchy.UpdateGlobals(result, 0, (uint32_t)count);
+	}
+
+	void VKMesh::WritePalette(const Pose& pose, glm::mat4* palette) const
+	{
+		if (mPaletteSkin == nullptr)
+			return;
+
+		// the joints are in model space, the entity's transform is applied by the vertex shader
+		const std::vector<glm::mat4>& globals = pose.globals.size() == mHierarchy.rest.globals.size() ? pose.globals : mHierarchy.rest.globals;
+
+		for (size_t i = 0; i < mPaletteSkin->joints.size(); i++)
+		{
+			const glm::mat4& joint = globals[mPaletteSkin->joints[i]->linearIndex];
+			palette[i] = i < mPaletteSkin->inverseBindMatrices.size() ? MultiplySIMD(joint, mPaletteSkin->inverseBindMatrices[i]) : joint;
+		}
+	}
+
+	bool VKMesh::BakeAnimations(std::string destination, float framerate) const
+	{
+		const uint32_t jointCount = GetJointCount();
+
+		if (!mLoaded || jointCount == 0 || mAnimations.empty())
+		{
+			COSMOS_LOG(Logger::Error, "Failed to bake animations of %s, the mesh must be loaded, skinned and animated", mFilepath.c_str());
+			return false;
+		}
+
+		// vertex colors or joints past a byte keep the full layout, the baked pipelines can't draw it
+		if (mVertexLayout != VertexLayout::Skinned)
+		{
+			COSMOS_LOG(Logger::Error, "Failed to bake animations of %s, the mesh doesn't use the skinned vertex layout", mFilepath.c_str());
+			return false;
+		}
+
+		// every clip is sampled evenly from it's start to it's end, the end included so looping clips blend back to their start
+		std::vector<AnimationFormat::Clip> clips(mAnimations.size());
+		uint32_t frameCount = 0;
+
+		for (size_t i = 0; i < mAnimations.size(); i++)
+		{
+			AnimationFormat::Clip& clip = clips[i];
+			clip.duration = GetAnimationDuration((uint32_t)i);
+			clip.firstFrame = frameCount;
+			clip.frameCount = (uint32_t)std::ceil(clip.duration * std::max(framerate, 1.0f)) + 1;
+			strncpy(clip.name, mAnimations[i].name.c_str(), AnimationFormat::NameMaxChars - 1);
+
+			frameCount += clip.frameCount;
+		}
+
+		// the texels of a joint are the first three rows of it's palette matrix, the last one is always 0, 0, 0, 1
+		const size_t rowTexels = (size_t)jointCount * AnimationFormat::TexelsPerJoint;
+		std::vector<glm::vec4> texels((size_t)frameCount * rowTexels);
+
+		ThreadPool::GetInstance().ParallelFor((uint32_t)clips.size(), [&](uint32_t c)
+		{
+			const AnimationFormat::Clip& clip = clips[c];
+			Pose pose = {};
+			std::vector<glm::mat4> palette(jointCount);
+
+			for (uint32_t f = 0; f < clip.frameCount; f++)
+			{
+				float time = clip.frameCount > 1 ? clip.duration * (float)f / (float)(clip.frameCount - 1) : 0.0f;
+				Animate(c, time, pose);
+				WritePalette(pose, palette.data());
+
+				glm::vec4* row = &texels[(size_t)(clip.firstFrame + f) * rowTexels];
+
+				for (uint32_t j = 0; j < jointCount; j++)
+				{
+					const glm::mat4 transposed = glm::transpose(palette[j]);
+					row[j * 3 + 0] = transposed[0];
+					row[j * 3 + 1] = transposed[1];
+					row[j * 3 + 2] = transposed[2];
+				}
+			}
+		});
+
+		AnimationFormat::Header header = {};
+		header.jointCount = jointCount;
+		header.frameCount = frameCount;
+		header.clipCount = (uint32_t)clips.size();
+		header.framerate = framerate;
+		header.clipsOffset = AnimationFormat::AlignSection(sizeof(AnimationFormat::Header));
+		header.palettesOffset = AnimationFormat::AlignSection(header.clipsOffset + clips.size() * sizeof(AnimationFormat::Clip));
+
+		std::ofstream file(destination, std::ios::binary | std::ios::trunc);
+
+		if (!file)
+		{
+			COSMOS_LOG(Logger::Error, "Failed to bake animations of %s, could not create %s", mFilepath.c_str(), destination.c_str());
+			return false;
+		}
+
+		// sections are zero padded up to their offset
+		auto writeSection = [&file](uint64_t offset, const void* data, size_t size)
+		{
+			static const char padding[AnimationFormat::SectionAlignment] = {};
+			file.write(padding, (std::streamsize)(offset - (uint64_t)file.tellp()));
+			file.write((const char*)data, (std::streamsize)size);
+		};
+
+		writeSection(0, &header, sizeof(header));
+		writeSection(header.clipsOffset, clips.data(), clips.size() * sizeof(AnimationFormat::Clip));
+		writeSection(header.palettesOffset, texels.data(), texels.size() * sizeof(glm::vec4));
+
+		if (!file)
+		{
+			COSMOS_LOG(Logger::Error, "Failed to bake animations of %s, could not write %s", mFilepath.c_str(), destination.c_str());
+			return false;
+		}
+
+		COSMOS_LOG(Logger::Info, "Baked animations of %s into %s (%d clips, %d frames of %d joints, %d KB)", mFilepath.c_str(), destination.c_str(), header.clipCount, frameCount, jointCount, (int32_t)(texels.size() * sizeof(glm::vec4) / 1024));
+		return true;
+	}
+
+	bool VKMesh::LoadBakedAnimations(std::string filepath)
+	{
+		// the baked pipelines read the skinned vertex layout, any other stride would be drawn as garbage
+		if (mVertexLayout != VertexLayout::Skinned)
+		{
+			COSMOS_LOG(Logger::Error, "Failed to load baked animation %s, mesh %s doesn't use the skinned vertex layout", filepath.c_str(), mFilepath.c_str());
+			return false;
+		}
+
+		Unique<BakedAnimation> baked = CreateUnique<BakedAnimation>(mRenderer);
+
+		if (!baked->Load(filepath))
+			return false;
+
+		// the vertices index the palette skin's joints, a file baked from another skeleton would tear the mesh apart
+		if (baked->GetJointCount() != GetJointCount() || baked->GetClips().size() != mAnimations.size())
+		{
+			COSMOS_LOG(Logger::Error, "Failed to load baked animation %s, it was baked from another mesh than %s", filepath.c_str(), mFilepath.c_str());
+			return false;
+		}
+
+		// the previous texture defers it's own release until the last frames reading it are done
+		mBakedAnimation = std::move(baked);
+
+		// the last frames may still be using the sets, new ones are written and the old ones freed with their pool once those frames are done
+		if (mDescriptorPool != VK_NULL_HANDLE)
+		{
+			VkDevice device = mRenderer->GetDevice()->GetLogicalDevice();
+			VkDescriptorPool pool = mDescriptorPool;
+			mRenderer->DeferRelease([device, pool]() { vkDestroyDescriptorPool(device, pool, nullptr); });
+
+			mDescriptorPool = VK_NULL_HANDLE;
+			mDescriptorSets.clear();
+
+			SetupDescriptors(mDescriptorPool, mDescriptorSets);
+			UpdateDescriptors(mDescriptorSets, mMaterial.colormapTex);
+			mInstanceVersions.assign(mDescriptorSets.size(), 0);
+		}
+
+		// colormap overrides are created again on their next use
+		PruneColormapOverrides(true);
+
+		return true;
+	}
+
+	float VKMesh::GetBakedFrame(uint32_t clip, float time) const
+	{
+		return mBakedAnimation ? mBakedAnimation->GetFrame(clip, time) : 0.0f;
+	}
+
+	void VKMesh::CollectAnimatedNodes(GLTF::Animation& animation)
+	{
+		std::unordered_set<GLTF::Node*> targets = {};
+
+		for (const GLTF::Animation::Channel& channel : animation.channels)
+		{
+			targets.insert(channel.node);
+		}
+
+		// nodes inside another target's subtree are updated by it
+		animation.roots.clear();
+
+		for (GLTF::Node* node : mLinearNodes)
+		{
+			if (targets.count(node) == 0)
+				continue;
+
+			bool nested = false;
+
+			for (GLTF::Node* p = node->parent; p != nullptr && !nested; p = p->parent)
+			{
+				nested = targets.count(p) > 0;
+			}
+
+			if (!nested)
+			{
+				animation.roots.push_back(node);
+			}
+		}
+	}
+
+	void VKMesh::DrawNode(GLTF::Node* node, FrameVector<VkDrawIndexedIndirectCommand>& commands, uint32_t indexBase, int32_t vertexBase, uint32_t firstInstance)
+	{
+		if (node->mesh)
+		{
+			// indices are relative to the primitive's vertices, both are offset by where the mesh lies on the heap
+			for (const GLTF::Primitive& primitive : node->mesh->primitives)
+			{
+				if (primitive.indexCount > 0)
+				{
+					VkDrawIndexedIndirectCommand command = {};
+					command.indexCount = primitive.indexCount;
+					command.instanceCount = 0;
+					command.firstIndex = indexBase + primitive.firstIndex;
+					command.vertexOffset = vertexBase + (int32_t)primitive.vertexStart;
+					command.firstInstance = firstInstance;
+					commands.push_back(command);
+				}
+			}
+		}
+	}
+
+	void VKMesh::CreateStorage(const tinygltf::Model* model, const MeshFormat::Header* header)
+	{
+		size_t nodeCount = 0;
+		size_t meshCount = 0;
+		size_t primitiveCount = 0;
+		size_t linkCount = 0;
+		size_t nameBytes = 0;
+		size_t lookupCount = 0;
+		size_t skinBytes = 0;
+
+		if (model != nullptr)
+		{
+			// only the nodes reachable from the scene are created, the same walk LoadNode does
+			const tinygltf::Scene& scene = model->scenes[model->defaultScene > -1 ? model->defaultScene : 0];
+			FrameVector<int32_t> stack(scene.nodes.begin(), scene.nodes.end());
+
+			while (!stack.empty())
+			{
+				const tinygltf::Node& node = model->nodes[stack.back()];
+				stack.pop_back();
+
+				nodeCount++;
+				linkCount += node.children.size();
+				nameBytes += node.name.size() + 1;
+
+				if (node.mesh > -1)
+				{
+					meshCount++;
+					primitiveCount += model->meshes[node.mesh].primitives.size();
+				}
+
+				stack.insert(stack.end(), node.children.begin(), node.children.end());
+			}
+
+			lookupCount = model->nodes.size();
+
+			for (const tinygltf::Skin& skin : model->skins)
+			{
+				size_t matrixCount = skin.inverseBindMatrices > -1 ? model->accessors[skin.inverseBindMatrices].count : 0;
+				skinBytes += sizeof(GLTF::Skin) + skin.name.size() + 1 + skin.joints.size() * sizeof(GLTF::Node*) + matrixCount * sizeof(glm::mat4) + 2 * alignof(std::max_align_t);
+			}
+		}
+
+		else if (header != nullptr)
+		{
+			const MeshFormat::Node* nodes = (const MeshFormat::Node*)((const uint8_t*)header + header->nodesOffset);
+			nodeCount = header->nodeCount;
+			linkCount = header->nodeCount;
+
+			for (uint32_t i = 0; i < header->nodeCount; i++)
+			{
+				nameBytes += strnlen(nodes[i].name, MeshFormat::NameMaxChars) + 1;
+
+				if (nodes[i].mesh > -1)
+				{
+					uint32_t first = std::min(nodes[i].firstPrimitive, header->primitiveCount);
+					meshCount++;
+					primitiveCount += std::min(nodes[i].primitiveCount, header->primitiveCount - first);
+				}
+			}
+		}
+
+		// the arrays are single allocations, every node's children array may need aligning
+		size_t capacity = nodeCount * sizeof(GLTF::Node) + meshCount * sizeof(GLTF::Mesh) + primitiveCount * sizeof(GLTF::Primitive)
+			+ (linkCount + lookupCount) * sizeof(GLTF::Node*) + nameBytes + skinBytes + (nodeCount + 8) * alignof(std::max_align_t);
+
+		mArena = CreateUnique<LinearArena>(capacity);
+		mNodeStorage.first = (GLTF::Node*)mArena->Allocate(nodeCount * sizeof(GLTF::Node), alignof(GLTF::Node));
+		mMeshStorage.first = (GLTF::Mesh*)mArena->Allocate(meshCount * sizeof(GLTF::Mesh), alignof(GLTF::Mesh));
+		mPrimitiveStorage.first = (GLTF::Primitive*)mArena->Allocate(primitiveCount * sizeof(GLTF::Primitive), alignof(GLTF::Primitive));
+		mNodeLookup.first = (GLTF::Node**)mArena->Allocate(lookupCount * sizeof(GLTF::Node*), alignof(GLTF::Node*));
+		mNodeLookup.count = (uint32_t)lookupCount;
+		std::fill(mNodeLookup.begin(), mNodeLookup.end(), nullptr);
+
+		mNodes.reserve(nodeCount);
+	}
+
+	GLTF::Node* VKMesh::CreateNode(GLTF::Node* parent, uint32_t index, const char* name, size_t nameLength, uint32_t childCount)
+	{
+		GLTF::Node* node = new (&mNodeStorage.first[mNodeStorage.count++]) GLTF::Node();
+		node->index = index;
+		node->parent = parent;
+		node->name = CopyString(name, nameLength);
+		node->children.first = (GLTF::Node**)mArena->Allocate(childCount * sizeof(GLTF::Node*), alignof(GLTF::Node*));
+
+		// children are linked as they're created, keeping the file's order
+		if (parent)
+		{
+			parent->children.first[parent->children.count++] = node;
+		}
+
+		else
+		{
+			mNodes.push_back(node);
+		}
+
+		if (index < mNodeLookup.count)
+		{
+			mNodeLookup[index] = node;
+		}
+
+		return node;
+	}
+
+	GLTF::Mesh* VKMesh::CreateMesh(uint32_t primitiveCount)
+	{
+		GLTF::Mesh* mesh = new (&mMeshStorage.first[mMeshStorage.count++]) GLTF::Mesh();
+		mesh->primitives.first = mPrimitiveStorage.first + mPrimitiveStorage.count;
+		mPrimitiveStorage.count += primitiveCount;
+
+		return mesh;
+	}
+
+	const char* VKMesh::CopyString(const char* source, size_t length)
+	{
+		if (length == 0)
+			return "";
+
+		char* destination = (char*)mArena->Allocate(length + 1, alignof(char));
+		memcpy(destination, source, length);
+		destination[length] = '\0';
+
+		return destination;
+	}
+
+	void VKMesh::LoadCookedNodes()
+	{
+		const uint8_t* data = mLoader->file->GetData();
+		const MeshFormat::Header* header = (const MeshFormat::Header*)data;
+		const MeshFormat::Node* nodes = (const MeshFormat::Node*)(data + header->nodesOffset);
+		const MeshFormat::Primitive* primitives = (const MeshFormat::Primitive*)(data + header->primitivesOffset);
+
+		// nodes are listed parents first, their children are counted so a parent's array is sized before they're created
+		FrameVector<uint32_t> childCounts(header->nodeCount, 0);
+		FrameVector<GLTF::Node*> created(header->nodeCount, nullptr);
+
+		for (uint32_t i = 0; i < header->nodeCount; i++)
 		{
-			for (auto& node : mNodes)
+			if (nodes[i].parent > -1 && (uint32_t)nodes[i].parent < i)
 			{
-				node->OnUpdate();
+				childCounts[nodes[i].parent]++;
 			}
 		}
-	}
 
-	void VKMesh::DrawNode(GLTF::Node* node, VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout)
-	{
-		if (node->mesh->primitives.size() > 0)
+		for (uint32_t i = 0; i < header->nodeCount; i++)
 		{
-			for (GLTF::Primitive* primitive : node->mesh->primitives)
+			const MeshFormat::Node& node = nodes[i];
+
+			GLTF::Node* newNode = CreateNode(node.parent > -1 && (uint32_t)node.parent < i ? created[node.parent] : nullptr, node.index, node.name, strnlen(node.name, MeshFormat::NameMaxChars), childCounts[i]);
+			newNode->translation = glm::make_vec3(node.translation);
+			newNode->rotation = glm::make_quat(node.rotation);
+			newNode->scale = glm::make_vec3(node.scale);
+			newNode->matrix = glm::make_mat4x4(node.matrix);
+
+			if (node.mesh > -1)
 			{
-				if (primitive->indexCount > 0)
+				uint32_t first = std::min(node.firstPrimitive, header->primitiveCount);
+				uint32_t count = std::min(node.primitiveCount, header->primitiveCount - first);
+				GLTF::Mesh* newMesh = CreateMesh(count);
+
+				for (uint32_t p = first; p < first + count; p++)
 				{
-					vkCmdDrawIndexed(commandBuffer, primitive->indexCount, 1, primitive->firstIndex, 0, 0);
+					GLTF::Primitive* newPrimitive = new (&newMesh->primitives.first[newMesh->primitives.count++]) GLTF::Primitive(primitives[p].firstIndex, primitives[p].indexCount, primitives[p].vertexStart, primitives[p].vertexCount, mMaterial);
+					newPrimitive->SetBoundingBox(glm::make_vec3(primitives[p].boundsMin), glm::make_vec3(primitives[p].boundsMax));
 				}
+
+				newMesh->CalculateBoundingBox();
+				newNode->mesh = newMesh;
 			}
-		}
 
-		for (auto& child : node->children)
-		{
-			DrawNode(child, commandBuffer, pipelineLayout);
+			created[i] = newNode;
 		}
+
+		// the cooked bounds replace the placeholder while the upload is in flight
+		mDimension.min = glm::make_vec3(header->boundsMin);
+		mDimension.max = glm::make_vec3(header->boundsMax);
+		mDimension.aabb = glm::scale(glm::mat4(1.0f), mDimension.max - mDimension.min);
+		mDimension.aabb[3][0] = mDimension.min[0];
+		mDimension.aabb[3][1] = mDimension.min[1];
+		mDimension.aabb[3][2] = mDimension.min[2];
 	}
 
 	void VKMesh::LoadNode(GLTF::Node* parent, const tinygltf::Node& node, uint32_t nodeIndex, const tinygltf::Model& model, LoaderInfo& loaderInfo, float globalscale)
 	{
-		GLTF::Node* newNode = new GLTF::Node();
-		newNode->index = nodeIndex;
-		newNode->parent = parent;
-		newNode->name = node.name;
+		GLTF::Node* newNode = CreateNode(parent, nodeIndex, node.name.c_str(), node.name.size(), (uint32_t)node.children.size());
 		newNode->skinIndex = node.skin;
 		newNode->matrix = glm::mat4(1.0f);
 
@@ -561,264 +1864,62 @@ namespace Cosmos::Vulkan
 			}
 		}
 
-		// node contains mesh data
+		// node contains mesh data, after it's children like the worker listed the primitives
 		if (node.mesh > -1)
 		{
-			const tinygltf::Mesh mesh = model.meshes[node.mesh];
-			GLTF::Mesh* newMesh = new GLTF::Mesh(mRenderer->GetDevice(), newNode->matrix);
+			const tinygltf::Mesh& mesh = model.meshes[node.mesh];
+			GLTF::Mesh* newMesh = CreateMesh((uint32_t)mesh.primitives.size());
 
+			// primitives were listed and decoded by the worker in the same order they're loaded here
 			for (size_t j = 0; j < mesh.primitives.size(); j++)
 			{
-				const tinygltf::Primitive& primitive = mesh.primitives[j];
-				uint32_t vertexStart = static_cast<uint32_t>(loaderInfo.vertexPos);
-				uint32_t indexStart = static_cast<uint32_t>(loaderInfo.indexPos);
-				uint32_t indexCount = 0;
-				uint32_t vertexCount = 0;
-				glm::vec3 posMin{};
-				glm::vec3 posMax{};
-				bool hasSkin = false;
-				bool hasIndices = primitive.indices > -1;
-
-				// vertices
-				{
-					const float* bufferPos = nullptr;
-					const float* bufferNormals = nullptr;
-					const float* bufferTexCoordSet0 = nullptr;
-					const float* bufferTexCoordSet1 = nullptr;
-					const float* bufferColorSet0 = nullptr;
-					const void* bufferJoints = nullptr;
-					const float* bufferWeights = nullptr;
-
-					int posByteStride;
-					int normByteStride;
-					int uv0ByteStride;
-					int color0ByteStride;
-					int jointByteStride;
-					int weightByteStride;
-
-					int jointComponentType;
-
-					// Position attribute is required
-					assert(primitive.attributes.find("POSITION") != primitive.attributes.end());
-
-					const tinygltf::Accessor& posAccessor = model.accessors[primitive.attributes.find("POSITION")->second];
-					const tinygltf::BufferView& posView = model.bufferViews[posAccessor.bufferView];
-					bufferPos = reinterpret_cast<const float*>(&(model.buffers[posView.buffer].data[posAccessor.byteOffset + posView.byteOffset]));
-					posMin = glm::vec3(posAccessor.minValues[0], posAccessor.minValues[1], posAccessor.minValues[2]);
-					posMax = glm::vec3(posAccessor.maxValues[0], posAccessor.maxValues[1], posAccessor.maxValues[2]);
-					vertexCount = static_cast<uint32_t>(posAccessor.count);
-					posByteStride = posAccessor.ByteStride(posView) ? (posAccessor.ByteStride(posView) / sizeof(float)) : tinygltf::GetNumComponentsInType(TINYGLTF_TYPE_VEC3);
-
-					if (primitive.attributes.find("NORMAL") != primitive.attributes.end())
-					{
-						const tinygltf::Accessor& normAccessor = model.accessors[primitive.attributes.find("NORMAL")->second];
-						const tinygltf::BufferView& normView = model.bufferViews[normAccessor.bufferView];
-						bufferNormals = reinterpret_cast<const float*>(&(model.buffers[normView.buffer].data[normAccessor.byteOffset + normView.byteOffset]));
-						normByteStride = normAccessor.ByteStride(normView) ? (normAccessor.ByteStride(normView) / sizeof(float)) : tinygltf::GetNumComponentsInType(TINYGLTF_TYPE_VEC3);
-					}
-
-					// uv0
-					if (primitive.attributes.find("TEXCOORD_0") != primitive.attributes.end())
-					{
-						const tinygltf::Accessor& uvAccessor = model.accessors[primitive.attributes.find("TEXCOORD_0")->second];
-						const tinygltf::BufferView& uvView = model.bufferViews[uvAccessor.bufferView];
-						bufferTexCoordSet0 = reinterpret_cast<const float*>(&(model.buffers[uvView.buffer].data[uvAccessor.byteOffset + uvView.byteOffset]));
-						uv0ByteStride = uvAccessor.ByteStride(uvView) ? (uvAccessor.ByteStride(uvView) / sizeof(float)) : tinygltf::GetNumComponentsInType(TINYGLTF_TYPE_VEC2);
-					}
-
-					// vertex colors
-					if (primitive.attributes.find("COLOR_0") != primitive.attributes.end())
-					{
-						const tinygltf::Accessor& accessor = model.accessors[primitive.attributes.find("COLOR_0")->second];
-						const tinygltf::BufferView& view = model.bufferViews[accessor.bufferView];
-						bufferColorSet0 = reinterpret_cast<const float*>(&(model.buffers[view.buffer].data[accessor.byteOffset + view.byteOffset]));
-						color0ByteStride = accessor.ByteStride(view) ? (accessor.ByteStride(view) / sizeof(float)) : tinygltf::GetNumComponentsInType(TINYGLTF_TYPE_VEC3);
-					}
-
-					// skinning joints
-					if (primitive.attributes.find("JOINTS_0") != primitive.attributes.end())
-					{
-						const tinygltf::Accessor& jointAccessor = model.accessors[primitive.attributes.find("JOINTS_0")->second];
-						const tinygltf::BufferView& jointView = model.bufferViews[jointAccessor.bufferView];
-						bufferJoints = &(model.buffers[jointView.buffer].data[jointAccessor.byteOffset + jointView.byteOffset]);
-						jointComponentType = jointAccessor.componentType;
-						jointByteStride = jointAccessor.ByteStride(jointView) ? (jointAccessor.ByteStride(jointView) / tinygltf::GetComponentSizeInBytes(jointComponentType)) : tinygltf::GetNumComponentsInType(TINYGLTF_TYPE_VEC4);
-					}
-
-					// skinning weights
-					if (primitive.attributes.find("WEIGHTS_0") != primitive.attributes.end())
-					{
-						const tinygltf::Accessor& weightAccessor = model.accessors[primitive.attributes.find("WEIGHTS_0")->second];
-						const tinygltf::BufferView& weightView = model.bufferViews[weightAccessor.bufferView];
-						bufferWeights = reinterpret_cast<const float*>(&(model.buffers[weightView.buffer].data[weightAccessor.byteOffset + weightView.byteOffset]));
-						weightByteStride = weightAccessor.ByteStride(weightView) ? (weightAccessor.ByteStride(weightView) / sizeof(float)) : tinygltf::GetNumComponentsInType(TINYGLTF_TYPE_VEC4);
-					}
-
-					hasSkin = (bufferJoints && bufferWeights);
-
-					for (size_t v = 0; v < posAccessor.count; v++)
-					{
-						Vertex& vert = loaderInfo.vertexBuffer[loaderInfo.vertexPos];
-						vert.position = glm::vec4(glm::make_vec3(&bufferPos[v * posByteStride]), 1.0f);
-						vert.normal = glm::normalize(glm::vec3(bufferNormals ? glm::make_vec3(&bufferNormals[v * normByteStride]) : glm::vec3(0.0f)));
-						vert.uv = bufferTexCoordSet0 ? glm::make_vec2(&bufferTexCoordSet0[v * uv0ByteStride]) : glm::vec3(0.0f);
-						vert.color = bufferColorSet0 ? glm::make_vec4(&bufferColorSet0[v * color0ByteStride]) : glm::vec4(1.0f);
-
-						if (hasSkin)
-						{
-							switch (jointComponentType)
-							{
-								case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
-								{
-									const uint16_t* buf = static_cast<const uint16_t*>(bufferJoints);
-									vert.joint = glm::uvec4(glm::make_vec4(&buf[v * jointByteStride]));
-									break;
-								}
-
-								case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
-								{
-									const uint8_t* buf = static_cast<const uint8_t*>(bufferJoints);
-									vert.joint = glm::vec4(glm::make_vec4(&buf[v * jointByteStride]));
-									break;
-								}
-
-								default:
-								{
-									COSMOS_LOG(Logger::Error, "Joint component type %d is not supported", jointComponentType);
-									break;
-								}
-							}
-						}
-
-						else
-						{
-							vert.joint = glm::vec4(0.0f);
-						}
-
-						vert.weight = hasSkin ? glm::make_vec4(&bufferWeights[v * weightByteStride]) : glm::vec4(0.0f);
-						
-						// fix for all zero weights
-						if (glm::length(vert.weight) == 0.0f)
-						{
-							vert.weight = glm::vec4(1.0f, 0.0f, 0.0f, 0.0f);
-						}
-
-						loaderInfo.vertexPos++;
-						mVertices[v] = vert;
-					}
-				}
-
-				// indices
-				if (hasIndices)
-				{
-					const tinygltf::Accessor& accessor = model.accessors[primitive.indices > -1 ? primitive.indices : 0];
-					const tinygltf::BufferView& bufferView = model.bufferViews[accessor.bufferView];
-					const tinygltf::Buffer& buffer = model.buffers[bufferView.buffer];
-
-					indexCount = static_cast<uint32_t>(accessor.count);
-					const void* dataPtr = &(buffer.data[accessor.byteOffset + bufferView.byteOffset]);
-
-					switch (accessor.componentType)
-					{
-						case TINYGLTF_PARAMETER_TYPE_UNSIGNED_INT:
-						{
-							const uint32_t* buf = static_cast<const uint32_t*>(dataPtr);
-							for (size_t index = 0; index < accessor.count; index++)
-							{
-								loaderInfo.indexBuffer[loaderInfo.indexPos] = buf[index] + vertexStart;
-								loaderInfo.indexPos++;
-							}
-
-							break;
-						}
-
-						case TINYGLTF_PARAMETER_TYPE_UNSIGNED_SHORT:
-						{
-							const uint16_t* buf = static_cast<const uint16_t*>(dataPtr);
-							for (size_t index = 0; index < accessor.count; index++)
-							{
-								loaderInfo.indexBuffer[loaderInfo.indexPos] = buf[index] + vertexStart;
-								loaderInfo.indexPos++;
-							}
-
-							break;
-						}
-
-						case TINYGLTF_PARAMETER_TYPE_UNSIGNED_BYTE:
-						{
-							const uint8_t* buf = static_cast<const uint8_t*>(dataPtr);
-							for (size_t index = 0; index < accessor.count; index++)
-							{
-								loaderInfo.indexBuffer[loaderInfo.indexPos] = buf[index] + vertexStart;
-								loaderInfo.indexPos++;
-							}
-
-							break;
-						}
-
-						default:
-						{
-							COSMOS_LOG(Logger::Error, "Inex component type %d is not supported");
-							return;
-						}
-					}
-				}
+				const PrimitiveInfo& info = loaderInfo.primitives[loaderInfo.primitivePos++];
 
-				GLTF::Primitive* newPrimitive = new GLTF::Primitive(indexStart, indexCount, vertexCount, mMaterial);
-				newPrimitive->SetBoundingBox(posMin, posMax);
-				newMesh->primitives.push_back(newPrimitive);
+				GLTF::Primitive* newPrimitive = new (&newMesh->primitives.first[newMesh->primitives.count++]) GLTF::Primitive(info.indexStart, info.indexCount, info.vertexStart, info.vertexCount, mMaterial);
+				newPrimitive->SetBoundingBox(info.min, info.max);
 			}
 
 			// mesh BB from BBs of primitives
-			for (auto p : newMesh->primitives)
-			{
-				if (p->bb.IsValid() && !newMesh->bb.IsValid())
-				{
-					newMesh->bb = p->bb;
-					newMesh->bb.SetValid(true);;
-				}
-
-				newMesh->bb.SetMin(glm::min(newMesh->bb.GetMin(), p->bb.GetMin()));
-				newMesh->bb.SetMax(glm::max(newMesh->bb.GetMax(), p->bb.GetMax()));
-			}
-
+			newMesh->CalculateBoundingBox();
 			newNode->mesh = newMesh;
 		}
-
-		if (parent)
-		{
-			parent->children.push_back(newNode);
-		}
-
-		else
-		{
-			mNodes.push_back(newNode);
-		}
-
-		mLinearNodes.push_back(newNode);
 	}
 
-	void VKMesh::GetNodeProperties(const tinygltf::Node& node, const tinygltf::Model& model, size_t& vertexCount, size_t& indexCount)
+	void VKMesh::GetNodeProperties(const tinygltf::Node& node, const tinygltf::Model& model, std::vector<PrimitiveInfo>& primitives, size_t& vertexCount, size_t& indexCount)
 	{
 		if (node.children.size() > 0)
 		{
 			for (size_t i = 0; i < node.children.size(); i++) {
-				GetNodeProperties(model.nodes[node.children[i]], model, vertexCount, indexCount);
+				GetNodeProperties(model.nodes[node.children[i]], model, primitives, vertexCount, indexCount);
 			}
 		}
 
 		if (node.mesh > -1)
 		{
-			const tinygltf::Mesh mesh = model.meshes[node.mesh];
+			const tinygltf::Mesh& mesh = model.meshes[node.mesh];
 			for (size_t i = 0; i < mesh.primitives.size(); i++)
 			{
-				auto primitive = mesh.primitives[i];
-				vertexCount += model.accessors[primitive.attributes.find("POSITION")->second].count;
+				const tinygltf::Primitive& primitive = mesh.primitives[i];
+
+				PrimitiveInfo info = {};
+				info.primitive = &primitive;
+				info.vertexStart = (uint32_t)vertexCount;
+				info.indexStart = (uint32_t)indexCount;
 
-				if (primitive.indices > -1)
+				// position attribute is required
+				if (primitive.attributes.find("POSITION") == primitive.attributes.end())
 				{
-					indexCount += model.accessors[primitive.indices].count;
+					info.error = "Primitive without positions is not supported";
+					primitives.push_back(info);
+					continue;
 				}
+
+				info.vertexCount = (uint32_t)model.accessors[primitive.attributes.find("POSITION")->second].count;
+				info.indexCount = primitive.indices > -1 ? (uint32_t)model.accessors[primitive.indices].count : 0;
+
+				vertexCount += info.vertexCount;
+				indexCount += info.indexCount;
+				primitives.push_back(info);
 			}
 		}
 	}
@@ -827,18 +1928,35 @@ namespace Cosmos::Vulkan
 	{
 		COSMOS_LOG(Logger::Todo, "Implement better support for materials, only supporting one material per mesh");
 
+		// the default colormap is shared by every mesh using it, streamed meshes don't upload it again
+		static std::weak_ptr<Texture2D> sDefaultColormap;
+
 		mMaterial.index = (int32_t)0;
 		mMaterial.name = "Material";
 		mMaterial.colormapPath = GetAssetSubDir("Texture/Default/Mesh_Colormap.png");
-		mMaterial.colormapTex = VKTexture2D::Create(mRenderer, mMaterial.colormapPath.c_str(), true);
+		mMaterial.colormapTex = sDefaultColormap.lock();
+
+		if (!mMaterial.colormapTex)
+		{
+			mMaterial.colormapTex = VKTexture2D::Create(mRenderer, mMaterial.colormapPath.c_str(), true);
+			sDefaultColormap = mMaterial.colormapTex;
+		}
 	}
 
 	void VKMesh::LoadAnimations(tinygltf::Model& gltfModel)
 	{
-		for (tinygltf::Animation& anim : gltfModel.animations)
+		const AnimationCompressor::Tolerance tolerance = {};
+		size_t sourceBytes = 0;
+		size_t compressedBytes = 0;
+		mAnimations.reserve(mAnimations.size() + gltfModel.animations.size());
+
+		for (const tinygltf::Animation& anim : gltfModel.animations)
 		{
 			GLTF::Animation animation = {};
+			std::vector<std::vector<glm::vec4>> samplerValues(anim.samplers.size());
 			animation.name = anim.name;
+			animation.samplers.reserve(anim.samplers.size());
+			animation.channels.reserve(anim.channels.size());
 
 			if (anim.name.empty())
 			{
@@ -846,7 +1964,7 @@ namespace Cosmos::Vulkan
 			}
 
 			// samplers
-			for (auto& samp : anim.samplers)
+			for (const tinygltf::AnimationSampler& samp : anim.samplers)
 			{
 				GLTF::Animation::Sampler sampler = {};
 
@@ -876,12 +1994,9 @@ namespace Cosmos::Vulkan
 					const void* dataPtr = &buffer.data[accessor.byteOffset + bufferView.byteOffset];
 					const float* buf = static_cast<const float*>(dataPtr);
 
-					for (size_t index = 0; index < accessor.count; index++)
-					{
-						sampler.inputs.push_back(buf[index]);
-					}
+					sampler.inputs.assign(buf, buf + accessor.count);
 
-					for (auto input : sampler.inputs)
+					for (float input : sampler.inputs)
 					{
 						if (input < animation.start)
 						{
@@ -904,18 +2019,29 @@ namespace Cosmos::Vulkan
 					assert(accessor.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT);
 
 					const void* dataPtr = &buffer.data[accessor.byteOffset + bufferView.byteOffset];
+					const bool spline = sampler.interpolation == GLTF::Animation::Sampler::InterpolationType::CUBICSPLINE;
+					std::vector<glm::vec4>& values = samplerValues[animation.samplers.size()];
 
+					// splines keep their floats, the other keys are compressed once the channels tell their path
 					switch (accessor.type)
 					{
 						case TINYGLTF_TYPE_VEC3:
 						{
 							const glm::vec3* buf = static_cast<const glm::vec3*>(dataPtr);
+							sampler.components = 3;
+							sourceBytes += accessor.count * (sizeof(glm::vec4) + sizeof(glm::vec3));
+
+							if (spline)
+							{
+								sampler.outputs.assign((const float*)buf, (const float*)buf + accessor.count * 3);
+								break;
+							}
+
+							values.resize(accessor.count);
+
 							for (size_t index = 0; index < accessor.count; index++)
 							{
-								sampler.outputsVec4.push_back(glm::vec4(buf[index], 0.0f));
-								sampler.outputs.push_back(buf[index][0]);
-								sampler.outputs.push_back(buf[index][1]);
-								sampler.outputs.push_back(buf[index][2]);
+								values[index] = glm::vec4(buf[index], 0.0f);
 							}
 							break;
 						}
@@ -923,14 +2049,16 @@ namespace Cosmos::Vulkan
 						case TINYGLTF_TYPE_VEC4:
 						{
 							const glm::vec4* buf = static_cast<const glm::vec4*>(dataPtr);
-							for (size_t index = 0; index < accessor.count; index++)
+							sampler.components = 4;
+							sourceBytes += accessor.count * (sizeof(glm::vec4) + sizeof(glm::vec4));
+
+							if (spline)
 							{
-								sampler.outputsVec4.push_back(buf[index]);
-								sampler.outputs.push_back(buf[index][0]);
-								sampler.outputs.push_back(buf[index][1]);
-								sampler.outputs.push_back(buf[index][2]);
-								sampler.outputs.push_back(buf[index][3]);
+								sampler.outputs.assign((const float*)buf, (const float*)buf + accessor.count * 4);
+								break;
 							}
+
+							values.assign(buf, buf + accessor.count);
 							break;
 						}
 
@@ -942,11 +2070,11 @@ namespace Cosmos::Vulkan
 					}
 				}
 
-				animation.samplers.push_back(sampler);
+				animation.samplers.push_back(std::move(sampler));
 			}
 
 			// channels
-			for (auto& source : anim.channels)
+			for (const tinygltf::AnimationChannel& source : anim.channels)
 			{
 				GLTF::Animation::Channel channel{};
 
@@ -982,16 +2110,63 @@ namespace Cosmos::Vulkan
 				animation.channels.push_back(channel);
 			}
 
-			mAnimations.push_back(animation);
+			// redundant keys are removed and the rest quantized, a sampler read by a rotation channel holds rotations
+			for (size_t i = 0; i < animation.samplers.size(); i++)
+			{
+				GLTF::Animation::Sampler& sampler = animation.samplers[i];
+				sourceBytes += sampler.inputs.size() * sizeof(float);
+
+				if (sampler.interpolation != GLTF::Animation::Sampler::InterpolationType::CUBICSPLINE)
+				{
+					GLTF::Animation::Channel::PathType path = GLTF::Animation::Channel::PathType::TRANSLATION;
+
+					for (const GLTF::Animation::Channel& channel : animation.channels)
+					{
+						if (channel.samplerIndex == (uint32_t)i)
+						{
+							path = channel.path;
+							break;
+						}
+					}
+
+					const bool rotation = path == GLTF::Animation::Channel::PathType::ROTATION;
+					const bool step = sampler.interpolation == GLTF::Animation::Sampler::InterpolationType::STEP;
+					std::vector<glm::vec4>& values = samplerValues[i];
+
+					if (rotation)
+					{
+						for (glm::vec4& value : values)
+						{
+							float length = glm::length(value);
+							value = length > 0.0f ? value / length : glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+						}
+					}
+
+					float error = rotation ? tolerance.rotation : path == GLTF::Animation::Channel::PathType::SCALE ? tolerance.scale : tolerance.translation;
+					AnimationCompressor::ReduceKeys(sampler.inputs, values, error, rotation, step);
+					sampler.track = AnimationCompressor::Quantize(values, rotation);
+				}
+
+				compressedBytes += sampler.GetSize();
+			}
+
+			mAnimations.push_back(std::move(animation));
+		}
+
+		if (sourceBytes > 0)
+		{
+			COSMOS_LOG(Logger::Trace, "Compressed the animations of %s from %zu to %zu bytes", mFilepath.c_str(), sourceBytes, compressedBytes);
 		}
 	}
 
 	void VKMesh::LoadSkins(tinygltf::Model& gltfModel)
 	{
-		for (tinygltf::Skin& source : gltfModel.skins)
+		mSkins.first = (GLTF::Skin*)mArena->Allocate(gltfModel.skins.size() * sizeof(GLTF::Skin), alignof(GLTF::Skin));
+
+		for (const tinygltf::Skin& source : gltfModel.skins)
 		{
-			GLTF::Skin* newSkin = new GLTF::Skin();
-			newSkin->name = source.name;
+			GLTF::Skin* newSkin = new (&mSkins.first[mSkins.count++]) GLTF::Skin();
+			newSkin->name = CopyString(source.name.c_str(), source.name.size());
 
 			// find skeleton root node
 			if (source.skeleton > -1)
@@ -1000,12 +2175,15 @@ namespace Cosmos::Vulkan
 			}
 
 			// find joint nodes
+			newSkin->joints.first = (GLTF::Node**)mArena->Allocate(source.joints.size() * sizeof(GLTF::Node*), alignof(GLTF::Node*));
+
 			for (int jointIndex : source.joints)
 			{
 				GLTF::Node* node = GetNodeFromIndex(jointIndex);
+
 				if (node)
 				{
-					newSkin->joints.push_back(GetNodeFromIndex(jointIndex));
+					newSkin->joints.first[newSkin->joints.count++] = node;
 				}
 			}
 
@@ -1015,149 +2193,119 @@ namespace Cosmos::Vulkan
 				const tinygltf::Accessor& accessor = gltfModel.accessors[source.inverseBindMatrices];
 				const tinygltf::BufferView& bufferView = gltfModel.bufferViews[accessor.bufferView];
 				const tinygltf::Buffer& buffer = gltfModel.buffers[bufferView.buffer];
-				newSkin->inverseBindMatrices.resize(accessor.count);
-				memcpy(newSkin->inverseBindMatrices.data(), &buffer.data[accessor.byteOffset + bufferView.byteOffset], accessor.count * sizeof(glm::mat4));
-			}
-
-			mSkins.push_back(newSkin);
-		}
-	}
-
-	GLTF::Node* VKMesh::GetNode(GLTF::Node* parent, uint32_t index)
-	{
-		GLTF::Node* found = nullptr;
-
-		if (parent->index == index)
-		{
-			return parent;
-		}
-
-		for (auto& child : parent->children)
-		{
-			found = GetNode(child, index);
-
-			if (found)
-			{
-				break;
+				newSkin->inverseBindMatrices.first = (glm::mat4*)mArena->Allocate(accessor.count * sizeof(glm::mat4), alignof(glm::mat4));
+				newSkin->inverseBindMatrices.count = (uint32_t)accessor.count;
+				memcpy(newSkin->inverseBindMatrices.first, &buffer.data[accessor.byteOffset + bufferView.byteOffset], accessor.count * sizeof(glm::mat4));
 			}
 		}
-		return found;
 	}
 
-	GLTF::Node* VKMesh::GetNodeFromIndex(uint32_t index)
+	GLTF::Node* VKMesh::GetNodeFromIndex(int32_t index)
 	{
-		GLTF::Node* found = nullptr;
-		for (auto& node : mNodes)
-		{
-			found = GetNode(node, index);
-
-			if (found)
-			{
-				break;
-			}
-		}
+		if (index < 0 || (uint32_t)index >= mNodeLookup.count)
+			return nullptr;
 
-		return found;
+		return mNodeLookup[index];
 	}
 
-	void VKMesh::CreateRendererResources(size_t vertexCount, size_t indexCount, LoaderInfo& loaderInfo)
+	void VKMesh::CreateRendererResources(Shared<Device> device, LoaderInfo& loaderInfo)
 	{
-		size_t vertexBufferSize = vertexCount * sizeof(Vertex);
-		size_t indexBufferSize = indexCount * sizeof(uint32_t);
-
-		struct StagingBuffer
-		{
-			VkBuffer buffer;
-			VmaAllocation memory;
-		} vertexStaging, indexStaging;
-
-		// create staging buffers
-		COSMOS_ASSERT(mRenderer->GetDevice()->CreateBuffer
+		// the copy into the geometry heap is recorded by the main thread, that owns the heap
+		COSMOS_ASSERT(device->CreateBuffer
 		(
 			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
 			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-			vertexBufferSize,
-			&vertexStaging.buffer,
-			&vertexStaging.memory,
-			loaderInfo.vertexBuffer) == VK_SUCCESS, "Failed to create vertex staging buffer"
+			loaderInfo.vertexBytes,
+			&loaderInfo.vertexStaging,
+			&loaderInfo.vertexStagingMemory,
+			(void*)loaderInfo.vertexData) == VK_SUCCESS, "Failed to create vertex staging buffer"
 		);
 
-		if (indexBufferSize > 0)
+		// index buffer
+		if (loaderInfo.indexBytes > 0)
 		{
-			COSMOS_ASSERT(mRenderer->GetDevice()->CreateBuffer
+			COSMOS_ASSERT(device->CreateBuffer
 			(
 				VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
 				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-				indexBufferSize,
-				&indexStaging.buffer,
-				&indexStaging.memory,
-				loaderInfo.indexBuffer) == VK_SUCCESS, "Failed to create index staging buffer"
+				loaderInfo.indexBytes,
+				&loaderInfo.indexStaging,
+				&loaderInfo.indexStagingMemory,
+				(void*)loaderInfo.indexData) == VK_SUCCESS, "Failed to create index staging buffer"
 			);
 		}
+	}
 
-		// create device local buffers
-		COSMOS_ASSERT(mRenderer->GetDevice()->CreateBuffer
-		(
-			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-			vertexBufferSize,
-			&mVertexBuffer,
-			&mVertexMemory) == VK_SUCCESS, "Failed to create vertex local buffer"
-		);
+	void VKMesh::SubmitUpload()
+	{
+		LoaderInfo& loaderInfo = *mLoader;
+		VkDevice device = mRenderer->GetDevice()->GetLogicalDevice();
+		Shared<GeometryHeap> heap = mRenderer->GetGeometryHeap();
 
-		// index buffer
-		if (indexBufferSize > 0)
+		// allocating may grow the heap, the ranges are written on the buffers it has after that
+		mVertexRange = heap->Allocate(GeometryHeap::GetVertexPool(loaderInfo.layout), loaderInfo.vertexBytes);
+		mVertexCount = (uint32_t)(loaderInfo.vertexBytes / GetVertexStride(loaderInfo.layout));
+
+		if (loaderInfo.indexBytes > 0)
 		{
-			COSMOS_ASSERT(mRenderer->GetDevice()->CreateBuffer
-			(
-				VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-				indexBufferSize,
-				&mIndexBuffer,
-				&mIndexMemory) == VK_SUCCESS, "Failed to create index local buffer"
-			);
+			mIndexRange = heap->Allocate(GeometryHeap::Indices, loaderInfo.indexBytes);
 		}
 
-		// copy from staging buffer to device local buffer
+		// copy from staging buffer to the heap
 		auto& renderpass = mRenderer->GetRenderpassManager()->GetMainRenderpass()->GetSpecificationRef();
-		VkCommandBuffer cmdbuffer = mRenderer->GetDevice()->CreateCommandBuffer(renderpass.commandPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
+		loaderInfo.commandBuffer = mRenderer->GetDevice()->CreateCommandBuffer(renderpass.commandPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
+
+		// the ranges may have been freed by meshes still drawn or skinned by frames in flight, or be moved by a relocation submitted before
+		VkMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		vkCmdPipelineBarrier(loaderInfo.commandBuffer, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
 
-		VkBufferCopy copyRegion = {};
-		copyRegion.size = vertexBufferSize;
-		vkCmdCopyBuffer(cmdbuffer, vertexStaging.buffer, mVertexBuffer, 1, & copyRegion);
+		heap->RecordUpload(loaderInfo.commandBuffer, loaderInfo.vertexStaging, mVertexRange, loaderInfo.vertexBytes);
 
-		if (indexBufferSize > 0)
+		if (mIndexRange != GeometryHeap::InvalidHandle)
 		{
-			copyRegion.size = indexBufferSize;
-			vkCmdCopyBuffer(cmdbuffer, indexStaging.buffer, mIndexBuffer, 1, &copyRegion);
+			heap->RecordUpload(loaderInfo.commandBuffer, loaderInfo.indexStaging, mIndexRange, loaderInfo.indexBytes);
 		}
 
-		mRenderer->GetDevice()->EndCommandBuffer(renderpass.commandPool, cmdbuffer, mRenderer->GetDevice()->GetGraphicsQueue(), true);
+		// makes the copy visible to the draws and to the compute skinning submitted after it
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+		vkCmdPipelineBarrier(loaderInfo.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
 
-		// free staging resources
-		vmaDestroyBuffer(mRenderer->GetDevice()->GetAllocator(), vertexStaging.buffer, vertexStaging.memory);
+		COSMOS_ASSERT(vkEndCommandBuffer(loaderInfo.commandBuffer) == VK_SUCCESS, "Failed to end the recording of the command buffer");
 
-		if (indexBufferSize > 0)
-		{
-			vmaDestroyBuffer(mRenderer->GetDevice()->GetAllocator(), indexStaging.buffer, indexStaging.memory);
-		}
+		VkFenceCreateInfo fenceCI = {};
+		fenceCI.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		COSMOS_ASSERT(vkCreateFence(device, &fenceCI, nullptr, &loaderInfo.fence) == VK_SUCCESS, "Failed to create fence for the mesh upload");
+
+		VkSubmitInfo submitInfo = {};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &loaderInfo.commandBuffer;
+
+		// not waited for, the fence is polled on the next updates
+		COSMOS_ASSERT(vkQueueSubmit(mRenderer->GetDevice()->GetGraphicsQueue(), 1, &submitInfo, loaderInfo.fence) == VK_SUCCESS, "Failed to submit the mesh upload");
 	}
 
-	void VKMesh::SetupDescriptors()
+	void VKMesh::SetupDescriptors(VkDescriptorPool& pool, std::vector<VkDescriptorSet>& sets)
 	{
 		// descriptor pool and descriptor sets
-		std::array<VkDescriptorPoolSize, 2> poolSizes = {};
+		std::array<VkDescriptorPoolSize, 3> poolSizes = {};
 		poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		poolSizes[0].descriptorCount = mRenderer->GetConcurrentlyRenderedFramesCount();
+		poolSizes[0].descriptorCount = 2 * mRenderer->GetConcurrentlyRenderedFramesCount();
 		poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		poolSizes[1].descriptorCount = mRenderer->GetConcurrentlyRenderedFramesCount();
+		poolSizes[1].descriptorCount = 2 * mRenderer->GetConcurrentlyRenderedFramesCount();
+		poolSizes[2].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		poolSizes[2].descriptorCount = 4 * mRenderer->GetConcurrentlyRenderedFramesCount();
 
 		VkDescriptorPoolCreateInfo descPoolCI = {};
 		descPoolCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
 		descPoolCI.poolSizeCount = (uint32_t)poolSizes.size();
 		descPoolCI.pPoolSizes = poolSizes.data();
 		descPoolCI.maxSets = mRenderer->GetConcurrentlyRenderedFramesCount();
-		COSMOS_ASSERT(vkCreateDescriptorPool(mRenderer->GetDevice()->GetLogicalDevice(), &descPoolCI, nullptr, &mDescriptorPool) == VK_SUCCESS, "Failed to create descriptor pool");
+		COSMOS_ASSERT(vkCreateDescriptorPool(mRenderer->GetDevice()->GetLogicalDevice(), &descPoolCI, nullptr, &pool) == VK_SUCCESS, "Failed to create descriptor pool");
 
 		VkDescriptorSetLayout descriptorSetLayout = mRenderer->GetPipelineLibrary()->GetPipelinesRef()["Mesh.Common"]->GetDescriptorSetLayout();
 
@@ -1169,30 +2317,37 @@ namespace Cosmos::Vulkan
 
 		VkDescriptorSetAllocateInfo descSetAllocInfo = {};
 		descSetAllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-		descSetAllocInfo.descriptorPool = mDescriptorPool;
+		descSetAllocInfo.descriptorPool = pool;
 		descSetAllocInfo.descriptorSetCount = (uint32_t)mRenderer->GetConcurrentlyRenderedFramesCount();
 		descSetAllocInfo.pSetLayouts = layouts.data();
 
-		mDescriptorSets.resize(mRenderer->GetConcurrentlyRenderedFramesCount());
-		COSMOS_ASSERT(vkAllocateDescriptorSets(mRenderer->GetDevice()->GetLogicalDevice(), &descSetAllocInfo, mDescriptorSets.data()) == VK_SUCCESS, "Failed to allocate descriptor sets");
+		sets.resize(mRenderer->GetConcurrentlyRenderedFramesCount());
+		COSMOS_ASSERT(vkAllocateDescriptorSets(mRenderer->GetDevice()->GetLogicalDevice(), &descSetAllocInfo, sets.data()) == VK_SUCCESS, "Failed to allocate descriptor sets");
 	}
 
-	void VKMesh::UpdateDescriptors()
+	void VKMesh::UpdateDescriptors(const std::vector<VkDescriptorSet>& sets, Shared<Texture2D> colormap)
 	{
 		for (size_t i = 0; i < mRenderer->GetConcurrentlyRenderedFramesCount(); i++)
 		{
-			std::vector<VkWriteDescriptorSet> descriptorWrites = {};
+			// infos must outlive the blocks, they're only read on vkUpdateDescriptorSets
+			VkDescriptorBufferInfo cameraUBOInfo = {};
+			VkDescriptorBufferInfo windowUBOInfo = {};
+			VkDescriptorBufferInfo storageBufferInfo = {};
+			VkDescriptorImageInfo colorMapInfo = {};
+			VkDescriptorImageInfo animationInfo = {};
+
+			FrameVector<VkWriteDescriptorSet> descriptorWrites = {};
+			descriptorWrites.reserve(5);
 
 			// camera ubo
 			{
-				VkDescriptorBufferInfo cameraUBOInfo = {};
 				cameraUBOInfo.buffer = mRenderer->GetCameraDataRef().buffers[i];
 				cameraUBOInfo.offset = 0;
 				cameraUBOInfo.range = sizeof(CameraBuffer);
 
 				VkWriteDescriptorSet cameraUBODesc = {};
 				cameraUBODesc.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-				cameraUBODesc.dstSet = mDescriptorSets[i];
+				cameraUBODesc.dstSet = sets[i];
 				cameraUBODesc.dstBinding = 0;
 				cameraUBODesc.dstArrayElement = 0;
 				cameraUBODesc.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
@@ -1203,14 +2358,13 @@ namespace Cosmos::Vulkan
 
 			// window ubo
 			{
-				VkDescriptorBufferInfo windowUBOInfo = {};
 				windowUBOInfo.buffer = mRenderer->GetWindowDataRef().buffers[i];
 				windowUBOInfo.offset = 0;
 				windowUBOInfo.range = sizeof(WindowBuffer);
 
 				VkWriteDescriptorSet windowUBODesc = {};
 				windowUBODesc.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-				windowUBODesc.dstSet = mDescriptorSets[i];
+				windowUBODesc.dstSet = sets[i];
 				windowUBODesc.dstBinding = 1;
 				windowUBODesc.dstArrayElement = 0;
 				windowUBODesc.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
@@ -1221,14 +2375,13 @@ namespace Cosmos::Vulkan
 
 			// storage ubo
 			{
-				VkDescriptorBufferInfo storageBufferInfo = {};
 				storageBufferInfo.buffer = mRenderer->GetPickingDataRef().buffers[i];
 				storageBufferInfo.offset = 0;
 				storageBufferInfo.range = sizeof(PickingDepthBuffer);
 
 				VkWriteDescriptorSet storageDesc = {};
 				storageDesc.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-				storageDesc.dstSet = mDescriptorSets[i];
+				storageDesc.dstSet = sets[i];
 				storageDesc.dstBinding = 2;
 				storageDesc.dstArrayElement = 0;
 				storageDesc.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
@@ -1239,14 +2392,13 @@ namespace Cosmos::Vulkan
 
 			// color map
 			{
-				VkDescriptorImageInfo colorMapInfo = {};
 				colorMapInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-				colorMapInfo.imageView = (VkImageView)mMaterial.colormapTex->GetView();
-				colorMapInfo.sampler = (VkSampler)mMaterial.colormapTex->GetSampler();
+				colorMapInfo.imageView = (VkImageView)colormap->GetView();
+				colorMapInfo.sampler = (VkSampler)colormap->GetSampler();
 
 				VkWriteDescriptorSet colorMapDec = {};
 				colorMapDec.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-				colorMapDec.dstSet = mDescriptorSets[i];
+				colorMapDec.dstSet = sets[i];
 				colorMapDec.dstBinding = 3;
 				colorMapDec.dstArrayElement = 0;
 				colorMapDec.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
@@ -1255,22 +2407,133 @@ namespace Cosmos::Vulkan
 				descriptorWrites.push_back(colorMapDec);
 			}
 
+			// baked animation, only read by the baked pipelines
+			if (mBakedAnimation)
+			{
+				animationInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+				animationInfo.imageView = mBakedAnimation->GetView();
+				animationInfo.sampler = mBakedAnimation->GetSampler();
+
+				VkWriteDescriptorSet animationDesc = {};
+				animationDesc.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+				animationDesc.dstSet = sets[i];
+				animationDesc.dstBinding = 7;
+				animationDesc.dstArrayElement = 0;
+				animationDesc.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+				animationDesc.descriptorCount = 1;
+				animationDesc.pImageInfo = &animationInfo;
+				descriptorWrites.push_back(animationDesc);
+			}
+
 			vkUpdateDescriptorSets(mRenderer->GetDevice()->GetLogicalDevice(), (uint32_t)descriptorWrites.size(), descriptorWrites.data(), 0, nullptr);
 		}
 	}
 
+	VkDescriptorSet VKMesh::GetDescriptorSet(const Instance& instance, uint32_t frame)
+	{
+		std::vector<VkDescriptorSet>* sets = &mDescriptorSets;
+		std::vector<uint32_t>* instanceVersions = &mInstanceVersions;
+
+		if (instance.colormap != nullptr && instance.colormap != mMaterial.colormapTex)
+		{
+			ColormapDescriptors& descriptors = mColormapOverrides[instance.colormap.get()];
+
+			// created on first use, or again if the previous texture at the same address was released
+			if (descriptors.texture.lock() != instance.colormap)
+			{
+				// the last frames may still be using the old sets, they're freed with their pool once those frames are done
+				if (descriptors.pool != VK_NULL_HANDLE)
+				{
+					VkDevice device = mRenderer->GetDevice()->GetLogicalDevice();
+					VkDescriptorPool pool = descriptors.pool;
+					mRenderer->DeferRelease([device, pool]() { vkDestroyDescriptorPool(device, pool, nullptr); });
+
+					descriptors.pool = VK_NULL_HANDLE;
+					descriptors.sets.clear();
+				}
+
+				descriptors.texture = instance.colormap;
+				SetupDescriptors(descriptors.pool, descriptors.sets);
+				UpdateDescriptors(descriptors.sets, instance.colormap);
+				descriptors.instanceVersions.assign(descriptors.sets.size(), 0);
+			}
+
+			sets = &descriptors.sets;
+			instanceVersions = &descriptors.instanceVersions;
+		}
+
+		// the culling and skinning passes recreate the frame's buffers when they grow, only between it's submissions so the set isn't in use
+		// both versions only increase, so does their sum
+		Shared<CullingPass> culling = mRenderer->GetCullingPass();
+		Shared<SkinningPass> skinning = mRenderer->GetSkinningPass();
+		uint32_t version = culling->GetVersion(frame) + skinning->GetVersion(frame);
+
+		if ((*instanceVersions)[frame] != version)
+		{
+			std::array<VkDescriptorBufferInfo, 3> infos = {};
+			infos[0].buffer = culling->GetInstanceBuffer(frame);
+			infos[0].offset = 0;
+			infos[0].range = VK_WHOLE_SIZE;
+			infos[1].buffer = culling->GetVisibleBuffer(frame);
+			infos[1].offset = 0;
+			infos[1].range = VK_WHOLE_SIZE;
+			infos[2].buffer = skinning->GetPaletteBuffer(frame);
+			infos[2].offset = 0;
+			infos[2].range = VK_WHOLE_SIZE;
+
+			// instances, the visible ones and the joint palettes, bindings 4 to 6
+			std::array<VkWriteDescriptorSet, 3> writes = {};
+
+			for (uint32_t i = 0; i < 3; i++)
+			{
+				writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+				writes[i].dstSet = (*sets)[frame];
+				writes[i].dstBinding = 4 + i;
+				writes[i].dstArrayElement = 0;
+				writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+				writes[i].descriptorCount = 1;
+				writes[i].pBufferInfo = &infos[i];
+			}
+
+			vkUpdateDescriptorSets(mRenderer->GetDevice()->GetLogicalDevice(), (uint32_t)writes.size(), writes.data(), 0, nullptr);
+
+			(*instanceVersions)[frame] = version;
+		}
+
+		return (*sets)[frame];
+	}
+
+	void VKMesh::PruneColormapOverrides(bool all)
+	{
+		VkDevice device = mRenderer->GetDevice()->GetLogicalDevice();
+
+		for (auto it = mColormapOverrides.begin(); it != mColormapOverrides.end();)
+		{
+			if (!all && !it->second.texture.expired())
+			{
+				it++;
+				continue;
+			}
+
+			// the last frames may still be using the sets
+			VkDescriptorPool pool = it->second.pool;
+			mRenderer->DeferRelease([device, pool]() { vkDestroyDescriptorPool(device, pool, nullptr); });
+			it = mColormapOverrides.erase(it);
+		}
+	}
+
 	void VKMesh::CalculateMeshDimension()
 	{
-		// calculate binary volume hierarchy for all nodes in the scene
-		for (auto node : mLinearNodes)
+		// children come after their parents, walking backwards every subtree is done before it's root
+		for (size_t i = mLinearNodes.size(); i-- > 0;)
 		{
-			CalculateBoundingBox(node, nullptr);
+			CalculateBoundingBox(mLinearNodes[i]);
 		}
 
 		mDimension.min = glm::vec3(FLT_MAX);
 		mDimension.max = glm::vec3(-FLT_MAX);
 
-		for (auto node : mLinearNodes)
+		for (auto node : mNodes)
 		{
 			if (node->bvh.IsValid())
 			{
@@ -1286,31 +2549,98 @@ namespace Cosmos::Vulkan
 		mDimension.aabb[3][2] = mDimension.min[2];
 	}
 
-	void VKMesh::CalculateBoundingBox(GLTF::Node* node, GLTF::Node* parent)
+	void VKMesh::CalculateSkinnedDimension()
 	{
-		Physics::BoundingBox parentBvh = parent ? parent->bvh : Physics::BoundingBox(mDimension.min, mDimension.max);
+		mCullMin = mDimension.min;
+		mCullMax = mDimension.max;
 
-		if (node->mesh)
+		const uint32_t jointCount = GetJointCount();
+
+		if (jointCount == 0)
+			return;
+
+		// skinned vertices are the bind pose ones, without node transforms
+		Physics::BoundingBox bind = {};
+
+		for (const GLTF::Mesh& mesh : mMeshStorage)
+		{
+			if (!mesh.bb.IsValid())
+				continue;
+
+			bind.SetMin(bind.IsValid() ? glm::min(bind.GetMin(), mesh.bb.GetMin()) : mesh.bb.GetMin());
+			bind.SetMax(bind.IsValid() ? glm::max(bind.GetMax(), mesh.bb.GetMax()) : mesh.bb.GetMax());
+			bind.SetValid(true);
+		}
+
+		if (!bind.IsValid())
+			return;
+
+		// a skinned vertex is a weighted average of it's joints moving it, each of them keeps it inside the bind box moved by the joint
+		// so the boxes of every joint over the rest pose and the sampled clips bound any pose the clips reach
+		struct Bounds { glm::vec3 min = glm::vec3(FLT_MAX); glm::vec3 max = glm::vec3(-FLT_MAX); };
+		std::vector<Bounds> bounds(mAnimations.size() + 1);
+
+		auto addPose = [this, &bind, jointCount](const Pose& pose, std::vector<glm::mat4>& palette, Bounds& result)
 		{
-			if (node->mesh->bb.IsValid())
+			WritePalette(pose, palette.data());
+
+			for (uint32_t j = 0; j < jointCount; j++)
 			{
-				node->aabb = node->mesh->bb.GetAABB(node->GetMatrix());
+				Physics::BoundingBox moved = bind.GetAABB(palette[j]);
+				result.min = glm::min(result.min, moved.GetMin());
+				result.max = glm::max(result.max, moved.GetMax());
+			}
+		};
 
-				if (node->children.size() == 0)
-				{
-					node->bvh.SetMin(node->aabb.GetMin());
-					node->bvh.SetMax(node->aabb.GetMax());
-					node->bvh.SetValid(true);
-				}
+		ThreadPool::GetInstance().ParallelFor((uint32_t)bounds.size(), [&](uint32_t c)
+		{
+			std::vector<glm::mat4> palette(jointCount);
+
+			if (c == mAnimations.size())
+			{
+				addPose(mHierarchy.rest, palette, bounds[c]);
+				return;
+			}
+
+			// sampled as often as the animations are baked by default, joints rarely swing out of the box between the samples
+			Pose pose = {};
+			const float duration = GetAnimationDuration(c);
+			const uint32_t samples = (uint32_t)std::ceil(duration * 30.0f) + 1;
+
+			for (uint32_t f = 0; f < samples; f++)
+			{
+				Animate(c, samples > 1 ? duration * (float)f / (float)(samples - 1) : 0.0f, pose);
+				addPose(pose, palette, bounds[c]);
 			}
+		});
+
+		for (const Bounds& clip : bounds)
+		{
+			mCullMin = glm::min(mCullMin, clip.min);
+			mCullMax = glm::max(mCullMax, clip.max);
 		}
+	}
+
+	void VKMesh::CalculateBoundingBox(GLTF::Node* node)
+	{
+		node->bvh = {};
 
-		parentBvh.SetMin(glm::min(parentBvh.GetMin(), node->bvh.GetMin()));
-		parentBvh.SetMax(glm::min(parentBvh.GetMax(), node->bvh.GetMax()));
+		if (node->mesh && node->mesh->bb.IsValid())
+		{
+			node->aabb = node->mesh->bb.GetAABB(mHierarchy.rest.globals[node->linearIndex]);
+			node->bvh = node->aabb;
+			node->bvh.SetValid(true);
+		}
 
+		// the volume of a node bounds it's whole subtree
 		for (auto& child : node->children)
 		{
-			CalculateBoundingBox(child, node);
+			if (!child->bvh.IsValid())
+				continue;
+
+			node->bvh.SetMin(node->bvh.IsValid() ? glm::min(node->bvh.GetMin(), child->bvh.GetMin()) : child->bvh.GetMin());
+			node->bvh.SetMax(node->bvh.IsValid() ? glm::max(node->bvh.GetMax(), child->bvh.GetMax()) : child->bvh.GetMax());
+			node->bvh.SetValid(true);
 		}
 	}
 }
@@ -1,17 +1,26 @@
 #pragma once
 #if defined COSMOS_RENDERER_VULKAN
 
-// changing this value here also requires changing it in the vertex shader
-#define MAX_NUM_JOINTS 128u
-
 #include "Physics/BoundingBox.h"
+#include "Renderer/AnimationCompressor.h"
 #include "Renderer/Mesh.h"
+#include "Renderer/MeshFormat.h"
+#include "Renderer/MeshOptimizer.h"
 #include "Renderer/Vertex.h"
 #include "Renderer/Texture.h"
+#include "BakedAnimation.h"
 #include "Device.h"
+#include "GeometryHeap.h"
 
+#include "Util/Arena.h"
+#include "Util/MappedFile.h"
+#include "Util/Memory.h"
 #include "Wrapper/tinygltf.h"
 #include <volk.h>
+#include <atomic>
+#include <future>
+#include <type_traits>
+#include <unordered_map>
 
 // forward declarations
 namespace Cosmos::Vulkan { class VKRenderer; }
@@ -21,25 +30,40 @@ namespace Cosmos::Vulkan::GLTF
 	// forward declaration
 	struct Node;
 
+	// a contiguous array on the asset's arena, the elements are released with it
+	template<typename T>
+	struct Range
+	{
+		T* first = nullptr;
+		uint32_t count = 0;
+
+		inline T* begin() const { return first; }
+		inline T* end() const { return first + count; }
+		inline size_t size() const { return count; }
+		inline bool empty() const { return count == 0; }
+		inline T& operator[](size_t index) const { return first[index]; }
+	};
+
 	struct Skin
 	{
-		std::string name;
+		const char* name = "";
 		Node* skeletonRoot = nullptr;
-		std::vector<glm::mat4> inverseBindMatrices;
-		std::vector<Node*> joints;
+		Range<glm::mat4> inverseBindMatrices = {};
+		Range<Node*> joints = {};
 	};
 
 	struct Primitive
 	{
 		uint32_t firstIndex;
 		uint32_t indexCount;
+		uint32_t vertexStart;	// base vertex the indices are relative to
 		uint32_t vertexCount;
 		Cosmos::Mesh::Material& material;
 		bool hasIndices;
 		Physics::BoundingBox bb;
 
 		// constructor
-		Primitive(uint32_t firstIndex, uint32_t indexCount, uint32_t vertexCount, Cosmos::Mesh::Material& material);
+		Primitive(uint32_t firstIndex, uint32_t indexCount, uint32_t vertexStart, uint32_t vertexCount, Cosmos::Mesh::Material& material);
 
 		// sets the bounding box of the primitive
 		void SetBoundingBox(glm::vec3 min, glm::vec3 max);
@@ -47,69 +71,58 @@ namespace Cosmos::Vulkan::GLTF
 
 	struct Mesh
 	{
-		struct UniformBuffer
-		{
-			VkBuffer buffer;
-			VmaAllocation memory;
-			VkDescriptorBufferInfo descriptor;
-			VkDescriptorSet descriptorSet;
-			void* mapped;
-		};
-
-		struct UniformBlock
-		{
-			glm::mat4 matrix = glm::mat4(1.0f);
-			glm::mat4 jointMatrix[MAX_NUM_JOINTS] = {};
-			uint32_t jointcount{ 0 };
-		};
-
-		Shared<Cosmos::Vulkan::Device> device;
-		std::vector<Primitive*> primitives;
+		Range<Primitive> primitives = {};	// consecutive on the asset's primitive storage
 		Physics::BoundingBox bb;
 		Physics::BoundingBox aabb;
-		UniformBuffer uniformBuffer = {};
-		UniformBlock uniformBlock = {};
-
-		// constructor
-		Mesh(Shared<Cosmos::Vulkan::Device> device, glm::mat4 matrix);
-
-		// destructor
-		~Mesh();
 
 		// sets the mesh bounding box
 		void SetBoundingBox(glm::vec3 min, glm::vec3 max);
+
+		// sets the mesh bounding box from the bounding boxes of it's primitives
+		void CalculateBoundingBox();
 	};
 
 	struct Node
 	{
 		Node* parent = nullptr;
 		uint32_t index = 0;
-		std::vector<Node*> children = {};
-		glm::mat4 matrix = glm::mat4(1.0f);
-		std::string name = {};
+		uint32_t linearIndex = 0;				// position on the mesh's flattened hierarchy
+		Range<Node*> children = {};				// sized by the file, filled as the children are created
+		const char* name = "";
 		Mesh* mesh = nullptr;
 		Skin* skin = nullptr;
 		int32_t skinIndex = -1;
-		glm::vec3 translation = glm::vec3(1.0f);
-		glm::vec3 scale = glm::vec3(1.0f);
-		glm::quat rotation = {};
 		Physics::BoundingBox bvh = {};
 		Physics::BoundingBox aabb = {};
 
-		// constructor
-		Node() = default;
+		// pose the node was loaded with, the hierarchy is posed from then on
+		glm::mat4 matrix = glm::mat4(1.0f);
+		glm::vec3 translation = glm::vec3(0.0f);
+		glm::vec3 scale = glm::vec3(1.0f);
+		glm::quat rotation = {};
+	};
 
-		// destructor
-		~Node();
+	// the asset's arena is released without running destructors
+	static_assert(std::is_trivially_destructible_v<Skin> && std::is_trivially_destructible_v<Primitive>, "Asset storage must be trivially destructible");
+	static_assert(std::is_trivially_destructible_v<Mesh> && std::is_trivially_destructible_v<Node>, "Asset storage must be trivially destructible");
 
-		// calculate the node root matrix
-		glm::mat4 GetLocalMatrix();
+	// nodes flattened in depth-first order, parents come before their children and every subtree is contiguous
+	// the local transforms of a pose are kept per component so it's global matrices are computed in a single forward pass
+	struct Hierarchy
+	{
+		std::vector<int32_t> parents = {};		// -1 for root nodes
+		std::vector<uint32_t> subtreeEnds = {};	// one past the last node of every node's subtree
+		std::vector<glm::mat4> matrices = {};	// applied after the translation, rotation and scale
+		Cosmos::Mesh::Pose rest = {};			// pose the nodes were loaded with
+
+		// creates the hierarchy from the root nodes, listing every node depth-first into linearNodes
+		void Build(const std::vector<Node*>& roots, std::vector<Node*>& linearNodes);
 
-		// returns the node matrix, accounting it's leafs
-		glm::mat4 GetMatrix();
+		// computes the global matrices of a pose's nodes from first to end, the parents of first must be up to date
+		void UpdateGlobals(Cosmos::Mesh::Pose& pose, uint32_t first, uint32_t end) const;
 
-		// updates the node position
-		void OnUpdate();
+		// releases the transforms
+		void Clear();
 	};
 
 	struct Animation
@@ -127,25 +140,36 @@ namespace Cosmos::Vulkan::GLTF
 			enum InterpolationType { LINEAR, STEP, CUBICSPLINE };
 			InterpolationType interpolation;
 			std::vector<float> inputs;
-			std::vector<glm::vec4> outputsVec4;
-			std::vector<float> outputs;
+			AnimationCompressor::Track track;	// linear and step keys, reduced and quantized on import
+			std::vector<float> outputs;			// cubic-spline tangents and values, kept at full precision
+			uint32_t components = 0;			// floats per value, 3 or 4
+
+			// returns how many keys the sampler has
+			inline size_t GetKeyCount() const { return interpolation == CUBICSPLINE ? (components > 0 ? outputs.size() / (3 * components) : 0) : track.GetKeyCount(); }
+
+			// returns the bytes it's keys use
+			inline size_t GetSize() const { return inputs.size() * sizeof(float) + outputs.size() * sizeof(float) + track.GetSize(); }
 
 			// calculates the cubic-spline interpolation
-			glm::vec4 CubicSplineInterpolation(size_t index, float time, uint32_t stride);
+			glm::vec4 CubicSplineInterpolation(size_t index, float time, uint32_t stride) const;
+
+			// returns the keyframe interval containing time, the cursor is the last one found and only a seek searches for it
+			size_t FindKeyframe(float time, uint32_t& cursor) const;
 
-			// translates the node
-			void Translate(size_t index, float time, Node* node);
+			// samples a translation
+			void Translate(size_t index, float time, glm::vec3& translation) const;
 
-			// scales the node
-			void Scale(size_t index, float time, Node* node);
+			// samples a scale
+			void Scale(size_t index, float time, glm::vec3& scale) const;
 
-			// rotates the node
-			void Rotate(size_t index, float time, Node* node);
+			// samples a rotation
+			void Rotate(size_t index, float time, glm::quat& rotation) const;
 		};
 
 		std::string name;
 		std::vector<Channel> channels;
 		std::vector<Sampler> samplers;
+		std::vector<Node*> roots;	// topmost nodes of the subtrees it changes
 		float start = std::numeric_limits<float>::max();
 		float end = std::numeric_limits<float>::min();
 	};
@@ -157,12 +181,65 @@ namespace Cosmos::Vulkan
 	{
 	public:
 
+		// where a primitive's data was decoded into, listed in the order the nodes are loaded
+		struct PrimitiveInfo
+		{
+			const tinygltf::Primitive* primitive = nullptr;
+			uint32_t vertexStart = 0;
+			uint32_t indexStart = 0;
+			uint32_t vertexCount = 0;
+			uint32_t indexCount = 0;
+			glm::vec3 min = {};
+			glm::vec3 max = {};
+			const char* error = nullptr;
+			MeshOptimizer::Statistics statistics = {};
+		};
+
+		// a load in progress, the file is parsed and decoded by the workers and finished on the main thread
 		struct LoaderInfo
 		{
-			uint32_t* indexBuffer;
-			Vertex* vertexBuffer;
-			size_t indexPos = 0;
-			size_t vertexPos = 0;
+			enum State : uint8_t
+			{
+				Decoding = 0,	// a worker is parsing and decoding the file
+				Decoded,		// buffers are ready to be uploaded
+				Uploading,		// the copy was submitted, waiting for it's fence
+				Failed			// the file could not be loaded
+			};
+
+			std::atomic<State> state = State::Decoding;
+			std::atomic<bool> cancelled = false;	// the mesh no longer wants the result, the worker stops early
+			std::future<void> task = {};
+			std::string filepath = {};
+			std::string error = {};					// workers don't log, messages are logged by the main thread
+			std::string warning = {};
+			float scale = 1.0f;
+			tinygltf::Model model = {};
+			std::vector<PrimitiveInfo> primitives = {};
+			size_t primitivePos = 0;
+			std::vector<Vertex> vertices = {};
+			std::vector<uint32_t> indices = {};
+			MeshOptimizer::Statistics statistics = {};	// of every optimized primitive
+			VertexLayout layout = VertexLayout::Full;
+			std::vector<uint8_t> packedVertices = {};	// vertices on the chosen layout, empty for the full layout
+			VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+			std::vector<uint16_t> shortIndices = {};	// indices narrowed to 16 bits, empty for 32 bit indices
+			Unique<MappedFile> file = {};			// cooked meshes are uploaded straight from the mapped file
+
+			// streams to upload, either the decoded vectors or the mapped file
+			const void* vertexData = nullptr;
+			size_t vertexBytes = 0;
+			const void* indexData = nullptr;
+			size_t indexBytes = 0;
+
+			// staging buffers are filled by the worker, the geometry heap ranges are allocated by the main thread
+			VkBuffer vertexStaging = VK_NULL_HANDLE;
+			VmaAllocation vertexStagingMemory = VK_NULL_HANDLE;
+			VkBuffer indexStaging = VK_NULL_HANDLE;
+			VmaAllocation indexStagingMemory = VK_NULL_HANDLE;
+
+			// copy submission, polled every update
+			VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+			VkFence fence = VK_NULL_HANDLE;
 		};
 
 	public:
@@ -176,29 +253,38 @@ namespace Cosmos::Vulkan
 		// returns the mesh file name
 		virtual inline std::string GetFilepath() const override { return mFilepath; }
 	
-		// returns if the mesh is fully loaded
+		// returns if the mesh is fully loaded, meshes are loaded asynchronously and only flip once uploaded
 		virtual inline bool IsLoaded() const override { return mLoaded; }
 	
-		// sets the render mode to wiredframe/fill
-		virtual bool* GetWiredframe() override { return &mWiredframe; }
-		
-		// returns the vector of vertices of the mesh
-		virtual std::vector<Vertex> GetVertices() const override { return mVertices; }
+		// returns a view of the vertices, gltf meshes are viewed on the full layout and cooked ones straight from the mapped file
+		virtual VertexView GetVertexView() override;
+
+		// returns the residency policy of the cpu copy of the vertices
+		virtual inline Residency GetResidency() const override { return mResidency; }
+
+		// modifies the residency policy, released and on-demand meshes drop their copy at once
+		virtual void SetResidency(Residency residency) override;
+
+		// drops the cpu copy of the vertices until they're viewed again, resident meshes and on-demand gltf ones keep theirs
+		virtual void ReleaseVertices() override;
 
 	public:
 	
 		// updates the mesh logic
 		virtual void OnUpdate(float timestep) override;
 	
-		// draws the mesh
-		virtual void OnRender(void* commandBuffer, glm::mat4& transform, uint32_t id) override;
+		// draws the instances sharing a state as one batch, the culling pass decides which of them are drawn
+		virtual void OnRender(void* commandBuffer, uint32_t firstInstance, uint32_t instanceCount, const Instance& instance) override;
 	
-		// loads the model from a filepath
+		// starts loading the model from a filepath (.gltf, .glb or .cmesh) on the workers, it's finished by OnUpdate
 		virtual void LoadFromFile(std::string filepath, float scale = 1.0f) override;
 
-		// returns the mesh dimension
+		// returns the mesh dimension, a placeholder around the origin while loading
 		virtual Dimension GetDimension() const override;
 
+		// returns the bounds instances are culled against, the mesh dimension until they're calculated
+		virtual Dimension GetCullingDimension() const override;
+
 	public:
 
 		// modifies the mesh material's colormap
@@ -207,19 +293,106 @@ namespace Cosmos::Vulkan
 		// returns the colormap texture used by the material's mesh
 		virtual Shared<Texture2D> GetColormapTexture() override;
 
+	public: // animations
+
+		// returns how many animation clips the mesh has
+		virtual inline uint32_t GetAnimationCount() const override { return (uint32_t)mAnimations.size(); }
+
+		// returns the length of a clip in seconds
+		virtual float GetAnimationDuration(uint32_t clip) const override;
+
+		// evaluates a clip's time into a pose, only the subtrees the clip animates are updated
+		virtual void Animate(uint32_t clip, float time, Pose& pose) const override;
+
+		// interpolates two poses of the mesh into a third one, weight zero is from and one is to
+		virtual void BlendPoses(const Pose& from, const Pose& to, float weight, Pose& result) const override;
+
+		// returns how many matrices the joint palette of the mesh has, the joints of it's first skin
+		virtual inline uint32_t GetJointCount() const override { return mPaletteSkin ? (uint32_t)mPaletteSkin->joints.size() : 0; }
+
+		// writes the skinning matrices of a pose, the rest pose is used if the pose wasn't evaluated
+		virtual void WritePalette(const Pose& pose, glm::mat4* palette) const override;
+
+	public: // baked animations
+
+		// bakes the joint palettes of every clip, each clip is evaluated in parallel from it's own pose
+		virtual bool BakeAnimations(std::string destination, float framerate = 30.0f) const override;
+
+		// loads baked animations replacing the current ones, the descriptor sets are written again
+		virtual bool LoadBakedAnimations(std::string filepath) override;
+
+		// returns if the mesh is drawn with baked animations
+		virtual inline bool HasBakedAnimations() const override { return mBakedAnimation != nullptr; }
+
+		// returns the frame a clip's time is drawn with, the animation texture row plus the blend to the next one
+		virtual float GetBakedFrame(uint32_t clip, float time) const override;
+
+	public:
+
+		// cooks a gltf/glb file into the engine mesh format, animations and skins are not cooked
+		static bool Cook(std::string source, std::string destination);
+
 	private: // gltf related
 
-		// updates an animation
-		void UpdateAnimation(uint32_t index, float time);
+		// finds the nodes an animation must update after evaluating it's channels
+		void CollectAnimatedNodes(GLTF::Animation& animation);
 
-		// draws a node, including it's children if any
-		void DrawNode(GLTF::Node* node, VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout);
+		// collects the draws of a node's primitives
+		void DrawNode(GLTF::Node* node, FrameVector<VkDrawIndexedIndirectCommand>& commands, uint32_t indexBase, int32_t vertexBase, uint32_t firstInstance);
 		
+		// decodes a file and creates it's buffers, runs on a worker
+		static void DecodeFile(Shared<Device> device, LoaderInfo& loaderInfo);
+
+		// parses a gltf/glb file and decodes it's primitives
+		static bool ParseFile(LoaderInfo& loaderInfo);
+
+		// maps a cooked file and validates it's header
+		static bool MapCookedFile(LoaderInfo& loaderInfo);
+
+		// appends a gltf node and it's children to the cooked node table
+		static void CookNode(const tinygltf::Model& model, int32_t nodeIndex, int32_t parent, LoaderInfo& loaderInfo, std::vector<MeshFormat::Node>& nodes, std::vector<MeshFormat::Primitive>& primitives);
+
+		// decodes the vertices and indices of a primitive, independent primitives are decoded in parallel
+		static void DecodePrimitive(const tinygltf::Model& model, PrimitiveInfo& info, LoaderInfo& loaderInfo);
+
+		// welds the vertices of a decoded primitive and reorders it for the vertex cache, overdraw and vertex fetch
+		static void OptimizePrimitive(PrimitiveInfo& info, LoaderInfo& loaderInfo);
+
+		// creates the gltf hierarchy from a decoded file and submits it's upload
+		void FinishDecoding();
+
+		// checks if the upload finished, making the mesh available
+		void FinishUploading();
+
+		// releases the resources of a load in progress, waiting for it's worker
+		void ReleaseLoader();
+
+		// releases every resource of the loaded model
+		void ReleaseModel();
+
+		// maps the cooked file of the loaded model again, it's vertices must match the uploaded ones
+		void PageInVertices();
+
+		// creates the node hierarchy from the node table of a cooked file
+		void LoadCookedNodes();
+
 		// loads a gltf node
 		void LoadNode(GLTF::Node* parent, const tinygltf::Node& node, uint32_t nodeIndex, const tinygltf::Model& model, LoaderInfo& loaderInfo, float globalscale = 1.0f);
 
-		// returns usefull node properties
-		void GetNodeProperties(const tinygltf::Node& node, const tinygltf::Model& model, size_t& vertexCount, size_t& indexCount);
+		// lists the primitives of a node and it's children, in the order they're loaded, counting their vertices and indices
+		static void GetNodeProperties(const tinygltf::Node& node, const tinygltf::Model& model, std::vector<PrimitiveInfo>& primitives, size_t& vertexCount, size_t& indexCount);
+
+		// sizes the asset's arena from the file, so the node storage is allocated at once
+		void CreateStorage(const tinygltf::Model* model, const MeshFormat::Header* header);
+
+		// returns a new node on the node storage linked to it's parent, it's children array is taken from the arena
+		GLTF::Node* CreateNode(GLTF::Node* parent, uint32_t index, const char* name, size_t nameLength, uint32_t childCount);
+
+		// returns a new mesh with room for a count of primitives, created consecutively on the primitive storage
+		GLTF::Mesh* CreateMesh(uint32_t primitiveCount);
+
+		// returns a copy of a string on the arena
+		const char* CopyString(const char* source, size_t length);
 
 		// load any material the mesh may have
 		void LoadMaterials(tinygltf::Model& model);
@@ -230,30 +403,39 @@ namespace Cosmos::Vulkan
 		// load mesh skins 
 		void LoadSkins(tinygltf::Model& gltfModel);
 
-		// returns a given node based on it's parent
-		GLTF::Node* GetNode(GLTF::Node* parent, uint32_t index);
-
-		// returns a given node based on it's index
-		GLTF::Node* GetNodeFromIndex(uint32_t index);
+		// returns the node created from a gltf node index, nullptr if it's not part of the scene
+		GLTF::Node* GetNodeFromIndex(int32_t index);
 
 	public: // renderer related
 
-		// creates all renderer resources used by the mesh
-		void CreateRendererResources(size_t vertexCount, size_t indexCount, LoaderInfo& loaderInfo);
+		// creates and fills the staging buffers, runs on a worker
+		static void CreateRendererResources(Shared<Device> device, LoaderInfo& loaderInfo);
 
-		// creates the uniform buffers and setup descriptors
-		void SetupDescriptors();
+		// allocates the mesh ranges on the geometry heap, records and submits the copy from the staging buffers, without waiting for it
+		void SubmitUpload();
+
+		// creates a descriptor pool and it's descriptor sets, one per frame
+		void SetupDescriptors(VkDescriptorPool& pool, std::vector<VkDescriptorSet>& sets);
 		
-		// updates the descriptor sets
-		void UpdateDescriptors();
+		// updates the descriptor sets with a colormap
+		void UpdateDescriptors(const std::vector<VkDescriptorSet>& sets, Shared<Texture2D> colormap);
+
+		// returns the descriptor set an instance is drawn with on a frame, creating them for colormap overrides
+		VkDescriptorSet GetDescriptorSet(const Instance& instance, uint32_t frame);
+
+		// releases the descriptor sets of overrides whose texture is no longer used
+		void PruneColormapOverrides(bool all);
 
 	public: // size related
 
 		// calculates the initial mesh dimension
 		void CalculateMeshDimension();
 
-		// calculates the bounding box of a node
-		void CalculateBoundingBox(GLTF::Node* node, GLTF::Node* parent);
+		// calculates the bounds skinned instances are culled with, every sampled pose of every clip fits in them
+		void CalculateSkinnedDimension();
+
+		// calculates the bounding box of a node, it's children must be calculated first
+		void CalculateBoundingBox(GLTF::Node* node);
 
 	private:
 
@@ -261,28 +443,54 @@ namespace Cosmos::Vulkan
 		std::string mFilepath = {};
 		bool mPicked = false;
 		bool mLoaded = false;
-		bool mWiredframe = false;
 		Dimension mDimension;
+		glm::vec3 mCullMin = glm::vec3(FLT_MAX);	// bounds instances are culled against, skinned meshes inflate them over their clips
+		glm::vec3 mCullMax = glm::vec3(-FLT_MAX);
 		
-		// mesh properties
+		// mesh properties, cooked meshes keep their file mapped instead, only while the residency policy wants them
 		std::vector<Vertex> mVertices = {};
+		Unique<MappedFile> mMappedFile = {};
+		Residency mResidency = Residency::OnDemand;
+		VertexLayout mVertexLayout = VertexLayout::Full;
 
-		// gpu data
-		VkBuffer mVertexBuffer = VK_NULL_HANDLE;
-		VmaAllocation mVertexMemory = VK_NULL_HANDLE;
-		int mIndicesCount = 0;
-		VkBuffer mIndexBuffer = VK_NULL_HANDLE;
-		VmaAllocation mIndexMemory = VK_NULL_HANDLE;
+		// gpu data, ranges of the renderer's geometry heap
+		GeometryHeap::Handle mVertexRange = GeometryHeap::InvalidHandle;
+		GeometryHeap::Handle mIndexRange = GeometryHeap::InvalidHandle;
+		uint32_t mVertexCount = 0;
+		VkIndexType mIndexType = VK_INDEX_TYPE_UINT32;
 
 		VkDescriptorPool mDescriptorPool = VK_NULL_HANDLE;
 		std::vector<VkDescriptorSet> mDescriptorSets = {};
+		std::vector<uint32_t> mInstanceVersions = {};	// of the instance buffer each set was written with
+
+		// descriptor sets of colormap overrides, shared by every instance overriding with the same texture
+		struct ColormapDescriptors
+		{
+			std::weak_ptr<Texture2D> texture;
+			VkDescriptorPool pool = VK_NULL_HANDLE;
+			std::vector<VkDescriptorSet> sets = {};
+			std::vector<uint32_t> instanceVersions = {};
+		};
+
+		std::unordered_map<Texture2D*, ColormapDescriptors> mColormapOverrides = {};
+
+		// load in progress
+		Unique<LoaderInfo> mLoader = {};
 
-		// mesh data
+		// mesh data, the nodes, meshes, primitives and skins are contiguous arrays on a per-asset arena
 		Material mMaterial;
+		Unique<LinearArena> mArena = {};
+		GLTF::Range<GLTF::Node> mNodeStorage = {};
+		GLTF::Range<GLTF::Mesh> mMeshStorage = {};
+		GLTF::Range<GLTF::Primitive> mPrimitiveStorage = {};
+		GLTF::Range<GLTF::Node*> mNodeLookup = {};		// node of every gltf node index, gltf files only
 		std::vector<GLTF::Node*> mNodes = {};
-		std::vector<GLTF::Node*> mLinearNodes = {};
-		std::vector<GLTF::Skin*> mSkins;
+		std::vector<GLTF::Node*> mLinearNodes = {};	// listed depth-first, the same order as the hierarchy
+		GLTF::Hierarchy mHierarchy = {};
+		GLTF::Range<GLTF::Skin> mSkins = {};
+		GLTF::Skin* mPaletteSkin = nullptr;		// skin of the first skinned node, the vertices index it's joints
 		std::vector<GLTF::Animation> mAnimations;
+		Unique<BakedAnimation> mBakedAnimation = {};	// a sibling .cvat file is loaded with the mesh
 	};
 }
 
@@ -4,9 +4,12 @@
 #include "VKRenderer.h"
 
 #include "Instance.h"
+#include "CullingPass.h"
 #include "Device.h"
+#include "GeometryHeap.h"
 #include "Renderpass.h"
 #include "Shader.h"
+#include "SkinningPass.h"
 #include "Swapchain.h"
 #include "Pipeline.h"
 #include "VKUI.h"
@@ -17,9 +20,11 @@
 #include "Core/Scene.h"
 #include "Entity/Unique/Camera.h"
 #include "Platform/Window.h"
+#include "Util/Arena.h"
 #include "Util/Files.h"
 #include "Util/Logger.h"
 
+#include <algorithm>
 #include <array>
 
 namespace Cosmos::Vulkan
@@ -27,17 +32,30 @@ namespace Cosmos::Vulkan
 	VKRenderer::VKRenderer(Cosmos::Application* application, Shared<Cosmos::Window> window)
 		: Renderer(application, window)
 	{
+		// frame temporaries are double-buffered along with the frames in flight
+		FrameArena::Specification arenaSpecification = {};
+		arenaSpecification.framesInFlight = mConcurrentlyRenderedFrames;
+		FrameArena::GetInstance().Initialize(arenaSpecification);
+
 		mInstance = CreateShared<Vulkan::Instance>(mWindow, "Cosmos", "Application", true);
 		mDevice = CreateShared<Vulkan::Device>(mWindow, mInstance);
 		mRenderpassManager = CreateShared<Vulkan::RenderpassManager>(mDevice);
 		mSwapchain = CreateShared<Vulkan::Swapchain>(mWindow, mDevice, mRenderpassManager, mConcurrentlyRenderedFrames);
 		mPipelineLibrary = CreateShared<Vulkan::PipelineLibrary>(mDevice, mRenderpassManager);
+		mGeometryHeap = CreateShared<Vulkan::GeometryHeap>(mDevice, mRenderpassManager);
+		mCullingPass = CreateShared<Vulkan::CullingPass>(mDevice, mConcurrentlyRenderedFrames);
+		mSkinningPass = CreateShared<Vulkan::SkinningPass>(mDevice, mConcurrentlyRenderedFrames);
+		mFrameSerials.assign(mConcurrentlyRenderedFrames, 0);
 
 		CreateGlobalResoruces();
 	}
 
 	VKRenderer::~VKRenderer()
 	{
+		// whatever was still waiting on a frame is released before the heap and device go away
+		vkDeviceWaitIdle(mDevice->GetLogicalDevice());
+		RunDeferredReleases(true);
+
 		for (size_t i = 0; i < mConcurrentlyRenderedFrames; i++)
 		{
 			// camera data
@@ -61,6 +79,14 @@ namespace Cosmos::Vulkan
 
 		// aquire image from swapchain
 		vkWaitForFences(mDevice->GetLogicalDevice(), 1, &mSwapchain->GetInFlightFencesRef()[mCurrentFrame], VK_TRUE, UINT64_MAX);
+
+		// a fence signals after every earlier submission on the queue, so the frames up to this one are done
+		mCompletedFrames = std::max(mCompletedFrames, mFrameSerials[mCurrentFrame]);
+		RunDeferredReleases(false);
+
+		// the gpu is done with this frame, it's temporaries can be reused
+		FrameArena::GetInstance().BeginFrame(mCurrentFrame);
+
 		VkResult res = vkAcquireNextImageKHR(mDevice->GetLogicalDevice(), mSwapchain->GetSwapchain(), UINT64_MAX, mSwapchain->GetAvailableSemaphoresRef()[mCurrentFrame], VK_NULL_HANDLE, &mImageIndex);
 
 		if (res == VK_ERROR_OUT_OF_DATE_KHR)
@@ -79,15 +105,32 @@ namespace Cosmos::Vulkan
 		// send global data, like buffers into the renderer
 		SendGlobalResources();
 
+		// releases relocated geometry buffers and compacts the fragmented ones before any draw is recorded
+		mGeometryHeap->OnUpdate();
+
 		// register draw calls based on the configuration of previously configured renderpasses
 		ManageRenderpasses();
 
-		// submits the draw calls into the graphics queue, we're not using any compute queue at the momment
+		// culls the instances drawn by the recorded batches on the compute queue, the indirect draws wait for it
+		VkSemaphore cullingSemaphore = mCullingPass->Submit(mCamera->GetProjectionRef() * mCamera->GetViewRef());
+
+		// submits the draw calls into the graphics queue
 		VkSwapchainKHR swapChains[] = { mSwapchain->GetSwapchain() };
-		VkSemaphore waitSemaphores[] = { mSwapchain->GetAvailableSemaphoresRef()[mCurrentFrame] };
+		VkSemaphore waitSemaphores[] = { mSwapchain->GetAvailableSemaphoresRef()[mCurrentFrame], cullingSemaphore };
 		VkSemaphore signalSemaphores[] = { mSwapchain->GetFinishedSempahoresRef()[mCurrentFrame] };
-		VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-		std::vector<VkCommandBuffer> submitCommandBuffers = { mRenderpassManager->GetRenderpassesRef()["Swapchain"]->GetSpecificationRef().commandBuffers[mCurrentFrame] };
+		VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT };
+		FrameVector<VkCommandBuffer> submitCommandBuffers = {};
+		submitCommandBuffers.reserve(4);
+
+		// skins the instances drawn as static vertices, it's barrier orders it before the draws of the command buffers after it
+		VkCommandBuffer skinningCommandBuffer = mSkinningPass->Record(mGeometryHeap->GetBuffer(GeometryHeap::SkinnedVertices), mCullingPass->GetInstanceBuffer(mCurrentFrame));
+
+		if (skinningCommandBuffer != VK_NULL_HANDLE)
+		{
+			submitCommandBuffers.push_back(skinningCommandBuffer);
+		}
+
+		submitCommandBuffers.push_back(mRenderpassManager->GetRenderpassesRef()["Swapchain"]->GetSpecificationRef().commandBuffers[mCurrentFrame]);
 
 		if (mRenderpassManager->Exists("Viewport"))
 		{
@@ -102,7 +145,7 @@ namespace Cosmos::Vulkan
 		VkSubmitInfo submitInfo = {};
 		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 		submitInfo.pNext = nullptr;
-		submitInfo.waitSemaphoreCount = 1;
+		submitInfo.waitSemaphoreCount = cullingSemaphore != VK_NULL_HANDLE ? 2 : 1;
 		submitInfo.pWaitSemaphores = waitSemaphores;
 		submitInfo.pWaitDstStageMask = waitStages;
 		submitInfo.commandBufferCount = (uint32_t)submitCommandBuffers.size();
@@ -110,6 +153,7 @@ namespace Cosmos::Vulkan
 		submitInfo.signalSemaphoreCount = 1;
 		submitInfo.pSignalSemaphores = signalSemaphores;
 		COSMOS_ASSERT(vkQueueSubmit(mDevice->GetGraphicsQueue(), 1, &submitInfo, mSwapchain->GetInFlightFencesRef()[mCurrentFrame]) == VK_SUCCESS, "Failed to submit draw command");
+		mFrameSerials[mCurrentFrame] = ++mSubmittedFrames;
 
 		// presents the image
 		VkPresentInfoKHR presentInfo = {};
@@ -147,6 +191,65 @@ namespace Cosmos::Vulkan
 		Renderer::OnEvent(event);
 	}
 
+	InstanceData* VKRenderer::ReserveInstances(uint32_t count)
+	{
+		return mCullingPass->BeginFrame(mCurrentFrame, count);
+	}
+
+	glm::mat4* VKRenderer::ReservePalettes(uint32_t count)
+	{
+		return mSkinningPass->BeginFrame(mCurrentFrame, count);
+	}
+
+	bool VKRenderer::IsComputeSkinning() const
+	{
+		return mSkinningPass->IsComputeSkinning();
+	}
+
+	void VKRenderer::SetComputeSkinning(bool value)
+	{
+		mSkinningPass->SetComputeSkinning(value);
+	}
+
+	void VKRenderer::DeferRelease(std::function<void()> release)
+	{
+		// the frame being recorded may already reference the resources
+		mDeferredReleases.push_back({ mSubmittedFrames + 1, release });
+	}
+
+	void VKRenderer::RunDeferredReleases(bool all)
+	{
+		// a release may defer others, like the last reference of a texture, so the ready ones are taken out first
+		do
+		{
+			std::vector<DeferredRelease> ready = {};
+
+			for (size_t i = 0; i < mDeferredReleases.size();)
+			{
+				if (!all && mDeferredReleases[i].frame > mCompletedFrames)
+				{
+					i++;
+					continue;
+				}
+
+				ready.push_back(std::move(mDeferredReleases[i]));
+
+				if (i + 1 < mDeferredReleases.size())
+				{
+					mDeferredReleases[i] = std::move(mDeferredReleases.back());
+				}
+
+				mDeferredReleases.pop_back();
+			}
+
+			for (DeferredRelease& deferred : ready)
+			{
+				deferred.release();
+			}
+
+		} while (all && !mDeferredReleases.empty());
+	}
+
 	void VKRenderer::ManageRenderpasses()
 	{
 		std::array<VkClearValue, 2> clearValues = {};
@@ -5,6 +5,7 @@
 #include <volk.h>
 #include "Wrapper/vma.h" // including vma after volk
 
+#include <functional>
 #include <vector>
 
 // forward declarations
@@ -17,10 +18,13 @@ namespace Cosmos::Vulkan
 {
 	// forward declarations
 	class Application;
+	class CullingPass;
 	class Device;
+	class GeometryHeap;
 	class Instance;
 	class PipelineLibrary;
 	class RenderpassManager;
+	class SkinningPass;
 	class Swapchain;
 
 	class VKRenderer : public Renderer
@@ -48,6 +52,15 @@ namespace Cosmos::Vulkan
 		// returns a smart-ptr to the vulkan pipeline library
 		inline Shared<Vulkan::PipelineLibrary> GetPipelineLibrary() { return mPipelineLibrary; }
 
+		// returns a smart-ptr to the geometry heap every mesh is allocated from
+		inline Shared<Vulkan::GeometryHeap> GetGeometryHeap() { return mGeometryHeap; }
+
+		// returns a smart-ptr to the culling pass owning the instance data
+		inline Shared<Vulkan::CullingPass> GetCullingPass() { return mCullingPass; }
+
+		// returns a smart-ptr to the skinning pass owning the joint palettes
+		inline Shared<Vulkan::SkinningPass> GetSkinningPass() { return mSkinningPass; }
+
 	public:
 
 		// updates the renderer
@@ -56,6 +69,21 @@ namespace Cosmos::Vulkan
 		// event handling
 		virtual void OnEvent(Shared<Event> event) override;
 
+		// returns the current frame's instance data with room for count instances, they're culled before being drawn
+		virtual InstanceData* ReserveInstances(uint32_t count) override;
+
+		// returns the current frame's joint palettes with room for count matrices, growing it's buffer if needed
+		virtual glm::mat4* ReservePalettes(uint32_t count) override;
+
+		// returns if skinned meshes are skinned once per frame by a compute pre-pass
+		virtual bool IsComputeSkinning() const override;
+
+		// skins skinned meshes by a compute pre-pass and draws them as static ones, otherwise every vertex shader skins them
+		virtual void SetComputeSkinning(bool value) override;
+
+		// releases resources once the frames recorded until now are done on the gpu, instead of waiting for the device to be idle
+		void DeferRelease(std::function<void()> release);
+
 	private:
 
 		// organize the render passes order into the draw command
@@ -67,6 +95,9 @@ namespace Cosmos::Vulkan
 		// create globally used resources
 		void CreateGlobalResoruces();
 
+		// runs the deferred releases whose frames the in-flight fences tell are done, or all of them
+		void RunDeferredReleases(bool all);
+
 	private:
 
 		Shared<Instance> mInstance;
@@ -74,6 +105,20 @@ namespace Cosmos::Vulkan
 		Shared<RenderpassManager> mRenderpassManager;
 		Shared<Swapchain> mSwapchain;
 		Shared<PipelineLibrary> mPipelineLibrary;
+		Shared<GeometryHeap> mGeometryHeap;
+		Shared<CullingPass> mCullingPass;
+		Shared<SkinningPass> mSkinningPass;
+
+		struct DeferredRelease
+		{
+			uint64_t frame = 0;		// last frame that may use the resources
+			std::function<void()> release = {};
+		};
+
+		std::vector<DeferredRelease> mDeferredReleases = {};
+		std::vector<uint64_t> mFrameSerials = {};	// frame submitted on every frame in flight, done once it's fence signaled
+		uint64_t mSubmittedFrames = 0;
+		uint64_t mCompletedFrames = 0;
 		
 		struct GPUBufferData
 		{
@@ -52,12 +52,21 @@ namespace Cosmos::Vulkan
 
 	VKTexture2D::~VKTexture2D()
 	{
-		vkDeviceWaitIdle(mRenderer->GetDevice()->GetLogicalDevice());
-
-		vkDestroyImageView(mRenderer->GetDevice()->GetLogicalDevice(), mView, nullptr);
-		vkDestroyImage(mRenderer->GetDevice()->GetLogicalDevice(), mImage, nullptr);
-		vmaFreeMemory(mRenderer->GetDevice()->GetAllocator(), mMemory);
-		vkDestroySampler(mRenderer->GetDevice()->GetLogicalDevice(), mSampler, nullptr);
+		// the last frames may still sample the texture, it's released once they're done
+		VkDevice device = mRenderer->GetDevice()->GetLogicalDevice();
+		VmaAllocator allocator = mRenderer->GetDevice()->GetAllocator();
+		VkImageView view = mView;
+		VkImage image = mImage;
+		VmaAllocation memory = mMemory;
+		VkSampler sampler = mSampler;
+
+		mRenderer->DeferRelease([device, allocator, view, image, memory, sampler]()
+			{
+				vkDestroyImageView(device, view, nullptr);
+				vkDestroyImage(device, image, nullptr);
+				vmaFreeMemory(allocator, memory);
+				vkDestroySampler(device, sampler, nullptr);
+			});
 	}
 
 	void VKTexture2D::LoadTexture()
@@ -0,0 +1,178 @@
+#include "epch.h"
+#include "Arena.h"
+
+#include "Logger.h"
+
+#include <algorithm>
+#include <new>
+
+namespace Cosmos
+{
+	// rounds a value up to a power of two alignment
+	static inline size_t AlignUp(size_t value, size_t alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	LinearArena::LinearArena(size_t capacity, size_t maxCapacity)
+		: mCapacity(capacity), mMaxCapacity(std::max(capacity, maxCapacity))
+	{
+		if (mCapacity > 0)
+		{
+			mBuffer = (uint8_t*)::operator new(mCapacity, std::align_val_t(alignof(std::max_align_t)));
+		}
+	}
+
+	LinearArena::~LinearArena()
+	{
+		for (Overflow& overflow : mOverflows)
+		{
+			::operator delete(overflow.address, std::align_val_t(overflow.alignment));
+		}
+
+		if (mBuffer != nullptr)
+		{
+			::operator delete(mBuffer, std::align_val_t(alignof(std::max_align_t)));
+		}
+	}
+
+	void* LinearArena::TryAllocate(size_t size, size_t alignment)
+	{
+		// the buffer is aligned to max_align_t, offsets are aligned relative to it
+		size_t offset = AlignUp(mTop, alignment);
+
+		if (offset + size > mCapacity)
+			return nullptr;
+
+		mTop = offset + size;
+		mPeak = std::max(mPeak, mTop + mOverflowBytes);
+
+		return mBuffer + offset;
+	}
+
+	void* LinearArena::Allocate(size_t size, size_t alignment)
+	{
+		void* address = TryAllocate(size, alignment);
+
+		if (address != nullptr)
+			return address;
+
+		// doesn't fit, it's served by the heap until the next reset
+		address = ::operator new(size, std::align_val_t(alignment));
+		mOverflows.push_back({ address, alignment });
+		mOverflowCount++;
+		mOverflowBytes += size;
+		mPeak = std::max(mPeak, mTop + mOverflowBytes);
+
+		return address;
+	}
+
+	void LinearArena::Rewind(size_t marker)
+	{
+		COSMOS_ASSERT(marker <= mTop, "Linear arena can only rewind to a previous marker");
+		mTop = marker;
+	}
+
+	void LinearArena::Reset()
+	{
+		for (Overflow& overflow : mOverflows)
+		{
+			::operator delete(overflow.address, std::align_val_t(overflow.alignment));
+		}
+
+		// the buffer grows once to fit the peak, after that the steady state doesn't touch the heap
+		if (mOverflowBytes > 0 && mCapacity < mMaxCapacity)
+		{
+			size_t capacity = std::min(std::max(mPeak, mCapacity * 2), mMaxCapacity);
+
+			if (mBuffer != nullptr)
+			{
+				::operator delete(mBuffer, std::align_val_t(alignof(std::max_align_t)));
+			}
+
+			mBuffer = (uint8_t*)::operator new(capacity, std::align_val_t(alignof(std::max_align_t)));
+			mCapacity = capacity;
+		}
+
+		mOverflows.clear();
+		mTop = 0;
+		ResetStatistics();
+	}
+
+	void LinearArena::ResetStatistics()
+	{
+		mPeak = mTop;
+		mOverflowCount = 0;
+		mOverflowBytes = 0;
+	}
+
+	// arenas of the calling thread
+	struct ThreadFrameArenas
+	{
+		uint32_t generation = 0;
+		LinearArena* frames[FrameArena::MaxFramesInFlight] = {};
+		uint64_t states[FrameArena::MaxFramesInFlight] = {};	// frame state each arena was last reset on
+	};
+
+	static thread_local ThreadFrameArenas sThreadArenas;
+
+	FrameArena& FrameArena::GetInstance()
+	{
+		static FrameArena instance;
+		return instance;
+	}
+
+	void FrameArena::Initialize(Specification specification)
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+
+		COSMOS_ASSERT(specification.framesInFlight > 0 && specification.framesInFlight <= MaxFramesInFlight, "Invalid amount of frames in flight for the frame arena");
+
+		mSpecification = specification;
+		mFrame = 0;
+		mGeneration++;
+		mThreads.clear();
+	}
+
+	void FrameArena::BeginFrame(uint32_t frame)
+	{
+		// only the thread driving the frames advances them, workers just observe the new state
+		uint64_t serial = (mFrame.load() >> FrameBits) + 1;
+		mFrame.store((serial << FrameBits) | (frame % mSpecification.framesInFlight));
+	}
+
+	LinearArena& FrameArena::Get()
+	{
+		ThreadFrameArenas& local = sThreadArenas;
+
+		// first use on this thread, it's arenas are created and kept for the lifetime of the frame arena
+		if (local.generation != mGeneration)
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+
+			std::unique_ptr<ThreadArenas> arenas = std::make_unique<ThreadArenas>();
+
+			for (uint32_t i = 0; i < mSpecification.framesInFlight; i++)
+			{
+				arenas->frames[i] = std::make_unique<LinearArena>(mSpecification.capacityPerThread, mSpecification.maxCapacityPerThread);
+				local.frames[i] = arenas->frames[i].get();
+				local.states[i] = 0;
+			}
+
+			local.generation = mGeneration;
+			mThreads.push_back(std::move(arenas));
+		}
+
+		// first use of the arena on this frame, what it held belongs to the frame that last used this slot
+		const uint64_t state = mFrame.load();
+		const uint32_t current = (uint32_t)(state & (MaxFramesInFlight - 1));
+
+		if (local.states[current] != state)
+		{
+			local.frames[current]->Reset();
+			local.states[current] = state;
+		}
+
+		return *local.frames[current];
+	}
+}
\ No newline at end of file
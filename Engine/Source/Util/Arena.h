@@ -0,0 +1,189 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Cosmos
+{
+	// allocates by bumping an offset on a pre-allocated buffer, memory is only released all at once
+	class LinearArena
+	{
+	public:
+
+		// constructor
+		LinearArena(size_t capacity = 0, size_t maxCapacity = SIZE_MAX);
+
+		// destructor
+		~LinearArena();
+
+		// not copyable, allocations point into the buffer
+		LinearArena(const LinearArena&) = delete;
+		LinearArena& operator=(const LinearArena&) = delete;
+
+		// returns the size of the pre-allocated buffer
+		inline size_t GetCapacity() const { return mCapacity; }
+
+		// returns how many bytes of the buffer are in use
+		inline size_t GetUsage() const { return mTop; }
+
+		// returns the highest amount of bytes requested since the last reset, including the overflow
+		inline size_t GetPeak() const { return mPeak; }
+
+		// returns how many allocations didn't fit the buffer since the last reset
+		inline uint32_t GetOverflowCount() const { return mOverflowCount; }
+
+		// returns how many bytes were allocated outside the buffer since the last reset
+		inline size_t GetOverflowBytes() const { return mOverflowBytes; }
+
+		// returns the current offset, used to rewind back to it
+		inline size_t GetMarker() const { return mTop; }
+
+		// returns the offset of an address inside the buffer, used as a marker
+		inline size_t GetOffset(const void* address) const { return (size_t)((const uint8_t*)address - mBuffer); }
+
+		// returns if an address is inside the buffer
+		inline bool Owns(const void* address) const { return (const uint8_t*)address >= mBuffer && (const uint8_t*)address < mBuffer + mCapacity; }
+
+	public:
+
+		// allocates from the buffer, nullptr if it doesn't fit
+		void* TryAllocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+		// allocates from the buffer, or from the heap if it doesn't fit
+		void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+		// releases every allocation made after a marker, the overflow is only released on reset
+		void Rewind(size_t marker);
+
+		// releases every allocation, if the buffer overflowed it grows to fit the peak so next time it doesn't
+		void Reset();
+
+		// resets the peak and overflow counters, without releasing the memory
+		void ResetStatistics();
+
+	private:
+
+		struct Overflow
+		{
+			void* address;
+			size_t alignment;
+		};
+
+		uint8_t* mBuffer = nullptr;
+		size_t mCapacity = 0;
+		size_t mMaxCapacity = SIZE_MAX;
+		size_t mTop = 0;
+		size_t mPeak = 0;
+		uint32_t mOverflowCount = 0;
+		size_t mOverflowBytes = 0;
+		std::vector<Overflow> mOverflows = {};
+	};
+
+	// per-thread linear arenas for temporaries that live until the end of the frame, one set per frame in flight
+	// an arena is reset when it's frame comes around again, by it's own thread the first time it uses it on that frame
+	class FrameArena
+	{
+	public:
+
+		static constexpr uint32_t MaxFramesInFlight = 4;
+		static constexpr uint32_t FrameBits = 2;	// bits of the frame in flight on the packed frame state
+		static_assert((1u << FrameBits) == MaxFramesInFlight, "Frames in flight must fill the packed frame bits");
+
+		struct Specification
+		{
+			uint32_t framesInFlight = 2;
+			size_t capacityPerThread = 4 * 1024 * 1024;		// initial buffer size of each thread arena
+			size_t maxCapacityPerThread = 64 * 1024 * 1024;	// arenas grow up to this size, bigger spikes are served by the heap
+		};
+
+	public:
+
+		// returns the frame arena
+		static FrameArena& GetInstance();
+
+		// (re)configures the arenas, must be called before any thread uses them
+		void Initialize(Specification specification);
+
+		// returns the current frame in flight
+		inline uint32_t GetCurrentFrame() const { return (uint32_t)(mFrame.load() & (MaxFramesInFlight - 1)); }
+
+		// starts a new frame, the arenas of the frame in flight being reused are reset as each thread gets to them
+		// tasks still running from the previous frame keep allocating from their arenas, no thread touches another's
+		void BeginFrame(uint32_t frame);
+
+		// returns the arena of the calling thread for the current frame
+		LinearArena& Get();
+
+		// allocates from the arena of the calling thread for the current frame
+		inline void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t)) { return Get().Allocate(size, alignment); }
+
+	private:
+
+		// constructor
+		FrameArena() = default;
+
+		// destructor
+		~FrameArena() = default;
+
+	private:
+
+		struct ThreadArenas
+		{
+			std::unique_ptr<LinearArena> frames[MaxFramesInFlight];
+		};
+
+		Specification mSpecification = {};
+		std::atomic<uint64_t> mFrame = 0;		// frame serial and frame in flight packed together, threads never read one without the other
+		std::atomic<uint32_t> mGeneration = 1;	// changes on every initialization, so threads know their arenas are outdated
+		std::mutex mMutex;
+		std::vector<std::unique_ptr<ThreadArenas>> mThreads = {};
+	};
+
+	// stl allocator that takes memory from a linear arena, deallocation is a no-op
+	template<typename T>
+	class ArenaAllocator
+	{
+	public:
+
+		using value_type = T;
+
+		// constructor, uses the arena of the calling thread for the current frame
+		ArenaAllocator() : mArena(&FrameArena::GetInstance().Get()) {}
+
+		// constructor
+		ArenaAllocator(LinearArena& arena) : mArena(&arena) {}
+
+		// constructor, rebinds from another type
+		template<typename U>
+		ArenaAllocator(const ArenaAllocator<U>& other) : mArena(other.GetArena()) {}
+
+		// returns the arena the memory comes from
+		inline LinearArena* GetArena() const { return mArena; }
+
+		// allocates memory for n elements
+		inline T* allocate(size_t n) { return (T*)mArena->Allocate(n * sizeof(T), alignof(T)); }
+
+		// memory is released when the arena resets
+		inline void deallocate(T*, size_t) {}
+
+		// allocators are equal if they share the arena
+		template<typename U>
+		inline bool operator==(const ArenaAllocator<U>& other) const { return mArena == other.GetArena(); }
+
+		// allocators are equal if they share the arena
+		template<typename U>
+		inline bool operator!=(const ArenaAllocator<U>& other) const { return mArena != other.GetArena(); }
+
+	private:
+
+		LinearArena* mArena;
+	};
+
+	// vector that lives until the end of the frame
+	template<typename T>
+	using FrameVector = std::vector<T, ArenaAllocator<T>>;
+}
\ No newline at end of file
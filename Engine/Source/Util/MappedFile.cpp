@@ -0,0 +1,115 @@
+#include "epch.h"
+#include "MappedFile.h"
+
+#if defined(PLATFORM_WINDOWS)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Cosmos
+{
+	MappedFile::~MappedFile()
+	{
+		Close();
+	}
+
+	bool MappedFile::Open(std::string path)
+	{
+		Close();
+
+#if defined(PLATFORM_WINDOWS)
+		HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+		if (file == INVALID_HANDLE_VALUE)
+			return false;
+
+		LARGE_INTEGER size = {};
+
+		if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+		{
+			CloseHandle(file);
+			return false;
+		}
+
+		HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+		if (mapping == nullptr)
+		{
+			CloseHandle(file);
+			return false;
+		}
+
+		void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+
+		if (data == nullptr)
+		{
+			CloseHandle(mapping);
+			CloseHandle(file);
+			return false;
+		}
+
+		mFile = file;
+		mMapping = mapping;
+		mData = (const uint8_t*)data;
+		mSize = (size_t)size.QuadPart;
+#else
+		int file = open(path.c_str(), O_RDONLY);
+
+		if (file < 0)
+			return false;
+
+		struct stat status = {};
+
+		if (fstat(file, &status) != 0 || status.st_size == 0)
+		{
+			close(file);
+			return false;
+		}
+
+		void* data = mmap(nullptr, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+
+		if (data == MAP_FAILED)
+		{
+			close(file);
+			return false;
+		}
+
+		// the file is read front to back once, read-ahead keeps the disk busy
+		madvise(data, (size_t)status.st_size, MADV_SEQUENTIAL);
+		madvise(data, (size_t)status.st_size, MADV_WILLNEED);
+
+		mFile = file;
+		mData = (const uint8_t*)data;
+		mSize = (size_t)status.st_size;
+#endif
+
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+		if (mData == nullptr)
+			return;
+
+#if defined(PLATFORM_WINDOWS)
+		UnmapViewOfFile(mData);
+		CloseHandle(mMapping);
+		CloseHandle(mFile);
+		mMapping = nullptr;
+		mFile = nullptr;
+#else
+		munmap((void*)mData, mSize);
+		close(mFile);
+		mFile = -1;
+#endif
+
+		mData = nullptr;
+		mSize = 0;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "Platform/Detection.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace Cosmos
+{
+	// read-only memory mapping of a whole file, pages are brought in by the os as they're touched
+	class MappedFile
+	{
+	public:
+
+		// constructor
+		MappedFile() = default;
+
+		// destructor
+		~MappedFile();
+
+		// not copyable, the mapping is released on destruction
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		// returns if a file is mapped
+		inline bool IsOpen() const { return mData != nullptr; }
+
+		// returns the start of the mapped file
+		inline const uint8_t* GetData() const { return mData; }
+
+		// returns the size of the mapped file
+		inline size_t GetSize() const { return mSize; }
+
+	public:
+
+		// maps a file, hinting the os it's going to be read sequentially
+		bool Open(std::string path);
+
+		// unmaps the file
+		void Close();
+
+	private:
+
+		const uint8_t* mData = nullptr;
+		size_t mSize = 0;
+
+#if defined(PLATFORM_WINDOWS)
+		void* mFile = nullptr;
+		void* mMapping = nullptr;
+#else
+		int mFile = -1;
+#endif
+	};
+}
\ No newline at end of file
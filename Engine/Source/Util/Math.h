@@ -24,8 +24,45 @@
 #pragma warning(pop)
 #endif
 
+// sse is part of every x86-64 target
+#if defined(__SSE__) || defined(_M_X64) || defined(_M_AMD64)
+#define COSMOS_SIMD_SSE
+#include <xmmintrin.h>
+#endif
+
+// sse2 integer conversions, also part of every x86-64 target
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define COSMOS_SIMD_SSE2
+#include <emmintrin.h>
+#endif
+
 namespace Cosmos
 {
 	// decomposes a model matrix to translations, rotation and scale components
 	bool Decompose(const glm::mat4& transform, glm::vec3& translation, glm::vec3& rotation, glm::vec3& scale);
+
+	// returns a * b, every column is computed four floats at a time where sse is available
+	inline glm::mat4 MultiplySIMD(const glm::mat4& a, const glm::mat4& b)
+	{
+#if defined COSMOS_SIMD_SSE
+		const __m128 a0 = _mm_loadu_ps(&a[0][0]);
+		const __m128 a1 = _mm_loadu_ps(&a[1][0]);
+		const __m128 a2 = _mm_loadu_ps(&a[2][0]);
+		const __m128 a3 = _mm_loadu_ps(&a[3][0]);
+		glm::mat4 result;
+
+		for (int i = 0; i < 4; i++)
+		{
+			__m128 column = _mm_mul_ps(a0, _mm_set1_ps(b[i][0]));
+			column = _mm_add_ps(column, _mm_mul_ps(a1, _mm_set1_ps(b[i][1])));
+			column = _mm_add_ps(column, _mm_mul_ps(a2, _mm_set1_ps(b[i][2])));
+			column = _mm_add_ps(column, _mm_mul_ps(a3, _mm_set1_ps(b[i][3])));
+			_mm_storeu_ps(&result[i][0], column);
+		}
+
+		return result;
+#else
+		return a * b;
+#endif
+	}
 }
\ No newline at end of file
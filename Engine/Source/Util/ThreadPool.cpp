@@ -0,0 +1,133 @@
+#include "epch.h"
+#include "ThreadPool.h"
+
+#include "Memory.h"
+
+#include <algorithm>
+
+namespace Cosmos
+{
+	ThreadPool& ThreadPool::GetInstance()
+	{
+		static ThreadPool instance;
+		return instance;
+	}
+
+	ThreadPool::ThreadPool()
+	{
+		// one core is left for the main thread
+		uint32_t count = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+
+		for (uint32_t i = 0; i < count; i++)
+		{
+			mThreads.emplace_back([this]() { WorkerLoop(); });
+		}
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mStop = true;
+		}
+
+		mCondition.notify_all();
+
+		for (std::thread& thread : mThreads)
+		{
+			thread.join();
+		}
+	}
+
+	std::future<void> ThreadPool::Enqueue(std::function<void()> task)
+	{
+		// packaged tasks are move-only, std::function requires the callable to be copyable
+		Shared<std::packaged_task<void()>> packaged = CreateShared<std::packaged_task<void()>>(std::move(task));
+		std::future<void> future = packaged->get_future();
+
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mTasks.push([packaged]() { (*packaged)(); });
+		}
+
+		mCondition.notify_one();
+		return future;
+	}
+
+	void ThreadPool::ParallelFor(uint32_t count, std::function<void(uint32_t)> function)
+	{
+		if (count == 0)
+			return;
+
+		// helpers may still be queued after the call returns, the state is kept alive by them
+		struct State
+		{
+			std::function<void(uint32_t)> function;
+			uint32_t count = 0;
+			std::atomic<uint32_t> next = 0;
+			std::atomic<uint32_t> finished = 0;
+			std::mutex mutex;
+			std::condition_variable condition;
+		};
+
+		Shared<State> state = CreateShared<State>();
+		state->function = std::move(function);
+		state->count = count;
+
+		auto work = [](State& state)
+		{
+			uint32_t index;
+			while ((index = state.next.fetch_add(1)) < state.count)
+			{
+				state.function(index);
+
+				if (state.finished.fetch_add(1) + 1 == state.count)
+				{
+					std::unique_lock<std::mutex> lock(state.mutex);
+					state.condition.notify_all();
+				}
+			}
+		};
+
+		uint32_t helpers = std::min(count - 1, GetThreadCount());
+
+		if (helpers > 0)
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+
+			for (uint32_t i = 0; i < helpers; i++)
+			{
+				mTasks.push([state, work]() { work(*state); });
+			}
+		}
+
+		mCondition.notify_all();
+
+		// the caller works as well, so it progresses even if every worker is busy
+		work(*state);
+
+		std::unique_lock<std::mutex> lock(state->mutex);
+		state->condition.wait(lock, [&state]() { return state->finished.load() == state->count; });
+	}
+
+	void ThreadPool::WorkerLoop()
+	{
+		while (true)
+		{
+			std::function<void()> task;
+
+			{
+				std::unique_lock<std::mutex> lock(mMutex);
+				mCondition.wait(lock, [this]() { return mStop || !mTasks.empty(); });
+
+				if (mStop && mTasks.empty())
+					return;
+
+				task = std::move(mTasks.front());
+				mTasks.pop();
+			}
+
+			task();
+		}
+	}
+}
\ No newline at end of file
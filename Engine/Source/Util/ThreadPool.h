@@ -0,0 +1,58 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace Cosmos
+{
+	// fixed amount of worker threads running background tasks, like asset loading
+	class ThreadPool
+	{
+	public:
+
+		// returns the thread pool, workers are started on first use
+		static ThreadPool& GetInstance();
+
+		// not copyable, workers reference the pool
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		// returns how many worker threads the pool has
+		inline uint32_t GetThreadCount() const { return (uint32_t)mThreads.size(); }
+
+	public:
+
+		// queues a task to run on a worker, the future is ready once it finished
+		std::future<void> Enqueue(std::function<void()> task);
+
+		// runs a function for every index in [0, count) spread across the workers, returns once all finished
+		// the calling thread also processes indices, so it's safe to call from inside a task
+		void ParallelFor(uint32_t count, std::function<void(uint32_t)> function);
+
+	private:
+
+		// constructor
+		ThreadPool();
+
+		// destructor
+		~ThreadPool();
+
+		// waits for tasks and runs them until the pool is destroyed
+		void WorkerLoop();
+
+	private:
+
+		std::vector<std::thread> mThreads = {};
+		std::queue<std::function<void()>> mTasks = {};
+		std::mutex mMutex;
+		std::condition_variable mCondition;
+		bool mStop = false;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,53 @@
+-- windows premake5 script
+project "Benchmark"
+    location "%{wks.location}/Benchmark"
+    kind "ConsoleApp"
+    staticruntime "On"
+    language "C++"
+    cppdialect "C++17"
+
+    targetdir(dir)
+    objdir(obj)
+
+    files
+    {
+        "%{includes.Benchmark}/**.h",
+        "%{includes.Benchmark}/**.cpp"
+    }
+    
+    includedirs
+    {
+        "%{includes.Benchmark}",
+        "%{includes.Engine}",
+        "%{includes.GLM}",
+
+        "%{wks.location}/Thirdparty/jolt"   -- Physics library
+    }
+
+    links
+    {
+        "Renderer",
+        "ImGui",
+        "Engine"
+    }
+
+    defines
+    { 
+        "_NO_CRT_STDIO_INLINE", 
+        "JPH_DEBUG_RENDERER"
+    }
+    
+    filter "configurations:Debug"
+        defines { "BENCHMARK_DEBUG" }
+        runtime "Debug"
+        symbols "On"
+
+        defines
+        {
+            "_CRT_SECURE_NO_WARNINGS"
+        }
+
+    filter "configurations:Release"
+        defines { "BENCHMARK_RELEASE" }
+        runtime "Release"
+        optimize "On"
\ No newline at end of file
@@ -14,6 +14,7 @@ includes = {}
 includes["Renderer"]  = "%{wks.location}/Renderer/Source"
 includes["Engine"]  = "%{wks.location}/Engine/Source"
 includes["Editor"]  = "%{wks.location}/Editor/Source"
+includes["Benchmark"]  = "%{wks.location}/Benchmark/Source"
 --
 includes["Vulkan"]  = os.getenv("VULKAN_SDK") .. "/Include"
 includes["Volk"]    = "%{wks.location}/Thirdparty/volk"
@@ -38,4 +39,5 @@ if os.host() == "windows" then
     include "Scripts/Build/windows_renderer.lua"
     include "Scripts/Build/windows_engine.lua"
     include "Scripts/Build/windows_editor.lua"
+    include "Scripts/Build/windows_benchmark.lua"
 end
\ No newline at end of file